@@ -268,9 +268,10 @@ fn updateStats() error{OutOfMemory}!void {
     };
     const total_src_locs = coverage_source_locations.items.len;
 
+    // Combined across all fuzzing processes, since they share the run counter.
     const avg_speed: f64 = speed: {
         const ns_elapsed: f64 = @floatFromInt(nsSince(start_fuzzing_timestamp));
-        const n_runs: f64 = @floatFromInt(hdr.n_runs);
+        const n_runs: f64 = @floatFromInt(hdr.n_runs -| hdr.start_n_runs);
         break :speed n_runs / (ns_elapsed / std.time.ns_per_s);
     };
 
@@ -279,6 +280,7 @@ fn updateStats() error{OutOfMemory}!void {
         \\<span slot="stat-unique-runs">{d} ({d:.1}%)</span>
         \\<span slot="stat-coverage">{d} / {d} ({d:.1}%)</span>
         \\<span slot="stat-speed">{d:.0}</span>
+        \\<span slot="stat-processes">{d}</span>
     , .{
         hdr.n_runs,
         hdr.unique_runs,
@@ -287,6 +289,7 @@ fn updateStats() error{OutOfMemory}!void {
         total_src_locs,
         @as(f64, @floatFromInt(covered_src_locs)) / @as(f64, @floatFromInt(total_src_locs)),
         avg_speed,
+        hdr.processes,
     });
     defer gpa.free(html);
 
@@ -116,6 +116,8 @@ pub fn main() !void {
     var summary: ?Summary = null;
     var max_rss: u64 = 0;
     var skip_oom_steps = false;
+    var cache_gc: ?u64 = null;
+    var trace_path: ?[]const u8 = null;
     var test_timeout_ns: ?u64 = null;
     var color: Color = .auto;
     var help_menu = false;
@@ -197,6 +199,26 @@ pub fn main() !void {
                 };
             } else if (mem.eql(u8, arg, "--skip-oom-steps")) {
                 skip_oom_steps = true;
+            } else if (mem.startsWith(u8, arg, "--cache-gc=")) {
+                const size_text = arg["--cache-gc=".len..];
+                cache_gc = std.fmt.parseIntSizeSuffix(size_text, 10) catch |err| {
+                    std.debug.print("invalid byte size: '{s}': {s}\n", .{
+                        size_text, @errorName(err),
+                    });
+                    process.exit(1);
+                };
+            } else if (mem.eql(u8, arg, "--rerun-failed")) {
+                graph.rerun_failed_tests = true;
+            } else if (mem.eql(u8, arg, "--test-jobs")) {
+                const num = nextArgOrFatal(args, &arg_idx);
+                graph.test_jobs = std.fmt.parseUnsigned(u32, num, 10) catch |err| {
+                    fatal("unable to parse test jobs count '{s}': {t}", .{ num, err });
+                };
+                if (graph.test_jobs < 1) fatal("number of test jobs must be at least 1", .{});
+            } else if (mem.startsWith(u8, arg, "--test-shard=")) {
+                const text = arg["--test-shard=".len..];
+                graph.test_shard = Step.Run.TestShard.parse(text) catch
+                    fatalWithHint("invalid test shard '{s}': expected <index>/<count> with 1 <= index <= count", .{text});
             } else if (mem.eql(u8, arg, "--test-timeout")) {
                 const units: []const struct { []const u8, u64 } = &.{
                     .{ "ns", 1 },
@@ -337,10 +359,17 @@ pub fn main() !void {
                 watch = true;
             } else if (mem.eql(u8, arg, "--time-report")) {
                 graph.time_report = true;
-                if (webui_listen == null) webui_listen = .{ .ip6 = .loopback(0) };
+            } else if (mem.startsWith(u8, arg, "--trace=")) {
+                trace_path = arg["--trace=".len..];
             } else if (mem.eql(u8, arg, "--fuzz")) {
                 fuzz = .{ .forever = undefined };
                 if (webui_listen == null) webui_listen = .{ .ip6 = .loopback(0) };
+            } else if (mem.eql(u8, arg, "--fuzz-cmin")) {
+                fuzz = .{ .minimize = .{ .merge_dir = null } };
+            } else if (mem.startsWith(u8, arg, "--fuzz-merge=")) {
+                const merge_dir = arg["--fuzz-merge=".len..];
+                if (merge_dir.len == 0) fatal("missing argument to --fuzz-merge", .{});
+                fuzz = .{ .minimize = .{ .merge_dir = merge_dir } };
             } else if (mem.startsWith(u8, arg, "--fuzz=")) {
                 const value = arg["--fuzz=".len..];
                 if (value.len == 0) fatal("missing argument to --fuzz", .{});
@@ -437,9 +466,15 @@ pub fn main() !void {
         }
     }
 
+    // With '--trace', the time reports go into the trace file instead.
+    if (graph.time_report and trace_path == null and webui_listen == null) {
+        webui_listen = .{ .ip6 = .loopback(0) };
+    }
+
     if (webui_listen != null) {
         if (watch) fatal("using '--webui' and '--watch' together is not yet supported; consider omitting '--watch' in favour of the web UI \"Rebuild\" button", .{});
         if (builtin.single_threaded) fatal("'--webui' is not yet supported on single-threaded hosts", .{});
+        if (fuzz) |mode| if (mode == .minimize) fatal("using '--webui' with '--fuzz-cmin' or '--fuzz-merge' is not supported", .{});
     }
 
     const ttyconf = color.detectTtyConf();
@@ -449,6 +484,31 @@ pub fn main() !void {
         .windows_api => {},
     }
 
+    // Steps take a job slot from the jobserver of the make invoking this build, if any;
+    // otherwise this process becomes the jobserver, so that the compiler and any make run
+    // by a step share the `-j` limit with the build runner instead of each using every core.
+    var jobserver: ?std.process.Jobserver = js: {
+        const makeflags = graph.env_map.get("MAKEFLAGS");
+        if (makeflags) |value| {
+            if (std.process.Jobserver.initClient(value)) |js| break :js js;
+        }
+        if (!std.process.Jobserver.is_supported) break :js null;
+        const slot_count = thread_pool_options.n_jobs orelse std.Thread.getCpuCount() catch 1;
+        var js = std.process.Jobserver.initServer(slot_count) catch |err| {
+            std.log.warn("unable to create jobserver: {t}", .{err});
+            break :js null;
+        };
+        var buf: [64]u8 = undefined;
+        const auth = try js.makeflags(slot_count, &buf);
+        try graph.env_map.put("MAKEFLAGS", if (makeflags) |value|
+            try std.fmt.allocPrint(arena, "{s} {s}", .{ value, auth })
+        else
+            auth);
+        break :js js;
+    };
+    defer if (jobserver) |*js| js.deinit();
+    thread_pool_options.jobserver = if (jobserver) |*js| js else null;
+
     const main_progress_node = std.Progress.start(.{
         .disable_printing = (color == .off),
     });
@@ -511,11 +571,18 @@ pub fn main() !void {
         .max_rss_mutex = .{},
         .skip_oom_steps = skip_oom_steps,
         .unit_test_timeout_ns = test_timeout_ns,
+        .cache_gc = cache_gc,
+        .trace_path = trace_path,
 
         .watch = watch,
         .web_server = undefined, // set after `prepare`
         .memory_blocked_steps = .empty,
         .step_stack = .empty,
+        .step_info = &.{},
+        .step_durations = .empty,
+        .ready_steps = .init(gpa, {}),
+        .ready_mutex = .{},
+        .ready_seq = 0,
 
         .claimed_rss = 0,
         .error_style = error_style,
@@ -528,6 +595,8 @@ pub fn main() !void {
     defer {
         run.memory_blocked_steps.deinit(gpa);
         run.step_stack.deinit(gpa);
+        run.step_durations.deinit(gpa);
+        run.ready_steps.deinit();
     }
 
     if (run.max_rss == 0) {
@@ -555,6 +624,23 @@ pub fn main() !void {
     try run.thread_pool.init(thread_pool_options);
     defer run.thread_pool.deinit();
 
+    // Steps may block on each other's cache manifest locks, so the cache gets
+    // a pool of its own for re-hashing input files while holding one.
+    var rehash_pool: std.Thread.Pool = undefined;
+    try rehash_pool.init(.{ .allocator = arena, .n_jobs = thread_pool_options.n_jobs });
+    defer rehash_pool.deinit();
+    graph.cache.thread_pool = &rehash_pool;
+
+    // In watch mode, each step keeps its own compiler process instead.
+    var zig_process_pool: Step.ZigProcessPool = .{};
+    if (!watch) graph.zig_process_pool = &zig_process_pool;
+
+    var trace: std.Build.Trace = undefined;
+    if (trace_path != null) {
+        trace = std.Build.Trace.init(gpa, io) catch |err| fatal("unable to start trace: {t}", .{err});
+        graph.trace = &trace;
+    }
+
     const now = Io.Clock.Timestamp.now(io, .awake) catch |err| fatal("failed to collect timestamp: {t}", .{err});
 
     run.web_server = if (webui_listen) |listen_address| ws: {
@@ -592,7 +678,7 @@ pub fn main() !void {
         );
 
         if (run.web_server) |*web_server| {
-            if (fuzz) |mode| if (mode != .forever) fatal(
+            if (fuzz) |mode| if (mode == .limit) fatal(
                 "error: limited fuzzing is not implemented yet for --webui",
                 .{},
             );
@@ -646,6 +732,79 @@ pub fn main() !void {
     }
 }
 
+fn collectCacheGarbage(b: *std.Build, max_bytes: u64, parent_prog_node: std.Progress.Node) void {
+    const prog_node = parent_prog_node.start("Collect Cache Garbage", 0);
+    defer prog_node.end();
+
+    const graph = b.graph;
+    for ([_]std.Build.Cache.Directory{ b.cache_root, graph.global_cache_root }) |cache_root| {
+        const result = std.Build.Cache.gcIfDue(b.allocator, graph.io, cache_root.handle, max_bytes) catch |err| {
+            std.log.warn("unable to collect garbage in cache directory '{f}': {t}", .{ cache_root, err });
+            continue;
+        } orelse continue;
+        if (result.bytes_after > max_bytes) std.log.warn(
+            "cache directory '{f}' is {Bi:.1} after evicting {d} entries; the remainder is in use",
+            .{ cache_root, result.bytes_after, result.evicted_count },
+        );
+    }
+}
+
+/// Computes `StepInfo.critical_path_ns` for `s` and, recursively, its dependants.
+fn estimateCriticalPath(run: *Run, s: *Step) u64 {
+    const info = run.stepInfo(s);
+    if (info.critical_path_ns != std.math.maxInt(u64)) return info.critical_path_ns;
+    var dependants_ns: u64 = 0;
+    for (s.dependants.items) |dependant| {
+        dependants_ns = @max(dependants_ns, estimateCriticalPath(run, dependant));
+    }
+    // Steps that have never run count as instant; at worst they are started in
+    // dependency order, as they would be without any history.
+    info.critical_path_ns = (run.step_durations.get(info.key) orelse 0) +| dependants_ns;
+    return info.critical_path_ns;
+}
+
+/// Failure to read the file only costs scheduling quality, so it is ignored.
+fn loadStepDurations(arena: Allocator, b: *std.Build, run: *Run) void {
+    const contents = b.cache_root.handle.readFileAlloc(step_durations_basename, arena, .limited(16 * 1024 * 1024)) catch return;
+    var it = mem.splitScalar(u8, contents, '\n');
+    while (it.next()) |line| {
+        const space = mem.indexOfScalar(u8, line, ' ') orelse continue;
+        const ns = fmt.parseInt(u64, line[0..space], 10) catch continue;
+        run.step_durations.put(run.gpa, line[space + 1 ..], ns) catch return;
+    }
+}
+
+/// Records the durations of the steps which ran to completion in this run,
+/// keeping those of steps outside of it. Failure is only worth a warning.
+fn saveStepDurations(b: *std.Build, run: *Run) void {
+    var any_changes = false;
+    for (run.step_info, run.step_stack.keys()) |info, s| {
+        const ns = info.duration_ns orelse continue;
+        // A cache hit says nothing about how long the step takes when it has work to do.
+        if (s.state != .success or s.result_cached) continue;
+        if (mem.indexOfScalar(u8, info.key, '\n') != null) continue;
+        run.step_durations.put(run.gpa, info.key, ns) catch return;
+        any_changes = true;
+    }
+    if (!any_changes) return;
+
+    writeStepDurations(b, run) catch |err| {
+        std.log.warn("unable to save step durations in '{f}': {t}", .{ b.cache_root, err });
+    };
+}
+
+fn writeStepDurations(b: *std.Build, run: *Run) !void {
+    var buffer: [4096]u8 = undefined;
+    var af = try b.cache_root.handle.atomicFile(step_durations_basename, .{ .write_buffer = &buffer });
+    defer af.deinit();
+    const w = &af.file_writer.interface;
+    var it = run.step_durations.iterator();
+    while (it.next()) |entry| {
+        w.print("{d} {s}\n", .{ entry.value_ptr.*, entry.key_ptr.* }) catch return af.file_writer.err.?;
+    }
+    try af.finish();
+}
+
 fn markFailedStepsDirty(gpa: Allocator, all_steps: []const *Step) void {
     for (all_steps) |step| switch (step.state) {
         .dependency_failure, .failure, .skipped => step.recursiveReset(gpa),
@@ -674,12 +833,28 @@ const Run = struct {
     max_rss_mutex: std.Thread.Mutex,
     skip_oom_steps: bool,
     unit_test_timeout_ns: ?u64,
+    /// Size limit for the local and global cache directories, enforced after a build at most
+    /// once per `std.Build.Cache.gc_interval`.
+    cache_gc: ?u64,
+    /// Where to write the timeline of each build, from `--trace`.
+    trace_path: ?[]const u8,
     watch: bool,
     web_server: if (!builtin.single_threaded) ?WebServer else ?noreturn,
     /// Allocated into `gpa`.
     memory_blocked_steps: std.ArrayListUnmanaged(*Step),
     /// Allocated into `gpa`.
     step_stack: std.AutoArrayHashMapUnmanaged(*Step, void),
+    /// Parallel to `step_stack`. Allocated into the arena.
+    step_info: []StepInfo,
+    /// How long each step took the last time it ran to completion without a cache hit, keyed by
+    /// `StepInfo.key`. Loaded from, and saved to, `step_durations_basename` in the local cache.
+    /// Keys are allocated into the arena; the map itself into `gpa`.
+    step_durations: std.StringHashMapUnmanaged(u64),
+    /// Steps that may be ready to run. See `scheduleStep`.
+    ready_steps: std.PriorityQueue(ReadyStep, void, ReadyStep.compare),
+    ready_mutex: std.Thread.Mutex,
+    /// Breaks ties between `ready_steps` in favor of the step queued first.
+    ready_seq: u64,
     thread_pool: std.Thread.Pool,
     /// Similar to the `tty.Config` returned by `std.debug.lockStderrWriter`,
     /// but also respects the '--color' flag.
@@ -689,8 +864,38 @@ const Run = struct {
     error_style: ErrorStyle,
     multiline_errors: MultilineErrors,
     summary: Summary,
+
+    fn stepInfo(run: *Run, s: *Step) *StepInfo {
+        return &run.step_info[run.step_stack.getIndex(s).?];
+    }
+};
+
+const StepInfo = struct {
+    /// Identifies the step across builds. See `Step.key`.
+    key: []const u8,
+    /// Estimated time from the start of this step until all of its dependants have finished,
+    /// based on `Run.step_durations`. Steps with a longer remaining path are started first.
+    critical_path_ns: u64,
+    /// Time spent in `make` during the current run, or `null` if the step was not run.
+    duration_ns: ?u64,
+};
+
+const ReadyStep = struct {
+    step: *Step,
+    critical_path_ns: u64,
+    seq: u64,
+
+    fn compare(_: void, a: ReadyStep, b: ReadyStep) std.math.Order {
+        return switch (std.math.order(b.critical_path_ns, a.critical_path_ns)) {
+            .eq => std.math.order(a.seq, b.seq),
+            else => |order| order,
+        };
+    }
 };
 
+/// Each line holds a duration in nanoseconds, a space, and a `StepInfo.key`.
+const step_durations_basename = "step-durations";
+
 fn prepare(
     arena: Allocator,
     b: *std.Build,
@@ -725,6 +930,14 @@ fn prepare(
         try constructGraphAndCheckForDependencyLoop(gpa, b, s, &run.step_stack, rand);
     }
 
+    run.step_info = try arena.alloc(StepInfo, step_stack.count());
+    for (run.step_info, step_stack.keys()) |*info, s| info.* = .{
+        .key = s.key,
+        .critical_path_ns = 0,
+        .duration_ns = null,
+    };
+    loadStepDurations(arena, b, run);
+
     {
         // Check that we have enough memory to complete the build.
         var any_problems = false;
@@ -761,27 +974,48 @@ fn runStepNames(
     const step_stack = &run.step_stack;
     const thread_pool = &run.thread_pool;
 
+    if (b.graph.trace) |trace| trace.reset();
+
     {
         const step_prog = parent_prog_node.start("steps", step_stack.count());
         defer step_prog.end();
 
         var wait_group: std.Thread.WaitGroup = .{};
-        defer wait_group.wait();
-
-        // Here we spawn the initial set of tasks with a nice heuristic -
-        // dependency order. Each worker when it finishes a step will then
-        // check whether it should run any dependants.
-        const steps_slice = step_stack.keys();
-        for (0..steps_slice.len) |i| {
-            const step = steps_slice[steps_slice.len - i - 1];
-            if (step.state == .skipped_oom) continue;
-
-            thread_pool.spawnWg(&wait_group, workerMakeOneStep, .{
-                &wait_group, b, step, step_prog, run,
+        defer thread_pool.wait(&wait_group);
+
+        for (run.step_info) |*info| {
+            info.critical_path_ns = std.math.maxInt(u64);
+            info.duration_ns = null;
+        }
+        for (step_stack.keys()) |step| _ = estimateCriticalPath(run, step);
+
+        // Here we queue the initial set of tasks in dependency order. Workers
+        // pick the queued step with the longest estimated critical path first,
+        // and when they finish a step, queue up its dependants. All of them are
+        // queued before any worker starts, so that the first picks are not
+        // limited to whichever steps happened to be queued first.
+        var queued_count: usize = 0;
+        {
+            run.ready_mutex.lock();
+            defer run.ready_mutex.unlock();
+            const steps_slice = step_stack.keys();
+            for (0..steps_slice.len) |i| {
+                const step = steps_slice[steps_slice.len - i - 1];
+                if (step.state == .skipped_oom) continue;
+
+                queueReadyStep(run, step);
+                queued_count += 1;
+            }
+        }
+        for (0..queued_count) |_| {
+            thread_pool.spawnWg(&wait_group, workerMakeReadyStep, .{
+                &wait_group, b, step_prog, run,
             });
         }
     }
 
+    saveStepDurations(b, run);
+
     assert(run.memory_blocked_steps.items.len == 0);
 
     var test_pass_count: usize = 0;
@@ -853,10 +1087,9 @@ fn runStepNames(
 
         switch (mode) {
             .forever => break :blk,
-            .limit => {},
+            .limit, .minimize => {},
         }
 
-        assert(mode == .limit);
         var f = std.Build.Fuzz.init(
             gpa,
             io,
@@ -869,7 +1102,11 @@ fn runStepNames(
         defer f.deinit();
 
         f.start();
-        f.waitAndPrintReport();
+        switch (mode) {
+            .forever => unreachable,
+            .limit => f.waitAndPrintReport(),
+            .minimize => f.waitAndMinimizeCorpora(),
+        }
     }
 
     // Every test has a state
@@ -971,8 +1208,17 @@ fn runStepNames(
             }
         }
         w.writeByte('\n') catch {};
+
+        switch (run.summary) {
+            .all, .new => printCriticalPath(gpa, run, w, ttyconf) catch {},
+            .failures, .line, .none => {},
+        }
     }
 
+    if (run.cache_gc) |max_bytes| collectCacheGarbage(b, max_bytes, parent_prog_node);
+
+    if (b.graph.trace) |trace| trace.save(run.trace_path.?);
+
     if (run.watch or run.web_server != null) return;
 
     // Perhaps in the future there could be an Advanced Options flag such as
@@ -984,6 +1230,7 @@ fn runStepNames(
         if (run.error_style.verboseContext()) break :code 1; // failure; print build command
         break :code 2; // failure; do not print build command
     };
+    if (b.graph.zig_process_pool) |pool| pool.deinit(gpa);
     std.debug.lockStdErr();
     process.exit(code);
 }
@@ -1054,17 +1301,7 @@ fn printStepStatus(
             try ttyconf.setColor(stderr, .reset);
             if (s.result_duration_ns) |ns| {
                 try ttyconf.setColor(stderr, .dim);
-                if (ns >= std.time.ns_per_min) {
-                    try stderr.print(" {d}m", .{ns / std.time.ns_per_min});
-                } else if (ns >= std.time.ns_per_s) {
-                    try stderr.print(" {d}s", .{ns / std.time.ns_per_s});
-                } else if (ns >= std.time.ns_per_ms) {
-                    try stderr.print(" {d}ms", .{ns / std.time.ns_per_ms});
-                } else if (ns >= std.time.ns_per_us) {
-                    try stderr.print(" {d}us", .{ns / std.time.ns_per_us});
-                } else {
-                    try stderr.print(" {d}ns", .{ns});
-                }
+                try printDuration(stderr, ns);
                 try ttyconf.setColor(stderr, .reset);
             }
             if (s.result_peak_rss != 0) {
@@ -1102,6 +1339,84 @@ fn printStepStatus(
     }
 }
 
+fn printDuration(stderr: *Writer, ns: u64) !void {
+    if (ns >= std.time.ns_per_min) {
+        try stderr.print(" {d}m", .{ns / std.time.ns_per_min});
+    } else if (ns >= std.time.ns_per_s) {
+        try stderr.print(" {d}s", .{ns / std.time.ns_per_s});
+    } else if (ns >= std.time.ns_per_ms) {
+        try stderr.print(" {d}ms", .{ns / std.time.ns_per_ms});
+    } else if (ns >= std.time.ns_per_us) {
+        try stderr.print(" {d}us", .{ns / std.time.ns_per_us});
+    } else {
+        try stderr.print(" {d}ns", .{ns});
+    }
+}
+
+/// Prints the chain of dependencies which took the longest to run, ending at
+/// the step which finished last had there been an unlimited number of workers.
+fn printCriticalPath(gpa: Allocator, run: *Run, stderr: *Writer, ttyconf: tty.Config) !void {
+    const steps = run.step_stack.keys();
+    // For each step, the time spent in it and its slowest chain of dependencies.
+    const path_ns = try gpa.alloc(u64, steps.len);
+    defer gpa.free(path_ns);
+    @memset(path_ns, std.math.maxInt(u64));
+    var last: ?*Step = null;
+    var total_ns: u64 = 0;
+    for (steps) |s| {
+        const ns = criticalPathTo(run, s, path_ns);
+        if (ns > total_ns) {
+            total_ns = ns;
+            last = s;
+        }
+    }
+    if (last == null) return;
+
+    var path: std.ArrayListUnmanaged(*Step) = .empty;
+    defer path.deinit(gpa);
+    var it = last;
+    while (it) |s| {
+        try path.append(gpa, s);
+        it = null;
+        var slowest_ns: u64 = 0;
+        for (s.dependencies.items) |dep| {
+            const dep_ns = path_ns[run.step_stack.getIndex(dep).?];
+            if (dep_ns > slowest_ns) {
+                slowest_ns = dep_ns;
+                it = dep;
+            }
+        }
+    }
+
+    try ttyconf.setColor(stderr, .cyan);
+    try ttyconf.setColor(stderr, .bold);
+    try stderr.writeAll("Critical Path:");
+    try ttyconf.setColor(stderr, .reset);
+    try printDuration(stderr, total_ns);
+    try stderr.writeByte('\n');
+    var i = path.items.len;
+    while (i > 0) {
+        i -= 1;
+        const s = path.items[i];
+        try stderr.print("  {s}{s}", .{ s.owner.dep_prefix, s.name });
+        try ttyconf.setColor(stderr, .dim);
+        try printDuration(stderr, run.stepInfo(s).duration_ns orelse 0);
+        try ttyconf.setColor(stderr, .reset);
+        try stderr.writeByte('\n');
+    }
+}
+
+fn criticalPathTo(run: *Run, s: *Step, path_ns: []u64) u64 {
+    const index = run.step_stack.getIndex(s).?;
+    if (path_ns[index] != std.math.maxInt(u64)) return path_ns[index];
+    var dependencies_ns: u64 = 0;
+    for (s.dependencies.items) |dep| {
+        dependencies_ns = @max(dependencies_ns, criticalPathTo(run, dep, path_ns));
+    }
+    path_ns[index] = (run.step_info[index].duration_ns orelse 0) + dependencies_ns;
+    return path_ns[index];
+}
+
 fn printStepFailure(
     s: *Step,
     stderr: *Writer,
@@ -1322,6 +1637,50 @@ fn constructGraphAndCheckForDependencyLoop(
     }
 }
 
+/// Queues `s` to be considered by a worker. The worker does not necessarily
+/// take `s`, but whichever queued step has the longest estimated critical
+/// path, so that long chains of steps are not started late behind many short
+/// steps that happened to be queued first.
+fn scheduleStep(
+    wg: *std.Thread.WaitGroup,
+    b: *std.Build,
+    s: *Step,
+    prog_node: std.Progress.Node,
+    run: *Run,
+) void {
+    {
+        run.ready_mutex.lock();
+        defer run.ready_mutex.unlock();
+        queueReadyStep(run, s);
+    }
+    run.thread_pool.spawnWg(wg, workerMakeReadyStep, .{ wg, b, prog_node, run });
+}
+
+/// Asserts that `run.ready_mutex` is held.
+fn queueReadyStep(run: *Run, s: *Step) void {
+    run.ready_steps.add(.{
+        .step = s,
+        .critical_path_ns = run.stepInfo(s).critical_path_ns,
+        .seq = run.ready_seq,
+    }) catch @panic("OOM");
+    run.ready_seq += 1;
+}
+
+fn workerMakeReadyStep(
+    wg: *std.Thread.WaitGroup,
+    b: *std.Build,
+    prog_node: std.Progress.Node,
+    run: *Run,
+) void {
+    const s = s: {
+        run.ready_mutex.lock();
+        defer run.ready_mutex.unlock();
+        // Every call to `scheduleStep` queues exactly one step for exactly one worker.
+        break :s run.ready_steps.remove().step;
+    };
+    workerMakeOneStep(wg, b, s, prog_node, run);
+}
+
 fn workerMakeOneStep(
     wg: *std.Thread.WaitGroup,
     b: *std.Build,
@@ -1384,6 +1743,8 @@ fn workerMakeOneStep(
 
     if (run.web_server) |*ws| ws.updateStepStatus(s, .wip);
 
+    var timer = std.time.Timer.start() catch null;
+    const trace_start_ns = if (b.graph.trace) |trace| trace.now() else 0;
     const make_result = s.make(.{
         .progress_node = sub_prog_node,
         .thread_pool = thread_pool,
@@ -1392,6 +1753,7 @@ fn workerMakeOneStep(
         .unit_test_timeout_ns = run.unit_test_timeout_ns,
         .gpa = run.gpa,
     });
+    if (timer) |*t| run.stepInfo(s).duration_ns = t.read();
 
     // No matter the result, we want to display error/warning messages.
     const show_compile_errors = s.result_error_bundle.errorMessageCount() > 0;
@@ -1404,6 +1766,11 @@ fn workerMakeOneStep(
         printErrorMessages(run.gpa, s, .{}, bw, ttyconf, run.error_style, run.multiline_errors) catch {};
     }
 
+    if (b.graph.trace) |trace| trace.addStep(s, trace_start_ns, if (make_result) |_| .success else |err| switch (err) {
+        error.MakeFailed => .failure,
+        error.MakeSkipped => .skipped,
+    });
+
     handle_result: {
         if (make_result) |_| {
             @atomicStore(Step.State, &s.state, .success, .seq_cst);
@@ -1423,9 +1790,7 @@ fn workerMakeOneStep(
 
         // Successful completion of a step, so we queue up its dependants as well.
         for (s.dependants.items) |dep| {
-            thread_pool.spawnWg(wg, workerMakeOneStep, .{
-                wg, b, dep, prog_node, run,
-            });
+            scheduleStep(wg, b, dep, prog_node, run);
         }
     }
 
@@ -1448,9 +1813,7 @@ fn workerMakeOneStep(
             if (dep.max_rss <= remaining) {
                 remaining -= dep.max_rss;
 
-                thread_pool.spawnWg(wg, workerMakeOneStep, .{
-                    wg, b, dep, prog_node, run,
-                });
+                scheduleStep(wg, b, dep, prog_node, run);
             } else {
                 run.memory_blocked_steps.items[i] = dep;
                 i += 1;
@@ -1608,16 +1971,24 @@ fn printUsage(b: *std.Build, w: *Writer) !void {
         \\    newline                    Include a leading newline so that the error message is on its own lines
         \\    none                       Print as usual so the first line is misaligned
         \\  --summary [mode]             Control the printing of the build summary
-        \\    all                        Print the build summary in its entirety
-        \\    new                        Omit cached steps
+        \\    all                        Print the build summary in its entirety, and the critical path
+        \\    new                        Omit cached steps, and print the critical path
         \\    failures                   (Default if short-lived) Only print failed steps
         \\    line                       (Default if long-lived) Only print the single-line summary
         \\    none                       Do not print the build summary
         \\  -j<N>                        Limit concurrent jobs (default is to use all CPU cores)
         \\  --maxrss <bytes>             Limit memory usage (default is to use available memory)
         \\  --skip-oom-steps             Instead of failing, skip steps that would exceed --maxrss
+        \\  --cache-gc=<bytes>           After building, at most once per hour, evict least recently
+        \\                               used entries from the local and global caches until each
+        \\                               fits in <bytes>
         \\  --test-timeout <timeout>     Limit execution time of unit tests, terminating if exceeded.
         \\                               The timeout must include a unit: ns, us, ms, s, m, h
+        \\  --rerun-failed               Only run unit tests which did not pass the last time
+        \\                               their step ran
+        \\  --test-jobs <N>              Run the unit tests of each test binary in N processes
+        \\  --test-shard=<i>/<n>         Only run the i-th of n equal parts of each test binary's
+        \\                               unit tests, to split them across machines
         \\  --fetch[=mode]               Fetch dependency tree (optionally choose laziness) and exit
         \\    needed                     (Default) Lazy dependencies are fetched as needed
         \\    all                        Lazy dependencies are always fetched
@@ -1628,8 +1999,15 @@ fn printUsage(b: *std.Build, w: *Writer) !void {
         \\                               limit to the max number of iterations. The argument supports
         \\                               an optional 'K', 'M', or 'G' suffix (e.g. '10K'). Implies
         \\                               '--webui' when no limit is specified.
+        \\  --fuzz-cmin                  Instead of fuzzing, reduce the corpus of each fuzz test
+        \\                               to the smallest inputs covering the same code
+        \\  --fuzz-merge=<dir>           Like '--fuzz-cmin', after adding the corpora in <dir>,
+        \\                               a copy of the 'f' directory of another cache
         \\  --time-report                Force full rebuild and provide detailed information on
-        \\                               compilation time of Zig source code (implies '--webui')
+        \\                               compilation time of Zig source code (implies '--webui'
+        \\                               unless '--trace' is given)
+        \\  --trace=<file>               Write a timeline of the build to <file> in the Chrome
+        \\                               trace event format, for Perfetto or chrome://tracing
         \\     -fincremental             Enable incremental compilation
         \\  -fno-incremental             Disable incremental compilation
         \\
@@ -18,6 +18,11 @@ var fba_buffer: [8192]u8 = undefined;
 var stdin_buffer: [4096]u8 = undefined;
 var stdout_buffer: [4096]u8 = undefined;
 var runner_threaded_io: Io.Threaded = .init_single_threaded;
+/// Set by `--shard=[i]/[n]`. When not running under the build system, only
+/// every `shard_count`th test is run, starting at `shard_index`, so that the
+/// tests of one binary can be split across several machines.
+var shard_index: usize = 0;
+var shard_count: usize = 1;
 
 /// Keep in sync with logic in `std.Build.addRunArtifact` which decides whether
 /// the test runner will communicate with the build runner via `std.zig.Server`.
@@ -55,6 +60,9 @@ pub fn main() void {
                 @panic("unable to parse --seed command line argument");
         } else if (std.mem.startsWith(u8, arg, "--cache-dir")) {
             opt_cache_dir = arg["--cache-dir=".len..];
+        } else if (std.mem.startsWith(u8, arg, "--shard=")) {
+            parseShard(arg["--shard=".len..]) catch
+                @panic("unable to parse --shard command line argument");
         } else {
             @panic("unrecognized command line argument");
         }
@@ -215,23 +223,38 @@ fn mainServer() !void {
     }
 }
 
+/// Parses `[i]/[n]`, where `i` is one-based.
+fn parseShard(value: []const u8) !void {
+    const slash = std.mem.indexOfScalar(u8, value, '/') orelse return error.InvalidShard;
+    const index = try std.fmt.parseUnsigned(usize, value[0..slash], 10);
+    const count = try std.fmt.parseUnsigned(usize, value[slash + 1 ..], 10);
+    if (index == 0 or index > count) return error.InvalidShard;
+    shard_index = index - 1;
+    shard_count = count;
+}
+
 fn mainTerminal() void {
     @disableInstrumentation();
     if (builtin.fuzz) @panic("fuzz test requires server");
 
-    const test_fn_list = builtin.test_functions;
+    const all_test_fns = builtin.test_functions;
+    // Unlike the build system, which hands out the tests one at a time, a
+    // shard here is every `shard_count`th test, so it is known up front.
+    const test_fn_list = if (shard_index < all_test_fns.len) all_test_fns[shard_index..] else all_test_fns[0..0];
+    const test_fn_len = (test_fn_list.len + shard_count - 1) / shard_count;
     var ok_count: usize = 0;
     var skip_count: usize = 0;
     var fail_count: usize = 0;
     var fuzz_count: usize = 0;
     const root_node = if (builtin.fuzz) std.Progress.Node.none else std.Progress.start(.{
         .root_name = "Test",
-        .estimated_total_items = test_fn_list.len,
+        .estimated_total_items = test_fn_len,
     });
     const have_tty = std.fs.File.stderr().isTty();
 
     var leaks: usize = 0;
-    for (test_fn_list, 0..) |test_fn, i| {
+    for (0..test_fn_len) |i| {
+        const test_fn = test_fn_list[i * shard_count];
         testing.allocator_instance = .{};
         testing.io_instance = .init(testing.allocator);
         defer {
@@ -242,7 +265,7 @@ fn mainTerminal() void {
 
         const test_node = root_node.start(test_fn.name, 0);
         if (!have_tty) {
-            std.debug.print("{d}/{d} {s}...", .{ i + 1, test_fn_list.len, test_fn.name });
+            std.debug.print("{d}/{d} {s}...", .{ i + 1, test_fn_len, test_fn.name });
         }
         is_fuzz_test = false;
         if (test_fn.func()) |_| {
@@ -253,7 +276,7 @@ fn mainTerminal() void {
             error.SkipZigTest => {
                 skip_count += 1;
                 if (have_tty) {
-                    std.debug.print("{d}/{d} {s}...SKIP\n", .{ i + 1, test_fn_list.len, test_fn.name });
+                    std.debug.print("{d}/{d} {s}...SKIP\n", .{ i + 1, test_fn_len, test_fn.name });
                 } else {
                     std.debug.print("SKIP\n", .{});
                 }
@@ -263,7 +286,7 @@ fn mainTerminal() void {
                 fail_count += 1;
                 if (have_tty) {
                     std.debug.print("{d}/{d} {s}...FAIL ({t})\n", .{
-                        i + 1, test_fn_list.len, test_fn.name, err,
+                        i + 1, test_fn_len, test_fn.name, err,
                     });
                 } else {
                     std.debug.print("FAIL ({t})\n", .{err});
@@ -277,7 +300,7 @@ fn mainTerminal() void {
         fuzz_count += @intFromBool(is_fuzz_test);
     }
     root_node.end();
-    if (ok_count == test_fn_list.len) {
+    if (ok_count == test_fn_len) {
         std.debug.print("All {d} tests passed.\n", .{ok_count});
     } else {
         std.debug.print("{d} passed; {d} skipped; {d} failed.\n", .{ ok_count, skip_count, fail_count });
@@ -424,7 +447,27 @@ pub fn fuzz(
         defer testing.allocator_instance = prev_allocator_state;
 
         global.ctx = context;
-        fuzz_abi.fuzzer_init_test(&global.test_one, .fromSlice(builtin.test_functions[fuzz_test_index].name));
+        const test_name = builtin.test_functions[fuzz_test_index].name;
+        // Only fuzzing forever is split across processes.
+        const instance_id: u32 = switch (fuzz_mode) {
+            .forever => @intCast(fuzz_amount_or_instance),
+            .iterations => 0,
+            .minimize => {
+                fuzz_abi.fuzzer_minimize_corpus(
+                    &global.test_one,
+                    .fromSlice(test_name),
+                    @truncate(fuzz_amount_or_instance),
+                    @intCast(fuzz_amount_or_instance >> 32),
+                );
+                return;
+            },
+        };
+        fuzz_abi.fuzzer_init_test(
+            &global.test_one,
+            .fromSlice(test_name),
+            instance_id,
+            options.fork_server,
+        );
 
         for (options.corpus) |elem|
             fuzz_abi.fuzzer_new_input(.fromSlice(elem));
@@ -2,6 +2,7 @@ const builtin = @import("builtin");
 const std = @import("std");
 const fatal = std.process.fatal;
 const mem = std.mem;
+const posix = std.posix;
 const math = std.math;
 const Allocator = mem.Allocator;
 const assert = std.debug.assert;
@@ -271,6 +272,16 @@ const Instrumentation = struct {
     const_vals8: std.ArrayListUnmanaged(u64) = .empty,
     const_vals16: std.ArrayListUnmanaged(u128) = .empty,
 
+    /// When set, the operands of comparisons are recorded into `cmp_log*`.
+    cmp_log_enabled: bool = false,
+    /// Operands of the comparisons made while `cmp_log_enabled` was set, by
+    /// width. Values which were already equal are not recorded.
+    cmp_log2: std.ArrayListUnmanaged([2]u16) = .empty,
+    cmp_log4: std.ArrayListUnmanaged([2]u32) = .empty,
+    cmp_log8: std.ArrayListUnmanaged([2]u64) = .empty,
+
+    const max_cmp_log_len = 1 << 12;
+
     /// A minimal state for this struct which instrumentation can function on.
     /// Used before this structure is initialized to avoid illegal behavior
     /// from instrumentation functions being called and using undefined values.
@@ -284,6 +295,9 @@ const Instrumentation = struct {
         self.const_vals4.deinit(gpa);
         self.const_vals8.deinit(gpa);
         self.const_vals16.deinit(gpa);
+        self.cmp_log2.deinit(gpa);
+        self.cmp_log4.deinit(gpa);
+        self.cmp_log8.deinit(gpa);
         self.* = undefined;
     }
 
@@ -310,6 +324,25 @@ const Instrumentation = struct {
         self.const_vals4.clearRetainingCapacity();
         self.const_vals8.clearRetainingCapacity();
         self.const_vals16.clearRetainingCapacity();
+        self.cmp_log2.clearRetainingCapacity();
+        self.cmp_log4.clearRetainingCapacity();
+        self.cmp_log8.clearRetainingCapacity();
+    }
+
+    fn cmpLog(self: *Instrumentation, comptime T: type) *std.ArrayListUnmanaged([2]T) {
+        return switch (T) {
+            u16 => &self.cmp_log2,
+            u32 => &self.cmp_log4,
+            u64 => &self.cmp_log8,
+            else => comptime unreachable,
+        };
+    }
+
+    fn logCmp(self: *Instrumentation, comptime T: type, arg1: T, arg2: T) void {
+        if (arg1 == arg2) return;
+        const list = self.cmpLog(T);
+        if (list.items.len == max_cmp_log_len) return;
+        list.append(gpa, .{ arg1, arg2 }) catch @panic("OOM");
     }
 
     /// If false is returned, then the pc is marked as seen
@@ -360,7 +393,7 @@ const Instrumentation = struct {
 
 const Fuzzer = struct {
     arena_ctx: std.heap.ArenaAllocator = .init(gpa),
-    rng: std.Random.DefaultPrng = .init(0),
+    rng: std.Random.DefaultPrng,
     test_one: abi.TestOne,
     /// The next input that will be given to the testOne function. When the
     /// current process crashes, this memory-mapped file is used to recover the
@@ -376,87 +409,147 @@ const Fuzzer = struct {
     /// most effective are the most likely to be selected again. Starts with one of each mutation.
     mutations: std.ArrayListUnmanaged(Mutation) = .empty,
 
-    /// Filesystem directory containing found inputs for future runs
+    /// Filesystem directory containing found inputs for future runs. It is
+    /// shared by all processes fuzzing the same test.
     corpus_dir: std.fs.Dir,
+    /// Every corpus file before this one has been added to `corpus`.
     corpus_dir_idx: usize = 0,
-
-    pub fn init(test_one: abi.TestOne, unit_test_name: []const u8) Fuzzer {
+    /// Tells apart the processes fuzzing the same test at once.
+    instance_id: u32,
+    /// Counts down to the next check for inputs found by other processes.
+    cycles_until_sync: u32 = sync_interval,
+    /// When not null, inputs are run in forked child processes instead.
+    fork_server: ?ForkServer,
+    /// Indexes into `corpus` of the inputs still due a `cmpLogPass`.
+    cmp_log_queue: std.ArrayListUnmanaged(usize) = .empty,
+
+    const sync_interval = 1 << 12;
+
+    pub fn init(test_one: abi.TestOne, unit_test_name: []const u8, instance_id: u32, fork_server: bool) Fuzzer {
         var self: Fuzzer = .{
+            // Each process fuzzing the same test must try different mutations.
+            .rng = .init(instance_id),
             .test_one = test_one,
             .input = undefined,
             .corpus = .empty,
             .corpus_pos = 0,
             .mutations = .empty,
             .corpus_dir = undefined,
+            .instance_id = instance_id,
+            .fork_server = if (fork_server) .init() else null,
         };
-        const arena = self.arena_ctx.allocator();
 
         self.corpus_dir = exec.cache_f.makeOpenPath(unit_test_name, .{}) catch |e|
             panic("failed to open directory '{s}': {t}", .{ unit_test_name, e });
+        var dry_run_len: usize = 0;
         self.input = in: {
-            const f = self.corpus_dir.createFile("in", .{
+            var name_buf: [16]u8 = undefined;
+            const name = if (instance_id == 0) "in" else std.fmt.bufPrint(&name_buf, "in{d}", .{instance_id}) catch unreachable;
+            const f = self.corpus_dir.createFile(name, .{
                 .read = true,
                 .truncate = false,
-                // In case any other fuzz tests are running under the same test name,
-                // the input file is exclusively locked to ensures only one proceeds.
+                // Each process fuzzing this test has its own input file. In case
+                // another one was started with the same instance ID, the input file
+                // is exclusively locked to ensure only one proceeds.
                 .lock = .exclusive,
                 .lock_nonblocking = true,
             }) catch |e| switch (e) {
-                error.WouldBlock => @panic("input file 'in' is in use by another fuzzing process"),
-                else => panic("failed to create input file 'in': {t}", .{e}),
+                error.WouldBlock => panic("input file '{s}' is in use by another fuzzing process", .{name}),
+                else => panic("failed to create input file '{s}': {t}", .{ name, e }),
             };
-            const size = f.getEndPos() catch |e| panic("failed to stat input file 'in': {t}", .{e});
+            const size = f.getEndPos() catch |e| panic("failed to stat input file '{s}': {t}", .{ name, e });
             const map = (if (size < std.heap.page_size_max)
                 MemoryMappedList.create(f, 8, std.heap.page_size_max)
             else
                 MemoryMappedList.init(f, size, size)) catch |e|
-                panic("failed to memory map input file 'in': {t}", .{e});
-
-            // Perform a dry-run of the stored input if there was one in case it might reproduce a
-            // crash.
-            const old_in_len = mem.littleToNative(usize, mem.bytesAsValue(usize, map.items[0..8]).*);
-            if (size >= 8 and old_in_len != 0 and map.items.len - 8 < old_in_len) {
-                test_one(.fromSlice(@volatileCast(map.items[8..][0..old_in_len])));
-            }
+                panic("failed to memory map input file '{s}': {t}", .{ name, e });
 
+            if (size >= 8) dry_run_len = mem.littleToNative(usize, mem.bytesAsValue(usize, map.items[0..8]).*);
             break :in map;
         };
+        // Perform a dry-run of the stored input if there was one in case it might reproduce a
+        // crash.
+        if (dry_run_len != 0 and dry_run_len <= self.input.capacity - 8) {
+            self.input.items.len = 8 + dry_run_len;
+            self.run();
+        }
         inst.reset();
 
         self.mutations.appendSlice(gpa, std.meta.tags(Mutation)) catch @panic("OOM");
         // Ensure there is never an empty corpus. Additionally, an empty input usually leads to
         // new inputs.
         self.addInput(&.{});
-
-        while (true) {
-            var name_buf: [@sizeOf(usize) * 2]u8 = undefined;
-            const bytes = self.corpus_dir.readFileAlloc(
-                std.fmt.bufPrint(&name_buf, "{x}", .{self.corpus_dir_idx}) catch unreachable,
-                arena,
-                .unlimited,
-            ) catch |e| switch (e) {
-                error.FileNotFound => break,
-                else => panic("failed to read corpus file '{x}': {t}", .{ self.corpus_dir_idx, e }),
-            };
-            // No corpus file of length zero will ever be created
-            if (bytes.len == 0)
-                panic("corrupt corpus file '{x}' (len of zero)", .{self.corpus_dir_idx});
-            self.addInput(bytes);
-            self.corpus_dir_idx += 1;
-        }
+        self.syncCorpus();
 
         return self;
     }
 
     pub fn deinit(self: *Fuzzer) void {
+        if (self.fork_server) |*server| server.deinit();
         self.input.deinit();
         self.corpus.deinit(gpa);
         self.mutations.deinit(gpa);
+        self.cmp_log_queue.deinit(gpa);
         self.corpus_dir.close();
         self.arena_ctx.deinit();
         self.* = undefined;
     }
 
+    /// Adds the corpus files which were written since the last call, by
+    /// previous runs or by other processes fuzzing the same test.
+    fn syncCorpus(self: *Fuzzer) void {
+        while (self.readCorpusFile()) {}
+    }
+
+    /// Adds the corpus file at `corpus_dir_idx`, if there is one yet.
+    fn readCorpusFile(self: *Fuzzer) bool {
+        const arena = self.arena_ctx.allocator();
+        var name_buf: [@sizeOf(usize) * 2]u8 = undefined;
+        const bytes = self.corpus_dir.readFileAlloc(
+            std.fmt.bufPrint(&name_buf, "{x}", .{self.corpus_dir_idx}) catch unreachable,
+            arena,
+            .unlimited,
+        ) catch |e| switch (e) {
+            error.FileNotFound => return false,
+            else => panic("failed to read corpus file '{x}': {t}", .{ self.corpus_dir_idx, e }),
+        };
+        // No corpus file of length zero will ever be created
+        if (bytes.len == 0)
+            panic("corrupt corpus file '{x}' (len of zero)", .{self.corpus_dir_idx});
+        self.addInput(bytes);
+        self.corpus_dir_idx += 1;
+        return true;
+    }
+
+    /// Writes `bytes` as the next corpus file. It is written under a name
+    /// private to this process, and then linked into place, so that other
+    /// processes never read it partially written, nor claim the same name.
+    fn writeCorpusFile(self: *Fuzzer, bytes: []const u8) void {
+        var tmp_name_buf: [16]u8 = undefined;
+        const tmp_name = std.fmt.bufPrint(&tmp_name_buf, "tmp{d}", .{self.instance_id}) catch unreachable;
+        self.corpus_dir.writeFile(.{ .sub_path = tmp_name, .data = bytes }) catch |e|
+            panic("failed to write corpus file '{s}': {t}", .{ tmp_name, e });
+        defer self.corpus_dir.deleteFile(tmp_name) catch {};
+
+        while (true) {
+            var name_buf: [@sizeOf(usize) * 2]u8 = undefined;
+            const name = std.fmt.bufPrint(&name_buf, "{x}", .{self.corpus_dir_idx}) catch unreachable;
+            posix.linkat(self.corpus_dir.fd, tmp_name, self.corpus_dir.fd, name, 0) catch |e| switch (e) {
+                // Another process got there first. Take its input and try
+                // the next name. If the file has vanished since (the corpus
+                // was cleared), `corpus_dir_idx` is unchanged and the link
+                // is simply retried.
+                error.PathAlreadyExists => {
+                    _ = self.readCorpusFile();
+                    continue;
+                },
+                else => panic("failed to write corpus file '{s}': {t}", .{ name, e }),
+            };
+            self.corpus_dir_idx += 1;
+            return;
+        }
+    }
+
     pub fn addInput(self: *Fuzzer, bytes: []const u8) void {
         self.corpus.append(gpa, bytes) catch @panic("OOM");
         self.input.clearRetainingCapacity();
@@ -492,11 +585,14 @@ const Fuzzer = struct {
     }
 
     fn run(self: *Fuzzer) void {
-        // `pc_counters` is not cleared since only new hits are relevant.
-
         mem.bytesAsValue(usize, self.input.items[0..8]).* =
             mem.nativeToLittle(usize, self.input.items.len - 8);
-        self.test_one(.fromSlice(@volatileCast(self.input.items[8..])));
+        if (self.fork_server) |*server| {
+            server.run(self);
+        } else {
+            // `pc_counters` is not cleared since only new hits are relevant.
+            self.test_one(.fromSlice(@volatileCast(self.input.items[8..])));
+        }
 
         const header = mem.bytesAsValue(
             abi.SeenPcsHeader,
@@ -506,6 +602,19 @@ const Fuzzer = struct {
     }
 
     pub fn cycle(self: *Fuzzer) void {
+        self.cycles_until_sync -= 1;
+        if (self.cycles_until_sync == 0) {
+            @branchHint(.unlikely);
+            self.cycles_until_sync = sync_interval;
+            self.syncCorpus();
+        }
+
+        if (self.cmp_log_queue.pop()) |corpus_i| {
+            @branchHint(.unlikely);
+            self.cmpLogPass(self.corpus.items[corpus_i]);
+            return;
+        }
+
         const input = self.corpus.items[self.corpus_pos];
         self.corpus_pos += 1;
         if (self.corpus_pos == self.corpus.items.len)
@@ -523,6 +632,9 @@ const Fuzzer = struct {
                 inst.const_vals4.items,
                 inst.const_vals8.items,
                 inst.const_vals16.items,
+                inst.cmp_log2.items,
+                inst.cmp_log4.items,
+                inst.cmp_log8.items,
             )) continue;
             break m;
         };
@@ -531,46 +643,361 @@ const Fuzzer = struct {
 
         if (inst.isFresh()) {
             @branchHint(.unlikely);
+            self.addFreshInput(m);
+        }
+    }
 
-            const header = mem.bytesAsValue(
-                abi.SeenPcsHeader,
-                exec.shared_seen_pcs.items[0..@sizeOf(abi.SeenPcsHeader)],
-            );
-            _ = @atomicRmw(usize, &header.unique_runs, .Add, 1, .monotonic);
-
-            inst.setFresh();
-            self.minimizeInput();
-            inst.updateSeen();
-
-            // An empty-input has always been tried, so if an empty input is fresh then the
-            // test has to be non-deterministic. This has to be checked as duplicate empty
-            // entries are not allowed.
-            if (self.input.items.len - 8 == 0) {
-                std.log.warn("non-deterministic test (empty input produces different hits)", .{});
-                _ = @atomicRmw(usize, &header.unique_runs, .Sub, 1, .monotonic);
-                return;
+    /// Adds the current input, which was made by `m` and hit new pcs, to the
+    /// corpus, and makes `m` more likely to be picked again.
+    fn addFreshInput(self: *Fuzzer, m: Mutation) void {
+        const header = mem.bytesAsValue(
+            abi.SeenPcsHeader,
+            exec.shared_seen_pcs.items[0..@sizeOf(abi.SeenPcsHeader)],
+        );
+        _ = @atomicRmw(usize, &header.unique_runs, .Add, 1, .monotonic);
+
+        inst.setFresh();
+        self.minimizeInput();
+        inst.updateSeen();
+
+        // An empty-input has always been tried, so if an empty input is fresh then the
+        // test has to be non-deterministic. This has to be checked as duplicate empty
+        // entries are not allowed.
+        if (self.input.items.len - 8 == 0) {
+            std.log.warn("non-deterministic test (empty input produces different hits)", .{});
+            _ = @atomicRmw(usize, &header.unique_runs, .Sub, 1, .monotonic);
+            return;
+        }
+
+        const arena = self.arena_ctx.allocator();
+        const bytes = arena.dupe(u8, @volatileCast(self.input.items[8..])) catch @panic("OOM");
+
+        self.corpus.append(gpa, bytes) catch @panic("OOM");
+        self.mutations.appendNTimes(gpa, m, 6) catch @panic("OOM");
+
+        // Write new corpus to cache
+        self.writeCorpusFile(bytes);
+
+        // The comparisons are made in the child process instead.
+        if (self.fork_server == null)
+            self.cmp_log_queue.append(gpa, self.corpus.items.len - 1) catch @panic("OOM");
+    }
+
+    /// The most inputs a `cmpLogPass` may run.
+    const max_cmp_log_pass_runs = 1 << 10;
+
+    /// Runs `in` once to record the operands of the comparisons it makes, and
+    /// then runs each input made by replacing, in `in`, a value which one of
+    /// those comparisons tested against the other operand. This gets past
+    /// checks against magic values and checksums which random mutations are
+    /// unlikely to satisfy. Each width and byte order is tried, as well as
+    /// narrower widths for operands small enough, which the input may hold
+    /// before they are extended.
+    fn cmpLogPass(self: *Fuzzer, in: []const u8) void {
+        // The logs also feed the `replace_cmp_*` mutations, so they are only
+        // cleared once full.
+        var starts: [3]usize = undefined;
+        inline for (.{ u16, u32, u64 }, &starts) |T, *start| {
+            const list = inst.cmpLog(T);
+            if (list.items.len == Instrumentation.max_cmp_log_len) list.clearRetainingCapacity();
+            start.* = list.items.len;
+        }
+
+        self.input.clearRetainingCapacity();
+        self.input.ensureTotalCapacity(8 + in.len) catch |e|
+            panic("could not resize shared input file: {t}", .{e});
+        self.input.items.len = 8;
+        self.input.appendSliceAssumeCapacity(in);
+        inst.cmp_log_enabled = true;
+        self.run();
+        inst.cmp_log_enabled = false;
+
+        var runs_left: usize = max_cmp_log_pass_runs;
+        inline for (.{ u16, u32, u64 }, starts) |T, start| {
+            for (inst.cmpLog(T).items[start..]) |pair| {
+                inline for (.{ u16, u32, u64 }) |W| {
+                    if (@bitSizeOf(W) > @bitSizeOf(T)) break;
+                    if (fitsIn(W, T, pair[0]) and fitsIn(W, T, pair[1])) {
+                        const a: W = @truncate(pair[0]);
+                        const b: W = @truncate(pair[1]);
+                        inline for (.{ .little, .big }) |endian| {
+                            if (!self.tryCmpReplacements(W, endian, in, a, b, &runs_left)) return;
+                            if (!self.tryCmpReplacements(W, endian, in, b, a, &runs_left)) return;
+                        }
+                    }
+                }
             }
+        }
+    }
 
-            const arena = self.arena_ctx.allocator();
-            const bytes = arena.dupe(u8, @volatileCast(self.input.items[8..])) catch @panic("OOM");
+    /// Whether `value` is the zero or sign extension of a `W`.
+    fn fitsIn(comptime W: type, comptime T: type, value: T) bool {
+        if (W == T) return true;
+        const high = value >> @bitSizeOf(W);
+        return high == 0 or high == math.maxInt(T) >> @bitSizeOf(W);
+    }
 
-            self.corpus.append(gpa, bytes) catch @panic("OOM");
-            self.mutations.appendNTimes(gpa, m, 6) catch @panic("OOM");
+    /// Returns false once `runs_left` is used up.
+    fn tryCmpReplacements(
+        self: *Fuzzer,
+        comptime T: type,
+        comptime endian: std.builtin.Endian,
+        in: []const u8,
+        from: T,
+        to: T,
+        runs_left: *usize,
+    ) bool {
+        const m = comptime Mutation.replaceCmp(T, endian);
+        const from_bytes = mem.toBytes(mem.nativeTo(T, from, endian));
+        var pos: usize = 0;
+        while (mem.indexOfPos(u8, in, pos, &from_bytes)) |i| : (pos = i + 1) {
+            if (runs_left.* == 0) return false;
+            runs_left.* -= 1;
+
+            self.input.clearRetainingCapacity();
+            self.input.items.len = 8;
+            self.input.appendSliceAssumeCapacity(in);
+            mem.bytesAsValue(T, self.input.items[8..][i..][0..@sizeOf(T)]).* =
+                mem.nativeTo(T, to, endian);
+            self.run();
+            if (inst.isFresh()) {
+                @branchHint(.unlikely);
+                self.addFreshInput(m);
+            }
+        }
+        return true;
+    }
+};
 
-            // Write new corpus to cache
-            var name_buf: [@sizeOf(usize) * 2]u8 = undefined;
-            self.corpus_dir.writeFile(.{
-                .sub_path = std.fmt.bufPrint(
-                    &name_buf,
-                    "{x}",
-                    .{self.corpus_dir_idx},
-                ) catch unreachable,
-                .data = bytes,
-            }) catch |e| panic(
-                "failed to write corpus file '{x}': {t}",
-                .{ self.corpus_dir_idx, e },
-            );
-            self.corpus_dir_idx += 1;
+/// Runs the inputs of a `Fuzzer` in a child process forked from this one, so
+/// that the test cannot change the state of the fuzzer, and a crash only ends
+/// the child. Each child runs a batch of inputs, and is then replaced by a
+/// fresh copy of this process.
+///
+/// The child reads each input from the input file, which is a shared mapping,
+/// and copies its pc counters into `shared_pc_counters` after running it.
+/// Those take the place of `exec.pc_counters` in this process.
+const ForkServer = struct {
+    /// Where the instrumentation of this process counts pc hits.
+    own_pc_counters: []u8,
+    /// The pc hits of the last input, shared with the child.
+    shared_pc_counters: []align(std.heap.page_size_min) u8,
+    child: ?Child,
+    /// The last input sent to `child`, which is the one to blame if the child
+    /// is found dead before the next one.
+    last_input: std.ArrayListUnmanaged(u8),
+    /// How many inputs crashed the test.
+    crashes: usize,
+
+    const batch_size = 1 << 10;
+
+    const Child = struct {
+        pid: posix.pid_t,
+        /// A byte requests that the next input is run. Closed to stop the child.
+        request: std.fs.File,
+        /// A byte means that the input ran. Closed when the child exits.
+        response: std.fs.File,
+        runs_left: u32,
+        /// The child is only aware of the input file mapping from when it was forked.
+        input_capacity: usize,
+    };
+
+    fn init() ForkServer {
+        const shared = posix.mmap(
+            null,
+            @max(exec.pc_counters.len, 1),
+            posix.PROT.READ | posix.PROT.WRITE,
+            .{ .TYPE = .SHARED, .ANONYMOUS = true },
+            -1,
+            0,
+        ) catch |e| panic("failed to map memory shared with fork server: {t}", .{e});
+        const server: ForkServer = .{
+            .own_pc_counters = exec.pc_counters,
+            .shared_pc_counters = shared[0..exec.pc_counters.len],
+            .child = null,
+            .last_input = .empty,
+            .crashes = 0,
+        };
+        exec.pc_counters = server.shared_pc_counters;
+
+        // Writing to a child which died must fail with `error.BrokenPipe`
+        // instead of ending this process.
+        var old_act: posix.Sigaction = undefined;
+        posix.sigaction(.PIPE, null, &old_act);
+        if (old_act.handler.handler == posix.SIG.DFL) {
+            const act: posix.Sigaction = .{
+                .handler = .{ .handler = posix.SIG.IGN },
+                .mask = posix.sigemptyset(),
+                .flags = 0,
+            };
+            posix.sigaction(.PIPE, &act, null);
+        }
+        return server;
+    }
+
+    fn deinit(server: *ForkServer) void {
+        server.stop();
+        server.last_input.deinit(gpa);
+        exec.pc_counters = server.own_pc_counters;
+        posix.munmap(server.shared_pc_counters.ptr[0..@max(server.shared_pc_counters.len, 1)]);
+        server.* = undefined;
+    }
+
+    fn run(server: *ForkServer, f: *Fuzzer) void {
+        if (server.child) |child| {
+            if (child.runs_left == 0 or child.input_capacity != f.input.capacity) server.stop();
+        }
+        const child = if (server.child) |*child| child else server.start(f);
+        const input = @volatileCast(f.input.items[8..]);
+
+        var byte: [1]u8 = .{0};
+        child.request.writeAll(&byte) catch {
+            // The child died since the last input, for example from a thread
+            // started by the test, which closes the pipe. That input is the
+            // one which crashed, and the current one is run by a new child.
+            // A child which died before running any input has nothing else to
+            // blame, and is not replaced again.
+            if (child.runs_left == batch_size) return server.crashed(f, input);
+            server.crashed(f, server.last_input.items);
+            return server.run(f);
+        };
+        child.runs_left -= 1;
+        server.last_input.clearRetainingCapacity();
+        server.last_input.appendSlice(gpa, input) catch @panic("OOM");
+
+        const n = child.response.read(&byte) catch return server.crashed(f, input);
+        if (n == 0) server.crashed(f, input);
+    }
+
+    fn start(server: *ForkServer, f: *Fuzzer) *Child {
+        const request = posix.pipe2(.{ .CLOEXEC = true }) catch |e|
+            panic("failed to create fork server pipe: {t}", .{e});
+        const response = posix.pipe2(.{ .CLOEXEC = true }) catch |e|
+            panic("failed to create fork server pipe: {t}", .{e});
+        const pid = posix.fork() catch |e| panic("failed to fork: {t}", .{e});
+        if (pid == 0) {
+            posix.close(request[1]);
+            posix.close(response[0]);
+            server.serve(f, .{ .handle = request[0] }, .{ .handle = response[1] });
+        }
+        posix.close(request[0]);
+        posix.close(response[1]);
+        server.child = .{
+            .pid = pid,
+            .request = .{ .handle = request[1] },
+            .response = .{ .handle = response[0] },
+            .runs_left = batch_size,
+            .input_capacity = f.input.capacity,
+        };
+        return &server.child.?;
+    }
+
+    /// The child process runs inputs as they are requested, until the request
+    /// pipe is closed.
+    fn serve(server: *const ForkServer, f: *const Fuzzer, request: std.fs.File, response: std.fs.File) noreturn {
+        const start_const_lens = constLens();
+        while (true) {
+            var byte: [1]u8 = undefined;
+            if ((request.read(&byte) catch 0) == 0) break;
+            const len = mem.littleToNative(usize, mem.bytesAsValue(usize, f.input.items.ptr[0..8]).*);
+            @memset(server.own_pc_counters, 0);
+            f.test_one(.fromSlice(@volatileCast(f.input.items.ptr[8..][0..len])));
+            @memcpy(server.shared_pc_counters, server.own_pc_counters);
+            response.writeAll(&byte) catch break;
+        }
+        sendConsts(response, start_const_lens) catch {};
+        std.process.exit(0);
+    }
+
+    /// Waits for the child to take in the request pipe being closed and exit.
+    fn stop(server: *ForkServer) void {
+        const child = server.child orelse return;
+        server.child = null;
+        child.request.close();
+        receiveConsts(child.response) catch |e|
+            std.log.warn("failed to receive comparison constants from fork server: {t}", .{e});
+        child.response.close();
+        _ = posix.waitpid(child.pid, 0);
+    }
+
+    /// Called when the child exited while running `input`. The input is saved
+    /// under a name derived from its contents, and the next input is run by a
+    /// new child.
+    fn crashed(server: *ForkServer, f: *Fuzzer, input: []const u8) void {
+        const child = server.child.?;
+        server.child = null;
+        child.request.close();
+        child.response.close();
+        const status = posix.waitpid(child.pid, 0).status;
+        server.crashes += 1;
+        // Nothing is known about the coverage of an input which crashed.
+        @memset(server.shared_pc_counters, 0);
+
+        var name_buf: [32]u8 = undefined;
+        const name = std.fmt.bufPrint(&name_buf, "crash-{x}", .{std.hash.Wyhash.hash(0, input)}) catch unreachable;
+        f.corpus_dir.writeFile(.{ .sub_path = name, .data = input }) catch |e|
+            panic("failed to write crashing input '{s}': {t}", .{ name, e });
+
+        if (posix.W.IFEXITED(status)) {
+            std.log.err("input crashed the test, which exited with code {d}; saved as '{s}'", .{
+                posix.W.EXITSTATUS(status), name,
+            });
+        } else if (posix.W.IFSIGNALED(status)) {
+            std.log.err("input crashed the test, which was terminated by signal {d}; saved as '{s}'", .{
+                posix.W.TERMSIG(status), name,
+            });
+        } else {
+            std.log.err("input crashed the test; saved as '{s}'", .{name});
+        }
+    }
+
+    /// The constants from comparisons made by the test are recorded in the
+    /// memory of the child, which sends back those it added when it stops.
+    const const_lists = .{ "const_vals2", "const_vals4", "const_vals8", "const_vals16" };
+    const ConstLens = [1 + const_lists.len]usize;
+
+    fn constLens() ConstLens {
+        var lens: ConstLens = undefined;
+        lens[0] = inst.const_pcs.count();
+        inline for (const_lists, 1..) |list, i| lens[i] = @field(inst, list).items.len;
+        return lens;
+    }
+
+    fn sendConsts(response: std.fs.File, start_lens: ConstLens) std.fs.File.WriteError!void {
+        const pcs = inst.const_pcs.keys()[start_lens[0]..];
+        try response.writeAll(mem.asBytes(&pcs.len));
+        try response.writeAll(mem.sliceAsBytes(pcs));
+        inline for (const_lists, 1..) |list, i| {
+            const vals = @field(inst, list).items[start_lens[i]..];
+            try response.writeAll(mem.asBytes(&vals.len));
+            try response.writeAll(mem.sliceAsBytes(vals));
+        }
+    }
+
+    fn receiveConsts(response: std.fs.File) !void {
+        var pcs_len: usize = undefined;
+        try readAll(response, mem.asBytes(&pcs_len));
+        for (0..pcs_len) |_| {
+            var pc: usize = undefined;
+            try readAll(response, mem.asBytes(&pc));
+            inst.const_pcs.put(gpa, pc, {}) catch @panic("OOM");
+        }
+        inline for (const_lists) |list_name| {
+            const list = &@field(inst, list_name);
+            var len: usize = undefined;
+            try readAll(response, mem.asBytes(&len));
+            const old_len = list.items.len;
+            errdefer list.shrinkRetainingCapacity(old_len);
+            try readAll(response, mem.sliceAsBytes(list.addManyAsSlice(gpa, len) catch @panic("OOM")));
+        }
+    }
+
+    fn readAll(file: std.fs.File, buf: []u8) !void {
+        var i: usize = 0;
+        while (i < buf.len) {
+            const n = try file.read(buf[i..]);
+            if (n == 0) return error.EndOfStream;
+            i += n;
         }
     }
 };
@@ -601,9 +1028,9 @@ export fn fuzzer_coverage() abi.Coverage {
 }
 
 /// fuzzer_init must be called beforehand
-export fn fuzzer_init_test(test_one: abi.TestOne, unit_test_name: abi.Slice) void {
+export fn fuzzer_init_test(test_one: abi.TestOne, unit_test_name: abi.Slice, instance_id: u32, fork_server: bool) void {
     current_test_name = unit_test_name.toSlice();
-    fuzzer = .init(test_one, unit_test_name.toSlice());
+    fuzzer = .init(test_one, unit_test_name.toSlice(), instance_id, fork_server);
 }
 
 /// fuzzer_init_test must be called beforehand
@@ -619,7 +1046,62 @@ export fn fuzzer_main(limit_kind: abi.LimitKind, amount: u64) void {
     switch (limit_kind) {
         .forever => while (true) fuzzer.cycle(),
         .iterations => for (0..amount) |_| fuzzer.cycle(),
+        .minimize => unreachable, // fuzzer_minimize_corpus is called instead
+    }
+    // The fork server caught any crashes, but they must still fail the test.
+    if (fuzzer.fork_server) |server| {
+        if (server.crashes != 0) panic("{d} inputs crashed the test", .{server.crashes});
+    }
+}
+
+/// fuzzer_init must be called beforehand
+export fn fuzzer_minimize_corpus(
+    test_one: abi.TestOne,
+    unit_test_name: abi.Slice,
+    instance_id: u32,
+    instance_count: u32,
+) void {
+    current_test_name = unit_test_name.toSlice();
+    var corpus_dir = exec.cache_f.makeOpenPath(unit_test_name.toSlice(), .{}) catch |e|
+        panic("failed to open directory '{s}': {t}", .{ unit_test_name.toSlice(), e });
+    defer corpus_dir.close();
+
+    // A table left behind by an interrupted minimization must not be taken for
+    // this one should an input crash the test.
+    var table_name_buf: [16]u8 = undefined;
+    const table_name = std.fmt.bufPrint(&table_name_buf, "cmin{d}", .{instance_id}) catch unreachable;
+    corpus_dir.deleteFile(table_name) catch |e| switch (e) {
+        error.FileNotFound => {},
+        else => panic("failed to delete '{s}': {t}", .{ table_name, e }),
+    };
+
+    const table = gpa.alloc(abi.MinimizeEntry, exec.pc_counters.len) catch @panic("OOM");
+    defer gpa.free(table);
+    @memset(table, .none);
+
+    var index = instance_id;
+    while (true) : (index += instance_count) {
+        var name_buf: [@sizeOf(usize) * 2]u8 = undefined;
+        const name = std.fmt.bufPrint(&name_buf, "{x}", .{index}) catch unreachable;
+        const bytes = corpus_dir.readFileAlloc(name, gpa, .unlimited) catch |e| switch (e) {
+            error.FileNotFound => break,
+            else => panic("failed to read corpus file '{s}': {t}", .{ name, e }),
+        };
+        defer gpa.free(bytes);
+
+        // Unlike when fuzzing, only the hits of this input are wanted.
+        @memset(exec.pc_counters, 0);
+        test_one(.fromSlice(bytes));
+
+        const entry: abi.MinimizeEntry = .{ .index = index, .len = math.lossyCast(u32, bytes.len) };
+        for (exec.pc_counters, table) |counter, *best| {
+            if (counter != 0 and @as(u64, @bitCast(entry)) < @as(u64, @bitCast(best.*)))
+                best.* = entry;
+        }
     }
+
+    corpus_dir.writeFile(.{ .sub_path = table_name, .data = mem.sliceAsBytes(table) }) catch |e|
+        panic("failed to write '{s}': {t}", .{ table_name, e });
 }
 
 /// Helps determine run uniqueness in the face of recursion.
@@ -640,22 +1122,31 @@ export fn __sanitizer_cov_trace_const_cmp1(const_arg: u8, arg: u8) void {
 }
 
 export fn __sanitizer_cov_trace_const_cmp2(const_arg: u16, arg: u16) void {
-    _ = arg;
     genericConstCmp(u16, const_arg, "const_vals2");
+    if (inst.cmp_log_enabled) inst.logCmp(u16, const_arg, arg);
 }
 
 export fn __sanitizer_cov_trace_const_cmp4(const_arg: u32, arg: u32) void {
-    _ = arg;
     genericConstCmp(u32, const_arg, "const_vals4");
+    if (inst.cmp_log_enabled) inst.logCmp(u32, const_arg, arg);
 }
 
 export fn __sanitizer_cov_trace_const_cmp8(const_arg: u64, arg: u64) void {
-    _ = arg;
     genericConstCmp(u64, const_arg, "const_vals8");
+    if (inst.cmp_log_enabled) inst.logCmp(u64, const_arg, arg);
 }
 
 export fn __sanitizer_cov_trace_switch(val: u64, cases: [*]const u64) void {
-    _ = val;
+    if (inst.cmp_log_enabled) {
+        const cases_slice = cases[2..][0..cases[0]];
+        switch (cases[1]) {
+            0...8 => {},
+            9...16 => for (cases_slice) |c| inst.logCmp(u16, @truncate(val), @truncate(c)),
+            17...32 => for (cases_slice) |c| inst.logCmp(u32, @truncate(val), @truncate(c)),
+            33...64 => for (cases_slice) |c| inst.logCmp(u64, val, c),
+            else => {}, // Should be impossible
+        }
+    }
     if (!inst.constPcSeen(@returnAddress())) {
         @branchHint(.unlikely);
         const case_bits = cases[1];
@@ -680,18 +1171,15 @@ export fn __sanitizer_cov_trace_cmp1(arg1: u8, arg2: u8) void {
 }
 
 export fn __sanitizer_cov_trace_cmp2(arg1: u16, arg2: u16) void {
-    _ = arg1;
-    _ = arg2;
+    if (inst.cmp_log_enabled) inst.logCmp(u16, arg1, arg2);
 }
 
 export fn __sanitizer_cov_trace_cmp4(arg1: u32, arg2: u32) void {
-    _ = arg1;
-    _ = arg2;
+    if (inst.cmp_log_enabled) inst.logCmp(u32, arg1, arg2);
 }
 
 export fn __sanitizer_cov_trace_cmp8(arg1: u64, arg2: u64) void {
-    _ = arg1;
-    _ = arg2;
+    if (inst.cmp_log_enabled) inst.logCmp(u64, arg1, arg2);
 }
 
 export fn __sanitizer_cov_trace_pc_indir(callee: usize) void {
@@ -876,6 +1364,32 @@ const Mutation = enum {
     packed_set_rng_32be,
     packed_set_rng_64le,
     packed_set_rng_64be,
+    /// Replaces an operand of a comparison made by a previous input, where it
+    /// appears in the input, with the other operand. Inputs found this way by
+    /// `Fuzzer.cmpLogPass` are also credited to these.
+    replace_cmp_16le,
+    replace_cmp_16be,
+    replace_cmp_32le,
+    replace_cmp_32be,
+    replace_cmp_64le,
+    replace_cmp_64be,
+
+    fn replaceCmp(T: type, endian: std.builtin.Endian) Mutation {
+        return switch (endian) {
+            .little => switch (T) {
+                u16 => .replace_cmp_16le,
+                u32 => .replace_cmp_32le,
+                u64 => .replace_cmp_64le,
+                else => comptime unreachable,
+            },
+            .big => switch (T) {
+                u16 => .replace_cmp_16be,
+                u32 => .replace_cmp_32be,
+                u64 => .replace_cmp_64be,
+                else => comptime unreachable,
+            },
+        };
+    }
 
     fn fewValue(rng: std.Random, T: type, comptime bits: u16) T {
         var result: T = 0;
@@ -898,6 +1412,9 @@ const Mutation = enum {
         const_vals4: []const u32,
         const_vals8: []const u64,
         const_vals16: []const u128,
+        cmp_log2: []const [2]u16,
+        cmp_log4: []const [2]u32,
+        cmp_log8: []const [2]u64,
     ) bool {
         out.clearRetainingCapacity();
         const new_capacity = 8 + in.len + @max(
@@ -919,6 +1436,9 @@ const Mutation = enum {
                 const_vals4,
                 const_vals8,
                 const_vals16,
+                cmp_log2,
+                cmp_log4,
+                cmp_log8,
             ),
         };
         if (!applied)
@@ -939,8 +1459,11 @@ const Mutation = enum {
         const_vals4: []const u32,
         const_vals8: []const u64,
         const_vals16: []const u128,
+        cmp_log2: []const [2]u16,
+        cmp_log4: []const [2]u32,
+        cmp_log8: []const [2]u64,
     ) bool {
-        const Class = enum { new, remove, rmw, move_span, replicate_splice_span };
+        const Class = enum { new, remove, rmw, cmp, move_span, replicate_splice_span };
         const class: Class, const class_ctx = switch (mutation) {
             // zig fmt: off
             .move_span => .{ .move_span, null },
@@ -1057,6 +1580,13 @@ const Mutation = enum {
             .packed_set_rng_16be => .{ .rmw, .{ .packed_rng, u16, .big         , {} } },
             .packed_set_rng_32be => .{ .rmw, .{ .packed_rng, u32, .big         , {} } },
             .packed_set_rng_64be => .{ .rmw, .{ .packed_rng, u64, .big         , {} } },
+
+            .replace_cmp_16le    => .{ .cmp, .{ u16, .little, cmp_log2 } },
+            .replace_cmp_32le    => .{ .cmp, .{ u32, .little, cmp_log4 } },
+            .replace_cmp_64le    => .{ .cmp, .{ u64, .little, cmp_log8 } },
+            .replace_cmp_16be    => .{ .cmp, .{ u16, .big   , cmp_log2 } },
+            .replace_cmp_32be    => .{ .cmp, .{ u32, .big   , cmp_log4 } },
+            .replace_cmp_64be    => .{ .cmp, .{ u64, .big   , cmp_log8 } },
             // zig fmt: on
         };
 
@@ -1244,6 +1774,23 @@ const Mutation = enum {
                 mem.bytesAsValue(T, out.items[8..][idx..][0..@sizeOf(T)]).* =
                     mem.nativeTo(T, new, endian);
             },
+            .cmp => {
+                const T, const endian, const pairs = class_ctx;
+                if (pairs.len == 0 or in.len < @sizeOf(T)) return false;
+                const pair = pairs[rng.uintLessThanBiased(usize, pairs.len)];
+                const swap = rng.boolean();
+                const from = mem.toBytes(mem.nativeTo(T, pair[@intFromBool(swap)], endian));
+                const to = pair[@intFromBool(!swap)];
+
+                // Search from a random position so that each occurrence can be replaced
+                const start = rng.uintAtMostBiased(usize, in.len - @sizeOf(T));
+                const idx = mem.indexOfPos(u8, in, start, &from) orelse
+                    mem.indexOf(u8, in[0 .. start + @sizeOf(T) - 1], &from) orelse
+                    return false;
+                out.appendSliceAssumeCapacity(in);
+                mem.bytesAsValue(T, out.items[8..][idx..][0..@sizeOf(T)]).* =
+                    mem.nativeTo(T, to, endian);
+            },
             .move_span => {
                 if (in.len < 2) return false;
                 // One less since moving whole output will never change anything
@@ -24,6 +24,7 @@ pub const Module = @import("Build/Module.zig");
 pub const Watch = @import("Build/Watch.zig");
 pub const Fuzz = @import("Build/Fuzz.zig");
 pub const WebServer = @import("Build/WebServer.zig");
+pub const Trace = @import("Build/Trace.zig");
 pub const abi = @import("Build/abi.zig");
 
 /// Shared state among all Build instances.
@@ -130,6 +131,20 @@ pub const Graph = struct {
     dependency_cache: InitializedDepMap = .empty,
     allow_so_scripts: ?bool = null,
     time_report: bool,
+    /// Only run the unit tests which did not pass the last time their step ran.
+    rerun_failed_tests: bool = false,
+    /// How many processes run the tests of each unit test binary at once.
+    test_jobs: u32 = 1,
+    /// Only run this subset of the tests of each unit test binary.
+    test_shard: ?Step.Run.TestShard = null,
+    /// Idle compiler processes for `Step.Compile` to reuse. `null` means each
+    /// step spawns its own compiler.
+    zig_process_pool: ?*Step.ZigProcessPool = null,
+    /// Records a timeline of the build for `--trace`.
+    trace: ?*Trace = null,
+    /// How many steps were created so far with each `dep_prefix` and name, for
+    /// `Step.key`.
+    step_name_counts: std.StringHashMapUnmanaged(u32) = .empty,
 };
 
 const AvailableDeps = []const struct { []const u8, []const u8 };
@@ -288,23 +303,9 @@ pub fn create(
         .exe_dir = undefined,
         .h_dir = undefined,
         .dest_dir = graph.env_map.get("DESTDIR"),
-        .install_tls = .{
-            .step = .init(.{
-                .id = TopLevelStep.base_id,
-                .name = "install",
-                .owner = b,
-            }),
-            .description = "Copy build artifacts to prefix path",
-        },
-        .uninstall_tls = .{
-            .step = .init(.{
-                .id = TopLevelStep.base_id,
-                .name = "uninstall",
-                .owner = b,
-                .makeFn = makeUninstall,
-            }),
-            .description = "Remove build artifacts from prefix path",
-        },
+        // Initialized by `initTopLevelSteps`, since steps refer to their owner.
+        .install_tls = undefined,
+        .uninstall_tls = undefined,
         .install_path = undefined,
         .args = null,
         .modules = .init(arena),
@@ -314,6 +315,7 @@ pub fn create(
         .available_deps = available_deps,
         .release_mode = .off,
     };
+    b.initTopLevelSteps();
     try b.top_level_steps.put(arena, b.install_tls.step.name, &b.install_tls);
     try b.top_level_steps.put(arena, b.uninstall_tls.step.name, &b.uninstall_tls);
     b.default_step = &b.install_tls.step;
@@ -346,23 +348,9 @@ fn createChildOnly(
     child.* = .{
         .graph = parent.graph,
         .allocator = allocator,
-        .install_tls = .{
-            .step = .init(.{
-                .id = TopLevelStep.base_id,
-                .name = "install",
-                .owner = child,
-            }),
-            .description = "Copy build artifacts to prefix path",
-        },
-        .uninstall_tls = .{
-            .step = .init(.{
-                .id = TopLevelStep.base_id,
-                .name = "uninstall",
-                .owner = child,
-                .makeFn = makeUninstall,
-            }),
-            .description = "Remove build artifacts from prefix path",
-        },
+        // Initialized by `initTopLevelSteps`, since steps refer to their owner.
+        .install_tls = undefined,
+        .uninstall_tls = undefined,
         .user_input_options = user_input_options,
         .available_options_map = AvailableOptionsMap.init(allocator),
         .available_options_list = std.array_list.Managed(AvailableOption).init(allocator),
@@ -407,12 +395,33 @@ fn createChildOnly(
         .available_deps = pkg_deps,
         .release_mode = parent.release_mode,
     };
+    child.initTopLevelSteps();
     try child.top_level_steps.put(allocator, child.install_tls.step.name, &child.install_tls);
     try child.top_level_steps.put(allocator, child.uninstall_tls.step.name, &child.uninstall_tls);
     child.default_step = &child.install_tls.step;
     return child;
 }
 
+fn initTopLevelSteps(b: *Build) void {
+    b.install_tls = .{
+        .step = .init(.{
+            .id = TopLevelStep.base_id,
+            .name = "install",
+            .owner = b,
+        }),
+        .description = "Copy build artifacts to prefix path",
+    };
+    b.uninstall_tls = .{
+        .step = .init(.{
+            .id = TopLevelStep.base_id,
+            .name = "uninstall",
+            .owner = b,
+            .makeFn = makeUninstall,
+        }),
+        .description = "Remove build artifacts from prefix path",
+    };
+}
+
 fn userInputOptionsFromArgs(arena: Allocator, args: anytype) UserInputOptionsMap {
     var map = UserInputOptionsMap.init(arena);
     inline for (@typeInfo(@TypeOf(args)).@"struct".fields) |field| {
@@ -2717,5 +2726,7 @@ pub fn systemIntegrationOption(
 
 test {
     _ = Cache;
+    _ = Fuzz;
     _ = Step;
+    _ = Trace;
 }
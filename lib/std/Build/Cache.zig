@@ -13,6 +13,7 @@ const assert = std.debug.assert;
 const testing = std.testing;
 const mem = std.mem;
 const fmt = std.fmt;
+const math = std.math;
 const Allocator = std.mem.Allocator;
 const log = std.log.scoped(.cache);
 
@@ -31,10 +32,17 @@ mutex: std.Thread.Mutex = .{},
 /// and usefulness of the cache for advanced use cases.
 prefixes_buffer: [4]Directory = undefined,
 prefixes_len: usize = 0,
+/// When set, `Manifest.hit` re-hashes input files whose stat changed
+/// concurrently on this pool instead of one at a time. The manifest lock is
+/// held while waiting for these jobs, so this must not be a pool that runs
+/// tasks which may themselves wait on a manifest lock. When `hit` is called
+/// from one of the workers of this pool, it re-hashes on that thread instead.
+thread_pool: ?*std.Thread.Pool = null,
 
 pub const Path = @import("Cache/Path.zig");
 pub const Directory = @import("Cache/Directory.zig");
 pub const DepTokenizer = @import("Cache/DepTokenizer.zig");
+pub const Remote = @import("Cache/Remote.zig");
 
 pub fn addPrefix(cache: *Cache, directory: Directory) void {
     cache.prefixes_buffer[cache.prefixes_len] = directory;
@@ -124,8 +132,156 @@ pub const BinDigest = [bin_digest_len]u8;
 pub const HexDigest = [hex_digest_len]u8;
 
 /// This is currently just an arbitrary non-empty string that can't match another manifest line.
+/// Manifests in this legacy text format are still read, and are rewritten as `BinaryManifest`
+/// the next time they are written.
 const manifest_header = "0";
-const manifest_file_size_max = 100 * 1024 * 1024;
+pub const manifest_file_size_max = 100 * 1024 * 1024;
+
+/// The on-disk manifest format: a header, one fixed-size record per file, and finally a string
+/// table holding the file paths. Records can be decoded in place without any parsing, and all
+/// integers are little-endian.
+///
+/// The file name keeps its historical `.txt` extension so that a manifest written in the legacy
+/// text format is replaced under the same lock.
+pub const BinaryManifest = struct {
+    pub const magic = [4]u8{ 0x7f, 'Z', 'C', 'M' };
+    pub const version: u32 = 2;
+
+    pub const Header = extern struct {
+        magic: [4]u8 = BinaryManifest.magic,
+        version: u32 = BinaryManifest.version,
+        file_count: u32,
+        string_bytes_len: u32,
+        /// The digest returned by `Manifest.final`, which by convention names the entry's
+        /// output directory in `o`. All zeroes if it was not computed before the manifest was
+        /// written. Used by `gc` to evict a manifest together with its output.
+        output_digest: BinDigest,
+    };
+
+    pub const Record = extern struct {
+        size: u64,
+        inode: u64,
+        mtime: i64,
+        bin_digest: BinDigest,
+        /// Offset of the path relative to the start of the string table.
+        sub_path_offset: u32,
+        sub_path_len: u32,
+        prefix: u8,
+        reserved: [7]u8 = @splat(0),
+    };
+
+    pub fn isBinary(contents: []const u8) bool {
+        return contents.len >= magic.len and mem.eql(u8, contents[0..magic.len], &magic);
+    }
+
+    const INodeBits = std.meta.Int(.unsigned, @bitSizeOf(fs.File.INode));
+
+    fn encodeINode(inode: fs.File.INode) u64 {
+        return @as(INodeBits, @bitCast(inode));
+    }
+
+    fn decodeINode(bits: u64) fs.File.INode {
+        return @bitCast(@as(INodeBits, @truncate(bits)));
+    }
+};
+
+/// Yields the entries of a manifest file in either the binary or the legacy text format.
+const ManifestIterator = union(enum) {
+    text: mem.TokenIterator(u8, .scalar),
+    binary: struct {
+        records: []const u8,
+        string_bytes: []const u8,
+        index: u32,
+        count: u32,
+    },
+
+    const Entry = struct {
+        stat: File.Stat,
+        bin_digest: BinDigest,
+        prefix: u8,
+        /// Expires with the manifest contents.
+        sub_path: []const u8,
+    };
+
+    /// Returns `null` if `contents` is not a manifest in a known format.
+    fn init(contents: []const u8) error{InvalidFormat}!?ManifestIterator {
+        if (BinaryManifest.isBinary(contents)) {
+            if (contents.len < @sizeOf(BinaryManifest.Header)) return error.InvalidFormat;
+            var header = mem.bytesToValue(BinaryManifest.Header, contents[0..@sizeOf(BinaryManifest.Header)]);
+            if (builtin.cpu.arch.endian() != .little) mem.byteSwapAllFields(BinaryManifest.Header, &header);
+            if (header.version != BinaryManifest.version) return null;
+            const records_len = @as(usize, header.file_count) * @sizeOf(BinaryManifest.Record);
+            const rest = contents[@sizeOf(BinaryManifest.Header)..];
+            if (rest.len != records_len + header.string_bytes_len) return error.InvalidFormat;
+            return .{ .binary = .{
+                .records = rest[0..records_len],
+                .string_bytes = rest[records_len..],
+                .index = 0,
+                .count = header.file_count,
+            } };
+        }
+        var line_iter = mem.tokenizeScalar(u8, contents, '\n');
+        const line = line_iter.next() orelse return null;
+        if (!mem.eql(u8, line, manifest_header)) return null;
+        return .{ .text = line_iter };
+    }
+
+    fn next(it: *ManifestIterator) error{InvalidFormat}!?Entry {
+        switch (it.*) {
+            .binary => |*b| {
+                if (b.index == b.count) return null;
+                const record_bytes = b.records[@as(usize, b.index) * @sizeOf(BinaryManifest.Record) ..];
+                var record = mem.bytesToValue(BinaryManifest.Record, record_bytes[0..@sizeOf(BinaryManifest.Record)]);
+                if (builtin.cpu.arch.endian() != .little) mem.byteSwapAllFields(BinaryManifest.Record, &record);
+                b.index += 1;
+                if (@as(u64, record.sub_path_offset) + record.sub_path_len > b.string_bytes.len)
+                    return error.InvalidFormat;
+                return .{
+                    .stat = .{
+                        .size = record.size,
+                        .inode = BinaryManifest.decodeINode(record.inode),
+                        .mtime = .{ .nanoseconds = record.mtime },
+                    },
+                    .bin_digest = record.bin_digest,
+                    .prefix = record.prefix,
+                    .sub_path = b.string_bytes[record.sub_path_offset..][0..record.sub_path_len],
+                };
+            },
+            .text => |*line_iter| {
+                const line = line_iter.next() orelse return null;
+                var iter = mem.tokenizeScalar(u8, line, ' ');
+                const size = iter.next() orelse return error.InvalidFormat;
+                const inode = iter.next() orelse return error.InvalidFormat;
+                const mtime_nsec_str = iter.next() orelse return error.InvalidFormat;
+                const digest_str = iter.next() orelse return error.InvalidFormat;
+                const prefix_str = iter.next() orelse return error.InvalidFormat;
+                const file_path = iter.rest();
+
+                const stat_size = fmt.parseInt(u64, size, 10) catch return error.InvalidFormat;
+                const stat_inode = fmt.parseInt(fs.File.INode, inode, 10) catch return error.InvalidFormat;
+                const stat_mtime = fmt.parseInt(i64, mtime_nsec_str, 10) catch return error.InvalidFormat;
+                const file_bin_digest = b: {
+                    if (digest_str.len != hex_digest_len) return error.InvalidFormat;
+                    var bd: BinDigest = undefined;
+                    _ = fmt.hexToBytes(&bd, digest_str) catch return error.InvalidFormat;
+                    break :b bd;
+                };
+                const prefix = fmt.parseInt(u8, prefix_str, 10) catch return error.InvalidFormat;
+
+                return .{
+                    .stat = .{
+                        .size = stat_size,
+                        .inode = stat_inode,
+                        .mtime = .{ .nanoseconds = stat_mtime },
+                    },
+                    .bin_digest = file_bin_digest,
+                    .prefix = prefix,
+                    .sub_path = file_path,
+                };
+            },
+        }
+    }
+};
 
 /// The type used for hashing file contents. Currently, this is SipHash128(1, 3), because it
 /// provides enough collision resistance for the Manifest use cases, while being one of our
@@ -331,6 +487,12 @@ pub const Manifest = struct {
     /// Keeps track of the last time we performed a file system write to observe
     /// what time the file system thinks it is, according to its own granularity.
     recent_problematic_timestamp: Io.Timestamp = .zero,
+    /// The first digest returned by `finalBin`, recorded in the manifest file.
+    output_digest: BinDigest = @splat(0),
+    /// Set this before calling `hit` to look up local misses in a remote store, and to upload
+    /// the manifest along with its output from `writeManifest`. Requires that the output is
+    /// the directory `o/<digest>` of the bound cache root, named by the digest from `final`.
+    remote: ?Remote.Binding = null,
 
     pub const Diagnostic = union(enum) {
         none,
@@ -594,7 +756,7 @@ pub const Manifest = struct {
         self.hash.hasher.update(&bin_digest);
 
         hit: {
-            const file_digests_populated: usize = digests: {
+            const local_digests_populated: usize = digests: {
                 switch (try self.hitWithCurrentLock()) {
                     .hit => break :hit,
                     .miss => |m| if (!try self.upgradeToExclusiveLock()) {
@@ -616,6 +778,14 @@ pub const Manifest = struct {
                     .miss => |m| break :digests m.file_digests_populated,
                 }
             };
+            const file_digests_populated = if (self.remote) |binding|
+                switch (try self.hitRemote(binding, bin_digest, input_file_count)) {
+                    .hit => break :hit,
+                    // The remote manifest may have left unverified digests behind.
+                    .miss => 0,
+                }
+            else
+                local_digests_populated;
 
             // This is a guaranteed cache miss. We're almost ready to return `false`, but there's a
             // little bookkeeping to do first. The first `file_digests_populated` entries in `files`
@@ -652,20 +822,81 @@ pub const Manifest = struct {
             };
         }
 
+        self.recordUse();
+
         return true;
     }
 
+    /// Bumps the modification time of the manifest file, which `gc` treats as the time the
+    /// entry was last used. To keep cache hits free of file system writes in the common case,
+    /// this only happens once per `access_time_resolution`. Failure merely makes the entry
+    /// look older to `gc`, so it is not reported.
+    fn recordUse(self: *Manifest) void {
+        const manifest_file = self.manifest_file.?;
+        const stat = manifest_file.stat() catch return;
+        const now = Io.Clock.real.now(self.cache.io) catch return;
+        if (stat.mtime.durationTo(now).nanoseconds < access_time_resolution.nanoseconds) return;
+        manifest_file.updateTimes(now, now) catch {};
+    }
+
+    /// Called with the exclusive lock held after a local miss. Checks the manifest from the
+    /// remote store and, if the inputs match, downloads the output and records the manifest
+    /// locally. Problems with the remote store are logged and treated as a miss.
+    fn hitRemote(
+        self: *Manifest,
+        binding: Remote.Binding,
+        bin_digest: BinDigest,
+        input_file_count: usize,
+    ) HitError!enum { hit, miss } {
+        const gpa = self.cache.gpa;
+        const contents = binding.remote.fetchManifest(gpa, &self.hex_digest) catch |err| switch (err) {
+            error.OutOfMemory => return error.OutOfMemory,
+            else => {
+                log.warn("unable to fetch manifest {s} from remote cache: {t}", .{ &self.hex_digest, err });
+                return .miss;
+            },
+        } orelse return .miss;
+        defer gpa.free(contents);
+
+        self.hash.hasher = hasher_init;
+        self.hash.hasher.update(&bin_digest);
+        while (self.files.count() != input_file_count) {
+            var file = self.files.pop().?;
+            file.key.deinit(gpa);
+        }
+        const result = self.hitWithContents(contents) catch |err| switch (err) {
+            error.OutOfMemory => return error.OutOfMemory,
+            // The manifest was written for a different set of inputs, such as on another OS.
+            error.CacheCheckFailed, error.InvalidFormat => {
+                self.diagnostic = .none;
+                return .miss;
+            },
+        };
+        if (result == .miss) return .miss;
+
+        const output_digest = self.hash.hasher.peek();
+        binding.remote.fetchOutput(gpa, binding.cache_root, &binToHex(output_digest)) catch |err| {
+            log.warn("unable to fetch output {s} from remote cache: {t}", .{ &binToHex(output_digest), err });
+            return .miss;
+        };
+
+        // Record the manifest locally, with the stats of the local files. The entry came from the
+        // remote store, so there is nothing to upload.
+        self.remote = null;
+        self.output_digest = output_digest;
+        self.manifest_dirty = true;
+        self.writeManifest() catch |err| {
+            log.warn("unable to write manifest {s}: {t}", .{ &self.hex_digest, err });
+            self.manifest_file.?.setEndPos(0) catch {};
+        };
+        return .hit;
+    }
+
     /// Assumes that `self.hash.hasher` has been updated only with the original digest and that
     /// `self.files` contains only the original input files.
-    fn hitWithCurrentLock(self: *Manifest) HitError!union(enum) {
-        hit,
-        miss: struct {
-            file_digests_populated: usize,
-        },
-    } {
+    fn hitWithCurrentLock(self: *Manifest) HitError!HitResult {
         const gpa = self.cache.gpa;
         const io = self.cache.io;
-        const input_file_count = self.files.entries.len;
         var tiny_buffer: [1]u8 = undefined; // allows allocRemaining to detect limit exceeded
         var manifest_reader = self.manifest_file.?.reader(io, &tiny_buffer); // Reads positionally from zero.
         const limit: std.Io.Limit = .limited(manifest_file_size_max);
@@ -678,44 +909,47 @@ pub const Manifest = struct {
             },
         };
         defer gpa.free(file_contents);
+        return self.hitWithContents(file_contents);
+    }
+
+    const HitResult = union(enum) {
+        hit,
+        miss: struct {
+            file_digests_populated: usize,
+        },
+    };
+
+    /// Like `hitWithCurrentLock`, but checks the manifest `file_contents` instead of the one on
+    /// disk.
+    fn hitWithContents(self: *Manifest, file_contents: []const u8) HitError!HitResult {
+        const gpa = self.cache.gpa;
+        const input_file_count = self.files.entries.len;
+
+        // The `files` index of the entry each manifest line refers to. Pointers into `files` are
+        // not stable while the manifest is being read, as "post" files are appended to it.
+        var line_files: std.ArrayListUnmanaged(usize) = .empty;
+        defer line_files.deinit(gpa);
+        // Files whose stat no longer matches the manifest. They are hashed together once the
+        // whole manifest has been read, so that they can be processed concurrently.
+        var rehash_jobs: std.ArrayListUnmanaged(RehashJob) = .empty;
+        defer rehash_jobs.deinit(gpa);
+        var missing_file_idx: ?usize = null;
 
         var any_file_changed = false;
-        var line_iter = mem.tokenizeScalar(u8, file_contents, '\n');
         var idx: usize = 0;
-        const header_valid = valid: {
-            const line = line_iter.next() orelse break :valid false;
-            break :valid std.mem.eql(u8, line, manifest_header);
-        };
-        if (!header_valid) {
+        var manifest_iter = try ManifestIterator.init(file_contents) orelse {
             return .{ .miss = .{ .file_digests_populated = 0 } };
-        }
-        while (line_iter.next()) |line| {
+        };
+        while (try manifest_iter.next()) |entry| {
             defer idx += 1;
 
-            var iter = mem.tokenizeScalar(u8, line, ' ');
-            const size = iter.next() orelse return error.InvalidFormat;
-            const inode = iter.next() orelse return error.InvalidFormat;
-            const mtime_nsec_str = iter.next() orelse return error.InvalidFormat;
-            const digest_str = iter.next() orelse return error.InvalidFormat;
-            const prefix_str = iter.next() orelse return error.InvalidFormat;
-            const file_path = iter.rest();
-
-            const stat_size = fmt.parseInt(u64, size, 10) catch return error.InvalidFormat;
-            const stat_inode = fmt.parseInt(fs.File.INode, inode, 10) catch return error.InvalidFormat;
-            const stat_mtime = fmt.parseInt(i64, mtime_nsec_str, 10) catch return error.InvalidFormat;
-            const file_bin_digest = b: {
-                if (digest_str.len != hex_digest_len) return error.InvalidFormat;
-                var bd: BinDigest = undefined;
-                _ = fmt.hexToBytes(&bd, digest_str) catch return error.InvalidFormat;
-                break :b bd;
-            };
-
-            const prefix = fmt.parseInt(u8, prefix_str, 10) catch return error.InvalidFormat;
+            const prefix = entry.prefix;
+            const file_path = entry.sub_path;
             if (prefix >= self.cache.prefixes_len) return error.InvalidFormat;
 
             if (file_path.len == 0) return error.InvalidFormat;
 
-            const cache_hash_file = f: {
+            const file_index = f: {
                 const prefixed_path: PrefixedPath = .{
                     .prefix = prefix,
                     .sub_path = file_path, // expires with file_contents
@@ -725,13 +959,9 @@ pub const Manifest = struct {
                     if (!file.prefixed_path.eql(prefixed_path))
                         return error.InvalidFormat;
 
-                    file.stat = .{
-                        .size = stat_size,
-                        .inode = stat_inode,
-                        .mtime = .{ .nanoseconds = stat_mtime },
-                    };
-                    file.bin_digest = file_bin_digest;
-                    break :f file;
+                    file.stat = entry.stat;
+                    file.bin_digest = entry.bin_digest;
+                    break :f idx;
                 }
                 const gop = try self.files.getOrPutAdapted(gpa, prefixed_path, FilesAdapter{});
                 errdefer _ = self.files.pop();
@@ -744,23 +974,24 @@ pub const Manifest = struct {
                         .contents = null,
                         .max_file_size = null,
                         .handle = null,
-                        .stat = .{
-                            .size = stat_size,
-                            .inode = stat_inode,
-                            .mtime = .{ .nanoseconds = stat_mtime },
-                        },
-                        .bin_digest = file_bin_digest,
+                        .stat = entry.stat,
+                        .bin_digest = entry.bin_digest,
                     };
                 }
-                break :f gop.key_ptr;
+                break :f gop.index;
             };
+            try line_files.append(gpa, file_index);
+            const cache_hash_file = &self.files.keys()[file_index];
 
             const pp = cache_hash_file.prefixed_path;
             const dir = self.cache.prefixes()[pp.prefix].handle;
             const this_file = dir.openFile(pp.sub_path, .{ .mode = .read_only }) catch |err| switch (err) {
                 error.FileNotFound => {
-                    // Every digest before this one has been populated successfully.
-                    return .{ .miss = .{ .file_digests_populated = idx } };
+                    // Every digest before this one will have been populated once the
+                    // pending rehash jobs complete.
+                    line_files.items.len -= 1;
+                    missing_file_idx = idx;
+                    break;
                 },
                 else => |e| {
                     self.diagnostic = .{ .file_open = .{
@@ -796,17 +1027,48 @@ pub const Manifest = struct {
                     cache_hash_file.stat.inode = 0;
                 }
 
-                var actual_digest: BinDigest = undefined;
-                hashFile(this_file, &actual_digest) catch |err| {
-                    self.diagnostic = .{ .file_read = .{
-                        .file_index = idx,
-                        .err = err,
-                    } };
-                    return error.CacheCheckFailed;
-                };
+                try rehash_jobs.append(gpa, .{
+                    .line_index = idx,
+                    .dir = dir,
+                    .sub_path = pp.sub_path,
+                });
+            }
+        }
+
+        const rehash_pool = if (self.cache.thread_pool) |thread_pool|
+            // Waiting on a worker could leave no thread to run the jobs.
+            if (thread_pool.isWorker()) null else thread_pool
+        else
+            null;
+        if (rehash_pool != null and rehash_jobs.items.len > 1) {
+            const thread_pool = rehash_pool.?;
+            var wait_group: std.Thread.WaitGroup = .{};
+            // Only wait here rather than helping out with other tasks of the
+            // pool, which must not run while this manifest is locked.
+            defer thread_pool.wait(&wait_group);
+            for (rehash_jobs.items[1..]) |*job| thread_pool.spawnWg(&wait_group, RehashJob.run, .{job});
+            rehash_jobs.items[0].run();
+        } else {
+            for (rehash_jobs.items) |*job| job.run();
+        }
 
-                if (!mem.eql(u8, &cache_hash_file.bin_digest, &actual_digest)) {
-                    cache_hash_file.bin_digest = actual_digest;
+        // Now that every digest is known, walk the manifest lines again in order.
+        var pending_jobs = rehash_jobs.items;
+        for (line_files.items, 0..) |file_index, line_index| {
+            const cache_hash_file = &self.files.keys()[file_index];
+
+            if (pending_jobs.len > 0 and pending_jobs[0].line_index == line_index) {
+                const job = &pending_jobs[0];
+                pending_jobs = pending_jobs[1..];
+                if (job.err) |err| {
+                    self.diagnostic = if (job.opened)
+                        .{ .file_read = .{ .file_index = line_index, .err = err } }
+                    else
+                        .{ .file_open = .{ .file_index = line_index, .err = err } };
+                    return error.CacheCheckFailed;
+                }
+                if (!mem.eql(u8, &cache_hash_file.bin_digest, &job.digest)) {
+                    cache_hash_file.bin_digest = job.digest;
                     // keep going until we have the input file digests
                     any_file_changed = true;
                 }
@@ -817,6 +1079,11 @@ pub const Manifest = struct {
             }
         }
 
+        if (missing_file_idx) |missing_idx| {
+            // Every digest before the missing file has been populated successfully.
+            return .{ .miss = .{ .file_digests_populated = missing_idx } };
+        }
+
         // If the manifest was somehow missing one of our input files, or if any file hash has changed,
         // then this is a cache miss. However, we have successfully populated some or all of the file
         // digests.
@@ -827,6 +1094,29 @@ pub const Manifest = struct {
         return .hit;
     }
 
+    /// Re-hashes one input file whose stat changed since the manifest was written.
+    const RehashJob = struct {
+        line_index: usize,
+        dir: fs.Dir,
+        sub_path: []const u8,
+        digest: BinDigest = undefined,
+        err: ?anyerror = null,
+        /// Distinguishes a failure to open the file from a failure to read it.
+        opened: bool = false,
+
+        fn run(job: *RehashJob) void {
+            const file = job.dir.openFile(job.sub_path, .{ .mode = .read_only }) catch |err| {
+                job.err = err;
+                return;
+            };
+            defer file.close();
+            job.opened = true;
+            hashFile(file, &job.digest) catch |err| {
+                job.err = err;
+            };
+        }
+    };
+
     /// Reset `self.hash.hasher` to the state it should be in after `hit` returns `false`.
     /// The hasher contains the original input digest, and all original input file digests (i.e.
     /// not including post files).
@@ -1106,6 +1396,7 @@ pub const Manifest = struct {
 
         var bin_digest: BinDigest = undefined;
         self.hash.hasher.final(&bin_digest);
+        if (mem.allEqual(u8, &self.output_digest, 0)) self.output_digest = bin_digest;
         return bin_digest;
     }
 
@@ -1130,6 +1421,8 @@ pub const Manifest = struct {
                 error.WriteFailed => return fw.err.?,
                 else => |e| return e,
             };
+
+            if (self.remote) |binding| self.storeRemote(binding);
         }
 
         if (self.want_shared_lock) {
@@ -1137,18 +1430,58 @@ pub const Manifest = struct {
         }
     }
 
+    /// Failure only means that other machines miss, so it is logged rather than reported.
+    fn storeRemote(self: *Manifest, binding: Remote.Binding) void {
+        if (mem.allEqual(u8, &self.output_digest, 0)) return;
+        const gpa = self.cache.gpa;
+        const io = self.cache.io;
+
+        var tiny_buffer: [1]u8 = undefined;
+        var manifest_reader = self.manifest_file.?.reader(io, &tiny_buffer);
+        const contents = manifest_reader.interface.allocRemaining(gpa, .limited(manifest_file_size_max)) catch |err| {
+            log.warn("unable to read manifest {s}: {t}", .{ &self.hex_digest, err });
+            return;
+        };
+        defer gpa.free(contents);
+
+        binding.remote.store(gpa, io, &self.hex_digest, contents, binding.cache_root, &binToHex(self.output_digest)) catch |err| {
+            log.warn("unable to upload manifest {s} to remote cache: {t}", .{ &self.hex_digest, err });
+        };
+    }
+
     fn writeDirtyManifestToStream(self: *Manifest, fw: *fs.File.Writer) !void {
-        try fw.interface.writeAll(manifest_header ++ "\n");
-        for (self.files.keys()) |file| {
-            try fw.interface.print("{d} {d} {d} {x} {d} {s}\n", .{
-                file.stat.size,
-                file.stat.inode,
-                file.stat.mtime,
-                &file.bin_digest,
-                file.prefixed_path.prefix,
-                file.prefixed_path.sub_path,
-            });
+        const files = self.files.keys();
+
+        var string_bytes_len: usize = 0;
+        for (files) |file| string_bytes_len += file.prefixed_path.sub_path.len;
+
+        var header: BinaryManifest.Header = .{
+            .file_count = math.cast(u32, files.len) orelse return error.FileTooBig,
+            .string_bytes_len = math.cast(u32, string_bytes_len) orelse return error.FileTooBig,
+            .output_digest = self.output_digest,
+        };
+        if (builtin.cpu.arch.endian() != .little) mem.byteSwapAllFields(BinaryManifest.Header, &header);
+        try fw.interface.writeAll(mem.asBytes(&header));
+
+        var sub_path_offset: u32 = 0;
+        for (files) |file| {
+            const sub_path_len: u32 = @intCast(file.prefixed_path.sub_path.len);
+            var record: BinaryManifest.Record = .{
+                .size = file.stat.size,
+                .inode = BinaryManifest.encodeINode(file.stat.inode),
+                // Timestamps that do not fit never match, so the file is simply re-hashed.
+                .mtime = math.cast(i64, file.stat.mtime.nanoseconds) orelse 0,
+                .bin_digest = file.bin_digest,
+                .sub_path_offset = sub_path_offset,
+                .sub_path_len = sub_path_len,
+                .prefix = file.prefixed_path.prefix,
+            };
+            if (builtin.cpu.arch.endian() != .little) mem.byteSwapAllFields(BinaryManifest.Record, &record);
+            try fw.interface.writeAll(mem.asBytes(&record));
+            sub_path_offset += sub_path_len;
         }
+
+        for (files) |file| try fw.interface.writeAll(file.prefixed_path.sub_path);
         try fw.end();
     }
 
@@ -1291,8 +1624,292 @@ pub fn writeSmallFile(dir: fs.Dir, sub_path: []const u8, data: []const u8) !void
     }
 }
 
+/// Granularity of the last-use time that `Manifest.hit` records for `gc`.
+pub const access_time_resolution: Io.Duration = .fromSeconds(std.time.s_per_hour);
+
+/// Subdirectory of a cache directory holding files that are looked up by their contents,
+/// such as the files shared between fetched packages, rather than recorded by a manifest.
+/// Each file is an entry of its own for `gc`, aged by its modification time, which users of
+/// the store bump when they use a file. Deleting one never breaks anything but sharing.
+pub const file_store_sub_path = "s";
+
+pub const GcResult = struct {
+    /// Combined size of the `h`, `o` and `s` subdirectories before and after collection.
+    bytes_before: u64,
+    bytes_after: u64,
+    evicted_count: usize,
+};
+
+/// Evicts the least recently used entries of the cache directory `cache_root` until its `h`,
+/// `o` and `s` subdirectories take up at most `max_bytes`, or no more entries can be evicted.
+///
+/// An entry is a manifest file in `h` together with the output directory in `o` that it
+/// records (see `BinaryManifest.Header.output_digest`); outputs that no manifest refers to are
+/// entries of their own, aged by their most recently modified file. Such outputs are only
+/// deleted once no manifest is left that does not record its output, as is the case for
+/// manifests in the legacy text format, since they might be that manifest's output. Each file
+/// in `file_store_sub_path` is an entry too. This is safe to run concurrently with builds
+/// using the same cache:
+/// * Manifests that are locked, meaning some process is using them or their output, are
+///   skipped. Evicting a manifest happens with its lock held, and the manifest is emptied
+///   before it is unlinked, so a process waiting for the lock observes a miss.
+/// * Entries used within twice `access_time_resolution` are never evicted, which covers
+///   outputs that a running build hit but no longer holds the lock of.
+///
+/// Other subdirectories, such as `p` and `tmp`, are neither measured nor collected.
+pub fn gc(gpa: Allocator, io: Io, cache_root: fs.Dir, max_bytes: u64) !GcResult {
+    var arena_state: std.heap.ArenaAllocator = .init(gpa);
+    defer arena_state.deinit();
+    const arena = arena_state.allocator();
+
+    var h_dir: ?fs.Dir = cache_root.openDir("h", .{ .iterate = true }) catch |err| switch (err) {
+        error.FileNotFound => null,
+        else => |e| return e,
+    };
+    defer if (h_dir) |*dir| dir.close();
+    var o_dir: ?fs.Dir = cache_root.openDir("o", .{ .iterate = true }) catch |err| switch (err) {
+        error.FileNotFound => null,
+        else => |e| return e,
+    };
+    defer if (o_dir) |*dir| dir.close();
+    var s_dir: ?fs.Dir = cache_root.openDir(file_store_sub_path, .{ .iterate = true }) catch |err| switch (err) {
+        error.FileNotFound => null,
+        else => |e| return e,
+    };
+    defer if (s_dir) |*dir| dir.close();
+
+    const GcEntry = struct {
+        last_used: Io.Timestamp,
+        bytes: u64,
+        /// Name of the manifest file in `h`, or `null` for an unreferenced output.
+        manifest: ?[]const u8,
+        /// Name of the output in `o`, if it exists.
+        output: ?[]const u8,
+        /// Whether this is a manifest that does not record its output.
+        unknown_output: bool = false,
+        /// Name of the file in `file_store_sub_path`, for an entry of the store.
+        store_file: ?[]const u8 = null,
+
+        fn lessThan(_: void, lhs: @This(), rhs: @This()) bool {
+            return lhs.last_used.nanoseconds < rhs.last_used.nanoseconds;
+        }
+    };
+
+    const Output = struct {
+        bytes: u64,
+        last_modified: Io.Timestamp,
+        referenced: bool = false,
+    };
+    var outputs: std.StringArrayHashMapUnmanaged(Output) = .empty;
+    if (o_dir) |dir| {
+        var it = dir.iterate();
+        while (try it.next()) |entry| {
+            const usage = diskUsage(gpa, dir, entry.name, entry.kind) catch |err| {
+                log.warn("unable to measure cache output '{s}': {t}", .{ entry.name, err });
+                continue;
+            };
+            try outputs.put(arena, try arena.dupe(u8, entry.name), .{
+                .bytes = usage.bytes,
+                .last_modified = usage.last_modified,
+            });
+        }
+    }
+
+    var entries: std.ArrayListUnmanaged(GcEntry) = .empty;
+    // Manifests whose output is unknown; while any are left, unreferenced outputs are kept.
+    var unknown_output_count: usize = 0;
+    if (h_dir) |dir| {
+        var it = dir.iterate();
+        while (try it.next()) |entry| {
+            if (entry.kind != .file or !isManifestName(entry.name)) continue;
+            const file = dir.openFile(entry.name, .{}) catch continue;
+            defer file.close();
+            const stat = file.stat() catch continue;
+            var gc_entry: GcEntry = .{
+                .last_used = stat.mtime,
+                .bytes = stat.size,
+                .manifest = try arena.dupe(u8, entry.name),
+                .output = null,
+            };
+            // Read without the lock; `evictManifest` reads it again before deleting anything.
+            if (readOutputDigest(file)) |digest| {
+                const hex = binToHex(digest);
+                if (outputs.getEntry(&hex)) |output| {
+                    output.value_ptr.referenced = true;
+                    gc_entry.bytes += output.value_ptr.bytes;
+                    gc_entry.output = output.key_ptr.*;
+                }
+            } else {
+                gc_entry.unknown_output = true;
+                unknown_output_count += 1;
+            }
+            try entries.append(arena, gc_entry);
+        }
+    }
+    for (outputs.keys(), outputs.values()) |name, output| {
+        if (output.referenced) continue;
+        try entries.append(arena, .{
+            .last_used = output.last_modified,
+            .bytes = output.bytes,
+            .manifest = null,
+            .output = name,
+        });
+    }
+    if (s_dir) |dir| {
+        var it = dir.iterate();
+        while (try it.next()) |entry| {
+            if (entry.kind != .file) continue;
+            const stat = dir.statFile(entry.name) catch continue;
+            try entries.append(arena, .{
+                .last_used = stat.mtime,
+                .bytes = stat.size,
+                .manifest = null,
+                .output = null,
+                .store_file = try arena.dupe(u8, entry.name),
+            });
+        }
+    }
+
+    var total_bytes: u64 = 0;
+    for (entries.items) |entry| total_bytes += entry.bytes;
+    var result: GcResult = .{
+        .bytes_before = total_bytes,
+        .bytes_after = total_bytes,
+        .evicted_count = 0,
+    };
+    if (total_bytes <= max_bytes) return result;
+
+    const now = try Io.Clock.real.now(io);
+    const cutoff = now.subDuration(.{ .nanoseconds = 2 * access_time_resolution.nanoseconds });
+
+    mem.sortUnstable(GcEntry, entries.items, {}, GcEntry.lessThan);
+    for (entries.items) |entry| {
+        if (result.bytes_after <= max_bytes) break;
+        if (entry.last_used.nanoseconds >= cutoff.nanoseconds) break;
+        if (entry.manifest) |manifest_name| {
+            if (!try evictManifest(h_dir.?, o_dir, manifest_name)) continue;
+            if (entry.unknown_output) unknown_output_count -= 1;
+        } else if (entry.store_file) |name| {
+            s_dir.?.deleteFile(name) catch |err| {
+                log.warn("unable to delete cache store file '{s}': {t}", .{ name, err });
+                continue;
+            };
+        } else {
+            if (unknown_output_count > 0) continue;
+            o_dir.?.deleteTree(entry.output.?) catch |err| {
+                log.warn("unable to delete cache output '{s}': {t}", .{ entry.output.?, err });
+                continue;
+            };
+        }
+        result.bytes_after -= entry.bytes;
+        result.evicted_count += 1;
+    }
+    return result;
+}
+
+/// Minimum time between two collections of the same cache directory by `gcIfDue`.
+pub const gc_interval: Io.Duration = access_time_resolution;
+
+/// Name of the file in a cache directory whose modification time records when `gcIfDue` last
+/// started a collection of it.
+const gc_stamp_name = "gc";
+
+/// Like `gc`, but does nothing and returns `null` if the previous collection of `cache_root`
+/// started by this function began less than `gc_interval` ago. This makes it cheap to call
+/// after every build.
+pub fn gcIfDue(gpa: Allocator, io: Io, cache_root: fs.Dir, max_bytes: u64) !?GcResult {
+    const now = try Io.Clock.real.now(io);
+    if (cache_root.statFile(gc_stamp_name)) |stat| {
+        if (stat.mtime.nanoseconds > now.subDuration(gc_interval).nanoseconds) return null;
+    } else |err| switch (err) {
+        error.FileNotFound => {},
+        else => |e| return e,
+    }
+    {
+        const stamp = try cache_root.createFile(gc_stamp_name, .{});
+        defer stamp.close();
+        try stamp.updateTimes(now, now);
+    }
+    return try gc(gpa, io, cache_root, max_bytes);
+}
+
+fn isManifestName(name: []const u8) bool {
+    const ext = ".txt";
+    if (name.len != hex_digest_len + ext.len or !mem.endsWith(u8, name, ext)) return false;
+    for (name[0..hex_digest_len]) |c| switch (c) {
+        '0'...'9', 'a'...'f' => {},
+        else => return false,
+    };
+    return true;
+}
+
+/// Returns `null` for manifests that do not record their output, such as ones in the legacy
+/// text format.
+fn readOutputDigest(manifest_file: fs.File) ?BinDigest {
+    var header_bytes: [@sizeOf(BinaryManifest.Header)]u8 = undefined;
+    const n = manifest_file.preadAll(&header_bytes, 0) catch return null;
+    if (n != header_bytes.len or !BinaryManifest.isBinary(&header_bytes)) return null;
+    var header = mem.bytesToValue(BinaryManifest.Header, &header_bytes);
+    if (builtin.cpu.arch.endian() != .little) mem.byteSwapAllFields(BinaryManifest.Header, &header);
+    if (header.version != BinaryManifest.version) return null;
+    if (mem.allEqual(u8, &header.output_digest, 0)) return null;
+    return header.output_digest;
+}
+
+/// Returns `false` if the manifest is in use.
+fn evictManifest(h_dir: fs.Dir, o_dir: ?fs.Dir, manifest_name: []const u8) !bool {
+    const manifest_file = h_dir.openFile(manifest_name, .{
+        .mode = .read_write,
+        .lock = .exclusive,
+        .lock_nonblocking = true,
+    }) catch |err| switch (err) {
+        error.WouldBlock => return false,
+        error.FileNotFound => return true,
+        else => |e| return e,
+    };
+    defer {
+        // See `Lock.release` for why this is required on Windows.
+        if (builtin.os.tag == .windows) manifest_file.unlock();
+        manifest_file.close();
+    }
+
+    const output_digest = readOutputDigest(manifest_file);
+    // Processes that opened the manifest before it is unlinked below may be waiting for the
+    // lock; an empty manifest makes them see a miss rather than a hit on a deleted output.
+    try manifest_file.setEndPos(0);
+    if (output_digest) |digest| if (o_dir) |dir| try dir.deleteTree(&binToHex(digest));
+    try h_dir.deleteFile(manifest_name);
+    return true;
+}
+
+/// Total size of the files in `sub_path` and the most recent modification time among them.
+fn diskUsage(
+    gpa: Allocator,
+    dir: fs.Dir,
+    sub_path: []const u8,
+    kind: fs.File.Kind,
+) !struct { bytes: u64, last_modified: Io.Timestamp } {
+    const stat = try dir.statFile(sub_path);
+    var bytes: u64 = 0;
+    var last_modified = stat.mtime;
+    if (kind != .directory) return .{ .bytes = stat.size, .last_modified = last_modified };
+
+    var sub_dir = try dir.openDir(sub_path, .{ .iterate = true });
+    defer sub_dir.close();
+    var walker = try sub_dir.walk(gpa);
+    defer walker.deinit();
+    while (try walker.next()) |entry| {
+        const entry_stat = entry.dir.statFile(entry.basename) catch continue;
+        if (entry.kind != .directory) bytes += entry_stat.size;
+        if (entry_stat.mtime.nanoseconds > last_modified.nanoseconds) last_modified = entry_stat.mtime;
+    }
+    return .{ .bytes = bytes, .last_modified = last_modified };
+}
+
 fn hashFile(file: fs.File, bin_digest: *[Hasher.mac_length]u8) fs.File.PReadError!void {
-    var buf: [1024]u8 = undefined;
+    // Large reads amortize the syscall overhead, which otherwise dominates for
+    // multi-megabyte inputs such as archives and object files.
+    var buf: [64 * 1024]u8 = undefined;
     var hasher = hasher_init;
     var off: u64 = 0;
     while (true) {
@@ -1456,6 +2073,195 @@ test "check that changing a file makes cache fail" {
     }
 }
 
+test "files with changed stat are rehashed on the thread pool" {
+    const io = std.testing.io;
+
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    const temp_files = [_][]const u8{ "rehash_a.txt", "rehash_b.txt", "rehash_c.txt" };
+    const temp_manifest_dir = "cache_rehash_manifest_dir";
+
+    for (temp_files) |temp_file| {
+        try tmp.dir.writeFile(.{ .sub_path = temp_file, .data = temp_file });
+    }
+
+    var thread_pool: std.Thread.Pool = undefined;
+    try thread_pool.init(.{ .allocator = testing.allocator, .n_jobs = 2 });
+    defer thread_pool.deinit();
+
+    var cache: Cache = .{
+        .io = io,
+        .gpa = testing.allocator,
+        .manifest_dir = try tmp.dir.makeOpenPath(temp_manifest_dir, .{}),
+        .thread_pool = &thread_pool,
+    };
+    cache.addPrefix(.{ .path = null, .handle = tmp.dir });
+    defer cache.manifest_dir.close();
+
+    var digest1: HexDigest = undefined;
+    {
+        var ch = cache.obtain();
+        defer ch.deinit();
+
+        for (temp_files) |temp_file| _ = try ch.addFile(temp_file, null);
+        try testing.expectEqual(false, try ch.hit());
+        digest1 = ch.final();
+        try ch.writeManifest();
+    }
+
+    // Wait for file timestamps to tick, then rewrite every file with the same contents.
+    const initial_time = try testGetCurrentFileTimestamp(tmp.dir);
+    while ((try testGetCurrentFileTimestamp(tmp.dir)).nanoseconds == initial_time.nanoseconds) {
+        try std.Io.Clock.Duration.sleep(.{ .clock = .boot, .raw = .fromNanoseconds(1) }, io);
+    }
+    for (temp_files) |temp_file| {
+        try tmp.dir.writeFile(.{ .sub_path = temp_file, .data = temp_file });
+    }
+
+    {
+        var ch = cache.obtain();
+        defer ch.deinit();
+
+        for (temp_files) |temp_file| _ = try ch.addFile(temp_file, null);
+        // Only the stat changed, so after re-hashing this is still a hit.
+        try testing.expectEqual(true, try ch.hit());
+        try testing.expectEqualStrings(&digest1, &ch.final());
+    }
+
+    try tmp.dir.writeFile(.{ .sub_path = temp_files[1], .data = "updated" });
+
+    {
+        var ch = cache.obtain();
+        defer ch.deinit();
+
+        for (temp_files) |temp_file| _ = try ch.addFile(temp_file, null);
+        try testing.expectEqual(false, try ch.hit());
+        const digest2 = ch.final();
+        try testing.expect(!mem.eql(u8, &digest1, &digest2));
+    }
+}
+
+test "hit on a worker of the cache thread pool re-hashes on that worker" {
+    const io = std.testing.io;
+
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    const temp_files = [_][]const u8{ "worker_a.txt", "worker_b.txt", "worker_c.txt" };
+    const temp_manifest_dir = "cache_worker_manifest_dir";
+
+    for (temp_files) |temp_file| {
+        try tmp.dir.writeFile(.{ .sub_path = temp_file, .data = temp_file });
+    }
+
+    // With a single worker, a hit on it that waited for jobs queued on the
+    // same pool would never return.
+    var thread_pool: std.Thread.Pool = undefined;
+    try thread_pool.init(.{ .allocator = testing.allocator, .n_jobs = 1 });
+    defer thread_pool.deinit();
+
+    var cache: Cache = .{
+        .io = io,
+        .gpa = testing.allocator,
+        .manifest_dir = try tmp.dir.makeOpenPath(temp_manifest_dir, .{}),
+        .thread_pool = &thread_pool,
+    };
+    cache.addPrefix(.{ .path = null, .handle = tmp.dir });
+    defer cache.manifest_dir.close();
+
+    const Job = struct {
+        fn run(c: *Cache, files: []const []const u8, result: *anyerror!bool) void {
+            result.* = hit(c, files);
+        }
+
+        fn hit(c: *Cache, files: []const []const u8) !bool {
+            var ch = c.obtain();
+            defer ch.deinit();
+
+            for (files) |file| _ = try ch.addFile(file, null);
+            const is_hit = try ch.hit();
+            if (!is_hit) try ch.writeManifest();
+            return is_hit;
+        }
+    };
+
+    try testing.expectEqual(false, try Job.hit(&cache, &temp_files));
+
+    // Wait for file timestamps to tick, then rewrite every file with the same contents.
+    const initial_time = try testGetCurrentFileTimestamp(tmp.dir);
+    while ((try testGetCurrentFileTimestamp(tmp.dir)).nanoseconds == initial_time.nanoseconds) {
+        try std.Io.Clock.Duration.sleep(.{ .clock = .boot, .raw = .fromNanoseconds(1) }, io);
+    }
+    for (temp_files) |temp_file| {
+        try tmp.dir.writeFile(.{ .sub_path = temp_file, .data = temp_file });
+    }
+
+    var result: anyerror!bool = undefined;
+    var wait_group: std.Thread.WaitGroup = .{};
+    thread_pool.spawnWg(&wait_group, Job.run, .{ &cache, &temp_files, &result });
+    // Only wait, so that the rehash jobs could not be run by this thread.
+    wait_group.wait();
+    try testing.expectEqual(true, try result);
+}
+
+test "legacy text manifests are still read" {
+    const io = std.testing.io;
+
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    const temp_file = "legacy_manifest_input.txt";
+    const temp_manifest_dir = "legacy_manifest_dir";
+    try tmp.dir.writeFile(.{ .sub_path = temp_file, .data = "Hello, world!\n" });
+
+    var cache: Cache = .{
+        .io = io,
+        .gpa = testing.allocator,
+        .manifest_dir = try tmp.dir.makeOpenPath(temp_manifest_dir, .{}),
+    };
+    cache.addPrefix(.{ .path = null, .handle = tmp.dir });
+    defer cache.manifest_dir.close();
+
+    var digest1: HexDigest = undefined;
+    var text_manifest: std.ArrayListUnmanaged(u8) = .empty;
+    defer text_manifest.deinit(testing.allocator);
+    var manifest_name: [hex_digest_len + ".txt".len]u8 = undefined;
+    {
+        var ch = cache.obtain();
+        defer ch.deinit();
+
+        ch.hash.addBytes("1234");
+        _ = try ch.addFile(temp_file, null);
+        try testing.expectEqual(false, try ch.hit());
+        digest1 = ch.final();
+        try ch.writeManifest();
+
+        _ = try fmt.bufPrint(&manifest_name, "{s}.txt", .{&ch.hex_digest});
+        const file = ch.files.keys()[0];
+        try text_manifest.print(testing.allocator, manifest_header ++ "\n{d} {d} {d} {x} {d} {s}\n", .{
+            file.stat.size,
+            file.stat.inode,
+            file.stat.mtime.nanoseconds,
+            &file.bin_digest,
+            file.prefixed_path.prefix,
+            file.prefixed_path.sub_path,
+        });
+    }
+
+    try cache.manifest_dir.writeFile(.{ .sub_path = &manifest_name, .data = text_manifest.items });
+
+    {
+        var ch = cache.obtain();
+        defer ch.deinit();
+
+        ch.hash.addBytes("1234");
+        _ = try ch.addFile(temp_file, null);
+        try testing.expectEqual(true, try ch.hit());
+        try testing.expectEqualStrings(&digest1, &ch.final());
+    }
+}
+
 test "no file inputs" {
     const io = testing.io;
 
@@ -1592,3 +2398,157 @@ test "Manifest with files added after initial hash work" {
         try testing.expect(!mem.eql(u8, &digest1, &digest3));
     }
 }
+
+test "gc evicts least recently used entries" {
+    const io = std.testing.io;
+    const gpa = testing.allocator;
+
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    var cache: Cache = .{
+        .io = io,
+        .gpa = gpa,
+        .manifest_dir = try tmp.dir.makeOpenPath("h", .{}),
+    };
+    defer cache.manifest_dir.close();
+    var o_dir = try tmp.dir.makeOpenPath("o", .{});
+    defer o_dir.close();
+
+    const now = try Io.Clock.real.now(io);
+    const days_ago = [_]i64{ 2, 3, 0 };
+    var digests: [days_ago.len]HexDigest = undefined;
+    for (&digests, days_ago) |*digest, days| {
+        var man = cache.obtain();
+        defer man.deinit();
+        man.hash.add(days);
+        try testing.expect(!try man.hit());
+        digest.* = man.final();
+        var output_dir = try o_dir.makeOpenPath(digest, .{});
+        defer output_dir.close();
+        try output_dir.writeFile(.{ .sub_path = "out", .data = "x" ** 1000 });
+        try man.writeManifest();
+        const last_used = now.subDuration(.fromSeconds(days * std.time.s_per_day));
+        try man.manifest_file.?.updateTimes(last_used, last_used);
+    }
+
+    // An output that no manifest refers to, modified before any entry was used.
+    try o_dir.writeFile(.{ .sub_path = "orphan", .data = "x" ** 1000 });
+    {
+        const orphan = try o_dir.openFile("orphan", .{ .mode = .read_write });
+        defer orphan.close();
+        const last_modified = now.subDuration(.fromSeconds(4 * std.time.s_per_day));
+        try orphan.updateTimes(last_modified, last_modified);
+    }
+
+    const usage = try gc(gpa, io, tmp.dir, math.maxInt(u64));
+    try testing.expectEqual(0, usage.evicted_count);
+    try testing.expectEqual(usage.bytes_before, usage.bytes_after);
+
+    // Freeing a single byte only evicts the least recently used entry.
+    const first = try gc(gpa, io, tmp.dir, usage.bytes_before - 1);
+    try testing.expectEqual(1, first.evicted_count);
+    try testing.expectError(error.FileNotFound, o_dir.access("orphan", .{}));
+    try o_dir.access(&digests[1], .{});
+
+    // Entries that are locked or were used recently survive even an empty budget.
+    {
+        var man = cache.obtain();
+        defer man.deinit();
+        man.hash.add(days_ago[0]);
+        try testing.expect(try man.hit());
+        const last_used = now.subDuration(.fromSeconds(days_ago[0] * std.time.s_per_day));
+        try man.manifest_file.?.updateTimes(last_used, last_used);
+
+        const second = try gc(gpa, io, tmp.dir, 0);
+        try testing.expectEqual(1, second.evicted_count);
+    }
+    try o_dir.access(&digests[0], .{});
+    try testing.expectError(error.FileNotFound, o_dir.access(&digests[1], .{}));
+    try o_dir.access(&digests[2], .{});
+}
+
+test "gc keeps unreferenced outputs while a manifest does not record its output" {
+    const io = std.testing.io;
+    const gpa = testing.allocator;
+
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    var h_dir = try tmp.dir.makeOpenPath("h", .{});
+    defer h_dir.close();
+    var o_dir = try tmp.dir.makeOpenPath("o", .{});
+    defer o_dir.close();
+
+    const now = try Io.Clock.real.now(io);
+    const manifest_name = "0123456789abcdef0123456789abcdef.txt";
+    try h_dir.writeFile(.{ .sub_path = manifest_name, .data = manifest_header ++ "\n" });
+    try o_dir.writeFile(.{ .sub_path = "output", .data = "x" ** 1000 });
+    for ([_]struct { fs.Dir, []const u8, i64 }{
+        .{ h_dir, manifest_name, 3 },
+        .{ o_dir, "output", 4 },
+    }) |item| {
+        const dir, const sub_path, const days = item;
+        const file = try dir.openFile(sub_path, .{ .mode = .read_write });
+        defer file.close();
+        const last_used = now.subDuration(.fromSeconds(days * std.time.s_per_day));
+        try file.updateTimes(last_used, last_used);
+    }
+
+    // The output is older, but it may belong to the legacy manifest, so only the manifest goes.
+    const first = try gc(gpa, io, tmp.dir, 0);
+    try testing.expectEqual(1, first.evicted_count);
+    try testing.expectError(error.FileNotFound, h_dir.access(manifest_name, .{}));
+    try o_dir.access("output", .{});
+
+    const second = try gc(gpa, io, tmp.dir, 0);
+    try testing.expectEqual(1, second.evicted_count);
+    try testing.expectError(error.FileNotFound, o_dir.access("output", .{}));
+}
+
+test "gc evicts store files by when they were last used" {
+    const io = std.testing.io;
+    const gpa = testing.allocator;
+
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    var s_dir = try tmp.dir.makeOpenPath(file_store_sub_path, .{});
+    defer s_dir.close();
+
+    const now = try Io.Clock.real.now(io);
+    for ([_]struct { []const u8, i64 }{ .{ "old", 3 }, .{ "new", 0 } }) |item| {
+        const sub_path, const days = item;
+        try s_dir.writeFile(.{ .sub_path = sub_path, .data = "x" ** 1000 });
+        const file = try s_dir.openFile(sub_path, .{ .mode = .read_write });
+        defer file.close();
+        const last_used = now.subDuration(.fromSeconds(days * std.time.s_per_day));
+        try file.updateTimes(last_used, last_used);
+    }
+
+    const usage = try gc(gpa, io, tmp.dir, 0);
+    try testing.expectEqual(2000, usage.bytes_before);
+    try testing.expectEqual(1000, usage.bytes_after);
+    try testing.expectEqual(1, usage.evicted_count);
+    try testing.expectError(error.FileNotFound, s_dir.access("old", .{}));
+    try s_dir.access("new", .{});
+}
+
+test "gcIfDue collects at most once per interval" {
+    const io = std.testing.io;
+    const gpa = testing.allocator;
+
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    try testing.expect(try gcIfDue(gpa, io, tmp.dir, 0) != null);
+    try testing.expect(try gcIfDue(gpa, io, tmp.dir, 0) == null);
+
+    {
+        const stamp = try tmp.dir.openFile(gc_stamp_name, .{ .mode = .read_write });
+        defer stamp.close();
+        const last_gc = (try Io.Clock.real.now(io)).subDuration(gc_interval).subDuration(.fromSeconds(1));
+        try stamp.updateTimes(last_gc, last_gc);
+    }
+    try testing.expect(try gcIfDue(gpa, io, tmp.dir, 0) != null);
+}
@@ -0,0 +1,410 @@
+//! A shared cache store reached over HTTP, which lets machines reuse each
+//! other's cache entries. A `Manifest` with `remote` set looks up local misses
+//! in the store and downloads the output on a hit, and uploads the entry from
+//! `writeManifest` on a miss.
+//!
+//! The store holds two kinds of objects, read with GET and written with PUT:
+//! * `cas/<sha256>`: immutable blobs named by the SHA-256 of their contents,
+//!   which is verified after every download.
+//! * `ac/<key>`: records holding the hex SHA-256 of a blob. The key is
+//!   `h-<digest>` for the manifest file `h/<digest>.txt`, and `o-<digest>` for
+//!   a tarball of the output directory `o/<digest>`.
+//! Any HTTP server that serves back what was PUT works as a store.
+
+const Remote = @This();
+
+const builtin = @import("builtin");
+const std = @import("../../std.zig");
+const Io = std.Io;
+const fs = std.fs;
+const mem = std.mem;
+const http = std.http;
+const testing = std.testing;
+const Allocator = std.mem.Allocator;
+const Cache = std.Build.Cache;
+const Sha256 = std.crypto.hash.sha2.Sha256;
+const log = std.log.scoped(.cache);
+
+client: *http.Client,
+/// Base URL of the store. Object paths are appended to it.
+url: []const u8,
+
+/// A `Remote` together with the local cache directory whose `o` subdirectory
+/// holds the outputs of the manifests that use it.
+pub const Binding = struct {
+    remote: *Remote,
+    cache_root: fs.Dir,
+};
+
+const sha256_hex_len = Sha256.digest_length * 2;
+
+pub const Error = Allocator.Error || http.Client.FetchError || error{
+    UnexpectedStatus,
+    InvalidRecord,
+    IntegrityCheckFailed,
+    StreamTooLong,
+};
+
+/// Returns the contents of the manifest file named by `manifest_digest`, or
+/// `null` if the store does not have it.
+pub fn fetchManifest(remote: *Remote, gpa: Allocator, manifest_digest: *const Cache.HexDigest) Error!?[]u8 {
+    return remote.fetchObject(gpa, "h-", manifest_digest, .limited(Cache.manifest_file_size_max));
+}
+
+/// Downloads the output `output_digest` into the `o` subdirectory of
+/// `cache_root`, unless it is already there.
+pub fn fetchOutput(
+    remote: *Remote,
+    gpa: Allocator,
+    cache_root: fs.Dir,
+    output_digest: *const Cache.HexDigest,
+) !void {
+    var o_dir = try cache_root.makeOpenPath("o", .{});
+    defer o_dir.close();
+    if (o_dir.access(output_digest, .{})) |_| return else |err| switch (err) {
+        error.FileNotFound => {},
+        else => |e| return e,
+    }
+
+    const tarball = try remote.fetchObject(gpa, "o-", output_digest, .unlimited) orelse
+        return error.FileNotFound;
+    defer gpa.free(tarball);
+
+    // Extract next to the final location, then rename into place, so that other processes
+    // never observe a partially extracted output.
+    var tmp_name_buf: [Cache.hex_digest_len + 20]u8 = undefined;
+    const tmp_name = std.fmt.bufPrint(&tmp_name_buf, "{s}.{x}", .{
+        output_digest, std.crypto.random.int(u64),
+    }) catch unreachable;
+    {
+        var tmp_dir = try o_dir.makeOpenPath(tmp_name, .{});
+        defer tmp_dir.close();
+        errdefer o_dir.deleteTree(tmp_name) catch {};
+        var reader: Io.Reader = .fixed(tarball);
+        try std.tar.pipeToFileSystem(tmp_dir, &reader, .{ .mode_mode = .executable_bit_only });
+    }
+    o_dir.rename(tmp_name, output_digest) catch |err| switch (err) {
+        // Another process downloaded or built the same output meanwhile.
+        error.PathAlreadyExists, error.AccessDenied => try o_dir.deleteTree(tmp_name),
+        else => |e| {
+            o_dir.deleteTree(tmp_name) catch {};
+            return e;
+        },
+    };
+}
+
+/// Uploads a manifest file and the output it refers to. The output goes first
+/// so that the store never has a manifest whose output is missing.
+pub fn store(
+    remote: *Remote,
+    gpa: Allocator,
+    io: Io,
+    manifest_digest: *const Cache.HexDigest,
+    manifest_contents: []const u8,
+    cache_root: fs.Dir,
+    output_digest: *const Cache.HexDigest,
+) !void {
+    var o_dir = try cache_root.openDir("o", .{});
+    defer o_dir.close();
+    var output_dir = try o_dir.openDir(output_digest, .{ .iterate = true });
+    defer output_dir.close();
+
+    var tarball: Io.Writer.Allocating = .init(gpa);
+    defer tarball.deinit();
+    try writeTarball(gpa, io, output_dir, &tarball.writer);
+
+    try remote.storeObject(gpa, "o-", output_digest, tarball.written());
+    try remote.storeObject(gpa, "h-", manifest_digest, manifest_contents);
+}
+
+fn fetchObject(
+    remote: *Remote,
+    gpa: Allocator,
+    comptime kind: []const u8,
+    digest: *const Cache.HexDigest,
+    limit: Io.Limit,
+) Error!?[]u8 {
+    var record_buf: [sha256_hex_len + 1]u8 = undefined;
+    var record_writer: Io.Writer = .fixed(&record_buf);
+    const record_url = try std.fmt.allocPrint(gpa, "{s}/ac/" ++ kind ++ "{s}", .{ remote.url, digest });
+    defer gpa.free(record_url);
+    const record_status = remote.get(record_url, &record_writer) catch |err| switch (err) {
+        // The buffer is one byte too large for any valid record.
+        error.WriteFailed => return error.InvalidRecord,
+        else => |e| return e,
+    };
+    switch (record_status) {
+        .ok => {},
+        .not_found => return null,
+        else => return error.UnexpectedStatus,
+    }
+    const blob_name = record_writer.buffered();
+    if (blob_name.len != sha256_hex_len) return error.InvalidRecord;
+    var expected: [Sha256.digest_length]u8 = undefined;
+    _ = std.fmt.hexToBytes(&expected, blob_name) catch return error.InvalidRecord;
+
+    var blob: Io.Writer.Allocating = .init(gpa);
+    defer blob.deinit();
+    const blob_url = try std.fmt.allocPrint(gpa, "{s}/cas/{s}", .{ remote.url, blob_name });
+    defer gpa.free(blob_url);
+    const blob_status = remote.get(blob_url, &blob.writer) catch |err| switch (err) {
+        error.WriteFailed => return error.OutOfMemory,
+        else => |e| return e,
+    };
+    switch (blob_status) {
+        .ok => {},
+        // The record outlived its blob; as good as a miss.
+        .not_found => return null,
+        else => return error.UnexpectedStatus,
+    }
+    const contents = blob.written();
+    if (limit.toInt()) |max| if (contents.len > max) return error.StreamTooLong;
+
+    var actual: [Sha256.digest_length]u8 = undefined;
+    Sha256.hash(contents, &actual, .{});
+    if (!mem.eql(u8, &actual, &expected)) return error.IntegrityCheckFailed;
+    return try blob.toOwnedSlice();
+}
+
+fn storeObject(
+    remote: *Remote,
+    gpa: Allocator,
+    comptime kind: []const u8,
+    digest: *const Cache.HexDigest,
+    contents: []const u8,
+) Error!void {
+    var hash: [Sha256.digest_length]u8 = undefined;
+    Sha256.hash(contents, &hash, .{});
+    const blob_name = std.fmt.bytesToHex(hash, .lower);
+
+    const blob_url = try std.fmt.allocPrint(gpa, "{s}/cas/{s}", .{ remote.url, &blob_name });
+    defer gpa.free(blob_url);
+    try remote.put(blob_url, contents);
+
+    const record_url = try std.fmt.allocPrint(gpa, "{s}/ac/" ++ kind ++ "{s}", .{ remote.url, digest });
+    defer gpa.free(record_url);
+    try remote.put(record_url, &blob_name);
+}
+
+fn get(remote: *Remote, url: []const u8, response_writer: *Io.Writer) http.Client.FetchError!http.Status {
+    const result = try remote.client.fetch(.{
+        .location = .{ .url = url },
+        .method = .GET,
+        .response_writer = response_writer,
+    });
+    return result.status;
+}
+
+fn put(remote: *Remote, url: []const u8, contents: []const u8) Error!void {
+    const result = try remote.client.fetch(.{
+        .location = .{ .url = url },
+        .method = .PUT,
+        .payload = contents,
+    });
+    if (result.status.class() != .success) return error.UnexpectedStatus;
+}
+
+fn writeTarball(gpa: Allocator, io: Io, dir: fs.Dir, w: *Io.Writer) !void {
+    var archiver: std.tar.Writer = .{ .underlying_writer = w };
+    var walker = try dir.walk(gpa);
+    defer walker.deinit();
+    var path_buf: [fs.max_path_bytes]u8 = undefined;
+    while (try walker.next()) |entry| {
+        // Tar paths always use forward slashes.
+        const path = path_buf[0..entry.path.len];
+        @memcpy(path, entry.path);
+        if (fs.path.sep != '/') mem.replaceScalar(u8, path, fs.path.sep, '/');
+        switch (entry.kind) {
+            .directory => try archiver.writeDir(path, .{}),
+            .sym_link => {
+                var target_buf: [fs.max_path_bytes]u8 = undefined;
+                const target = try entry.dir.readLink(entry.basename, &target_buf);
+                try archiver.writeLink(path, target, .{});
+            },
+            else => {
+                const file = try entry.dir.openFile(entry.basename, .{});
+                defer file.close();
+                const stat = try file.stat();
+                var read_buffer: [4096]u8 = undefined;
+                var file_reader: Io.File.Reader = .initSize(file.adaptToNewApi(), io, &read_buffer, stat.size);
+                try archiver.writeFileStream(path, stat.size, &file_reader.interface, .{
+                    .mode = @intCast(stat.mode),
+                });
+            },
+        }
+    }
+    try archiver.finishPedantically();
+}
+
+/// An in-memory store served on a loopback port, standing in for a real one.
+const TestStore = struct {
+    io: Io,
+    net_server: Io.net.Server,
+    thread: std.Thread,
+    shutting_down: bool = false,
+    mutex: std.Thread.Mutex = .{},
+    objects: std.StringHashMapUnmanaged([]u8) = .empty,
+
+    fn start(test_store: *TestStore, io: Io) !void {
+        const address = try Io.net.IpAddress.parse("127.0.0.1", 0);
+        test_store.* = .{
+            .io = io,
+            .net_server = try address.listen(io, .{ .reuse_address = true }),
+            .thread = undefined,
+        };
+        test_store.thread = try std.Thread.spawn(.{}, serve, .{test_store});
+    }
+
+    fn stop(test_store: *TestStore) void {
+        const io = test_store.io;
+        @atomicStore(bool, &test_store.shutting_down, true, .release);
+        var stream = test_store.net_server.socket.address.connect(io, .{ .mode = .stream }) catch
+            @panic("shutdown failure");
+        stream.close(io);
+        test_store.thread.join();
+        test_store.net_server.deinit(io);
+
+        var it = test_store.objects.iterator();
+        while (it.next()) |entry| {
+            testing.allocator.free(entry.key_ptr.*);
+            testing.allocator.free(entry.value_ptr.*);
+        }
+        test_store.objects.deinit(testing.allocator);
+    }
+
+    fn url(test_store: *TestStore, buf: []u8) []const u8 {
+        return std.fmt.bufPrint(buf, "http://127.0.0.1:{d}", .{
+            test_store.net_server.socket.address.getPort(),
+        }) catch unreachable;
+    }
+
+    fn serve(test_store: *TestStore) !void {
+        const io = test_store.io;
+        var recv_buffer: [4096]u8 = undefined;
+        var send_buffer: [4096]u8 = undefined;
+        accept: while (!@atomicLoad(bool, &test_store.shutting_down, .acquire)) {
+            var stream = try test_store.net_server.accept(io);
+            defer stream.close(io);
+
+            var connection_br = stream.reader(io, &recv_buffer);
+            var connection_bw = stream.writer(io, &send_buffer);
+            var server = http.Server.init(&connection_br.interface, &connection_bw.interface);
+            while (server.reader.state == .ready) {
+                var request = server.receiveHead() catch |err| switch (err) {
+                    error.HttpConnectionClosing => continue :accept,
+                    else => |e| return e,
+                };
+                try test_store.handle(&request);
+            }
+        }
+    }
+
+    fn handle(test_store: *TestStore, request: *http.Server.Request) !void {
+        const gpa = testing.allocator;
+        // Head strings expire once the body is read.
+        const target = try gpa.dupe(u8, request.head.target);
+        defer gpa.free(target);
+
+        switch (request.head.method) {
+            .GET => {
+                test_store.mutex.lock();
+                defer test_store.mutex.unlock();
+                if (test_store.objects.get(target)) |contents| {
+                    try request.respond(contents, .{});
+                } else {
+                    try request.respond("", .{ .status = .not_found });
+                }
+            },
+            .PUT => {
+                const body = try (try request.readerExpectContinue(&.{})).allocRemaining(gpa, .unlimited);
+                errdefer gpa.free(body);
+                {
+                    test_store.mutex.lock();
+                    defer test_store.mutex.unlock();
+                    const gop = try test_store.objects.getOrPut(gpa, target);
+                    if (gop.found_existing) {
+                        gpa.free(gop.value_ptr.*);
+                    } else {
+                        gop.key_ptr.* = try gpa.dupe(u8, target);
+                    }
+                    gop.value_ptr.* = body;
+                }
+                try request.respond("", .{ .status = .created });
+            },
+            else => try request.respond("", .{ .status = .method_not_allowed }),
+        }
+    }
+};
+
+test "entries round-trip through a remote store" {
+    if (builtin.single_threaded) return error.SkipZigTest;
+
+    const io = testing.io;
+    const gpa = testing.allocator;
+
+    var test_store: TestStore = undefined;
+    try test_store.start(io);
+    defer test_store.stop();
+
+    var client: http.Client = .{ .allocator = gpa, .io = io };
+    defer client.deinit();
+    var url_buf: [64]u8 = undefined;
+    var remote: Remote = .{ .client = &client, .url = test_store.url(&url_buf) };
+
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    try tmp.dir.writeFile(.{ .sub_path = "input.txt", .data = "input" });
+
+    var digest: Cache.HexDigest = undefined;
+    var path_buf: [fs.max_path_bytes]u8 = undefined;
+    // Each iteration is a different machine with its own cache directory.
+    for ([_][]const u8{ "a", "b", "c" }, 0..) |machine, i| {
+        var cache_root = try tmp.dir.makeOpenPath(machine, .{});
+        defer cache_root.close();
+        var cache: Cache = .{
+            .io = io,
+            .gpa = gpa,
+            .manifest_dir = try cache_root.makeOpenPath("h", .{}),
+        };
+        defer cache.manifest_dir.close();
+        cache.addPrefix(.{ .path = null, .handle = tmp.dir });
+
+        var man = cache.obtain();
+        defer man.deinit();
+        man.remote = .{ .remote = &remote, .cache_root = cache_root };
+        _ = try man.addFile("input.txt", null);
+
+        switch (i) {
+            0 => {
+                try testing.expect(!try man.hit());
+                digest = man.final();
+                const output_path = try std.fmt.bufPrint(&path_buf, "o/{s}/sub", .{&digest});
+                var output_dir = try cache_root.makeOpenPath(output_path, .{});
+                defer output_dir.close();
+                try output_dir.writeFile(.{ .sub_path = "output.txt", .data = "output" });
+                try man.writeManifest();
+            },
+            1 => {
+                try testing.expect(try man.hit());
+                try testing.expectEqualStrings(&digest, &man.final());
+                var buf: [16]u8 = undefined;
+                const output_path = try std.fmt.bufPrint(&path_buf, "o/{s}/sub/output.txt", .{&digest});
+                try testing.expectEqualStrings("output", try cache_root.readFile(output_path, &buf));
+
+                // Corrupt every blob in the store before the next machine looks.
+                test_store.mutex.lock();
+                defer test_store.mutex.unlock();
+                var it = test_store.objects.iterator();
+                while (it.next()) |entry| {
+                    if (mem.startsWith(u8, entry.key_ptr.*, "/cas/")) entry.value_ptr.*[0] +%= 1;
+                }
+            },
+            2 => {
+                try testing.expect(!try man.hit());
+                const output_path = try std.fmt.bufPrint(&path_buf, "o/{s}", .{&digest});
+                try testing.expectError(error.FileNotFound, cache_root.access(output_path, .{}));
+            },
+            else => unreachable,
+        }
+    }
+}
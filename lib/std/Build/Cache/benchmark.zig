@@ -0,0 +1,100 @@
+// zig run -O ReleaseFast --zig-lib-dir ../../.. benchmark.zig
+
+//! Measures `Cache.Manifest.hit` on a manifest with many inputs, such as a C
+//! source file with a large header dependency set, in both the binary
+//! manifest format and the legacy text format.
+
+const std = @import("std");
+const Cache = std.Build.Cache;
+const Timer = std.time.Timer;
+
+const input_count = 10_000;
+const iterations = 20;
+const root_dir_name = "cache-manifest-benchmark";
+
+pub fn main() !void {
+    var stdout_buffer: [0x100]u8 = undefined;
+    var stdout_writer = std.fs.File.stdout().writer(&stdout_buffer);
+    const stdout = &stdout_writer.interface;
+
+    const gpa = std.heap.smp_allocator;
+    var threaded: std.Io.Threaded = .init(gpa);
+    defer threaded.deinit();
+    const io = threaded.io();
+
+    const cwd = std.fs.cwd();
+    var root_dir = try cwd.makeOpenPath(root_dir_name, .{});
+    defer {
+        root_dir.close();
+        cwd.deleteTree(root_dir_name) catch {};
+    }
+
+    var input_paths: [input_count][]const u8 = undefined;
+    var arena_state: std.heap.ArenaAllocator = .init(gpa);
+    defer arena_state.deinit();
+    const arena = arena_state.allocator();
+    try root_dir.makePath("inputs");
+    for (&input_paths, 0..) |*input_path, i| {
+        const sub_path = try std.fmt.allocPrint(arena, "inputs/header{d}.h", .{i});
+        try root_dir.writeFile(.{ .sub_path = sub_path, .data = sub_path });
+        input_path.* = try std.fmt.allocPrint(arena, root_dir_name ++ "/{s}", .{sub_path});
+    }
+    // Let the inputs age past the file system's timestamp granularity, otherwise the cache
+    // treats their mtimes as unreliable and re-hashes every input on every check.
+    try std.Io.Clock.Duration.sleep(.{ .clock = .boot, .raw = .fromSeconds(1) }, io);
+
+    var cache: Cache = .{
+        .gpa = gpa,
+        .io = io,
+        .manifest_dir = try root_dir.makeOpenPath("h", .{}),
+    };
+    defer cache.manifest_dir.close();
+    cache.addPrefix(.{ .path = null, .handle = cwd });
+
+    var manifest_name: [Cache.hex_digest_len + ".txt".len]u8 = undefined;
+    var text_manifest: std.ArrayListUnmanaged(u8) = .empty;
+    defer text_manifest.deinit(gpa);
+    {
+        var man = cache.obtain();
+        defer man.deinit();
+        for (input_paths) |input_path| _ = try man.addFile(input_path, null);
+        if (try man.hit()) return error.UnexpectedCacheHit;
+        try man.writeManifest();
+
+        _ = try std.fmt.bufPrint(&manifest_name, "{s}.txt", .{&man.hex_digest});
+        try text_manifest.appendSlice(gpa, "0\n");
+        for (man.files.keys()) |file| {
+            try text_manifest.print(gpa, "{d} {d} {d} {x} {d} {s}\n", .{
+                file.stat.size,
+                file.stat.inode,
+                file.stat.mtime.nanoseconds,
+                &file.bin_digest,
+                file.prefixed_path.prefix,
+                file.prefixed_path.sub_path,
+            });
+        }
+    }
+    const binary_manifest = try cache.manifest_dir.readFileAlloc(&manifest_name, gpa, .unlimited);
+    defer gpa.free(binary_manifest);
+
+    try stdout.print("{d} inputs, {d} iterations\n", .{ input_count, iterations });
+    inline for (.{ "binary", "text" }) |format| {
+        const contents = if (comptime std.mem.eql(u8, format, "binary")) binary_manifest else text_manifest.items;
+        try cache.manifest_dir.writeFile(.{ .sub_path = &manifest_name, .data = contents });
+
+        var timer = try Timer.start();
+        for (0..iterations) |_| {
+            var man = cache.obtain();
+            defer man.deinit();
+            for (input_paths) |input_path| _ = try man.addFile(input_path, null);
+            if (!try man.hit()) return error.UnexpectedCacheMiss;
+        }
+        const elapsed_ns = timer.read();
+        try stdout.print("{s:>7}: {d:>9} bytes, {d:>8.3} ms/hit\n", .{
+            format,
+            contents.len,
+            @as(f64, @floatFromInt(elapsed_ns)) / iterations / std.time.ns_per_ms,
+        });
+        try stdout.flush();
+    }
+}
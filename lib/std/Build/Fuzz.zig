@@ -26,6 +26,8 @@ wait_group: std.Thread.WaitGroup,
 root_prog_node: std.Progress.Node,
 prog_node: std.Progress.Node,
 thread_pool: *std.Thread.Pool,
+/// How many processes run each fuzz test. Set by `start`.
+instances_per_test: u32,
 
 /// Protects `coverage_files`.
 coverage_mutex: std.Thread.Mutex,
@@ -38,10 +40,20 @@ msg_queue: std.ArrayListUnmanaged(Msg),
 pub const Mode = union(enum) {
     forever: struct { ws: *Build.WebServer },
     limit: Limited,
+    /// Instead of fuzzing, replace the corpus of each fuzz test with the
+    /// smallest inputs in it which together cover all of its pcs.
+    minimize: Minimize,
 
     pub const Limited = struct {
         amount: u64,
     };
+
+    pub const Minimize = struct {
+        /// A directory laid out like the `f` directory of the cache, such as
+        /// one copied from another machine. Its corpora are added to those in
+        /// the cache before minimizing.
+        merge_dir: ?[]const u8,
+    };
 };
 
 const Msg = union(enum) {
@@ -67,6 +79,10 @@ const CoverageMap = struct {
     /// Elements are indexes into `source_locations` pointing to the unit tests that are being fuzz tested.
     entry_points: std.ArrayListUnmanaged(u32),
     start_timestamp: i64,
+    /// `SeenPcsHeader.n_runs` as reported by the first fuzzing process.
+    start_n_runs: u64,
+    /// How many fuzzing processes share this coverage file.
+    processes: u32,
 
     fn deinit(cm: *CoverageMap, gpa: Allocator) void {
         std.posix.munmap(cm.mapped_memory);
@@ -90,7 +106,7 @@ pub fn init(
         const rebuild_node = root_prog_node.start("Rebuilding Unit Tests", 0);
         defer rebuild_node.end();
         var rebuild_wg: std.Thread.WaitGroup = .{};
-        defer rebuild_wg.wait();
+        defer thread_pool.wait(&rebuild_wg);
 
         for (all_steps) |step| {
             const run = step.cast(Step.Run) orelse continue;
@@ -120,6 +136,7 @@ pub fn init(
         .run_steps = run_steps,
         .wait_group = .{},
         .thread_pool = thread_pool,
+        .instances_per_test = undefined,
         .root_prog_node = root_prog_node,
         .prog_node = .none,
         .coverage_files = .empty,
@@ -142,12 +159,43 @@ pub fn start(fuzz: *Fuzz) void {
         };
     }
 
+    // Each fuzzing process occupies a worker thread for as long as it runs, so
+    // the worker threads are shared out evenly among the fuzz tests. A limited
+    // amount of fuzzing is always done by one process per test, so that the
+    // number of runs is exact. Corpora are minimized by as many processes as
+    // fuzzing forever uses, each replaying a share of the inputs.
+    fuzz.instances_per_test = switch (fuzz.mode) {
+        .forever, .minimize => n: {
+            var fuzz_tests_len: usize = 0;
+            for (fuzz.run_steps) |run| fuzz_tests_len += run.fuzz_tests.items.len;
+            break :n @intCast(@max(1, fuzz.thread_pool.threads.len / fuzz_tests_len));
+        },
+        .limit => 1,
+    };
+
+    switch (fuzz.mode) {
+        .minimize => |minimize| if (minimize.merge_dir) |merge_dir| {
+            for (fuzz.run_steps) |run| {
+                for (run.fuzz_tests.items) |unit_test_index| {
+                    importCorpus(fuzz.gpa, run, unit_test_index, merge_dir) catch |err| {
+                        log.err("step '{s}': failed to merge corpus of '{s}' from '{s}': {t}", .{
+                            run.step.name, run.cached_test_metadata.?.testName(unit_test_index), merge_dir, err,
+                        });
+                    };
+                }
+            }
+        },
+        .forever, .limit => {},
+    }
+
     for (fuzz.run_steps) |run| {
         for (run.fuzz_tests.items) |unit_test_index| {
             assert(run.rebuilt_executable != null);
-            fuzz.thread_pool.spawnWg(&fuzz.wait_group, fuzzWorkerRun, .{
-                fuzz, run, unit_test_index,
-            });
+            for (0..fuzz.instances_per_test) |instance_id| {
+                fuzz.thread_pool.spawnWg(&fuzz.wait_group, fuzzWorkerRun, .{
+                    fuzz, run, unit_test_index, @as(u32, @intCast(instance_id)),
+                });
+            }
         }
     }
 }
@@ -196,6 +244,7 @@ fn fuzzWorkerRun(
     fuzz: *Fuzz,
     run: *Step.Run,
     unit_test_index: u32,
+    instance_id: u32,
 ) void {
     const gpa = run.step.owner.allocator;
     const test_name = run.cached_test_metadata.?.testName(unit_test_index);
@@ -203,7 +252,7 @@ fn fuzzWorkerRun(
     const prog_node = fuzz.prog_node.start(test_name, 0);
     defer prog_node.end();
 
-    run.rerunInFuzzMode(fuzz, unit_test_index, prog_node) catch |err| switch (err) {
+    run.rerunInFuzzMode(fuzz, unit_test_index, instance_id, prog_node) catch |err| switch (err) {
         error.MakeFailed => {
             var buf: [256]u8 = undefined;
             const w, _ = std.debug.lockStderrWriter(&buf);
@@ -310,8 +359,10 @@ pub fn sendUpdate(
         }
 
         const header: abi.CoverageUpdateHeader = .{
+            .processes = coverage_map.processes,
             .n_runs = n_runs,
             .unique_runs = unique_runs,
+            .start_n_runs = coverage_map.start_n_runs,
         };
         var iovecs: [2][]const u8 = .{
             @ptrCast(&header),
@@ -343,7 +394,7 @@ fn coverageRun(fuzz: *Fuzz) void {
     while (true) {
         fuzz.queue_cond.wait(&fuzz.queue_mutex);
         for (fuzz.msg_queue.items) |msg| switch (msg) {
-            .coverage => |coverage| prepareTables(fuzz, coverage.run, coverage.id) catch |err| switch (err) {
+            .coverage => |coverage| prepareTables(fuzz, coverage.run, coverage.id, coverage.cumulative.runs) catch |err| switch (err) {
                 error.AlreadyReported => continue,
                 else => |e| log.err("failed to prepare code coverage tables: {s}", .{@errorName(e)}),
             },
@@ -355,7 +406,7 @@ fn coverageRun(fuzz: *Fuzz) void {
         fuzz.msg_queue.clearRetainingCapacity();
     }
 }
-fn prepareTables(fuzz: *Fuzz, run_step: *Step.Run, coverage_id: u64) error{ OutOfMemory, AlreadyReported }!void {
+fn prepareTables(fuzz: *Fuzz, run_step: *Step.Run, coverage_id: u64, n_runs: u64) error{ OutOfMemory, AlreadyReported }!void {
     assert(fuzz.mode == .forever);
     const ws = fuzz.mode.forever.ws;
 
@@ -369,6 +420,7 @@ fn prepareTables(fuzz: *Fuzz, run_step: *Step.Run, coverage_id: u64) error{ OutO
         // case, since the coverage file is the same, we only have to
         // notice changes to that one file in order to learn coverage for
         // this particular executable.
+        gop.value_ptr.processes += 1;
         return;
     }
     errdefer _ = fuzz.coverage_files.pop();
@@ -379,6 +431,8 @@ fn prepareTables(fuzz: *Fuzz, run_step: *Step.Run, coverage_id: u64) error{ OutO
         .source_locations = undefined, // populated below
         .entry_points = .{},
         .start_timestamp = ws.now(),
+        .start_n_runs = n_runs,
+        .processes = 1,
     };
     errdefer gop.value_ptr.coverage.deinit(fuzz.gpa);
 
@@ -483,14 +537,176 @@ fn addEntryPoint(fuzz: *Fuzz, coverage_id: u64, addr: u64) error{ AlreadyReporte
             addr, file_name, sl.line, sl.column, index, pcs[index - 1], pcs[index + 1],
         });
     }
+    // Every process fuzzing the same unit test reports its entry point.
+    if (std.mem.indexOfScalar(u32, coverage_map.entry_points.items, @intCast(index)) != null) return;
     try coverage_map.entry_points.append(fuzz.gpa, @intCast(index));
 }
 
+/// Waits for the fuzz tests to replay their corpora, and then replaces each
+/// corpus with the inputs which were selected by the replays.
+pub fn waitAndMinimizeCorpora(fuzz: *Fuzz) void {
+    assert(fuzz.mode == .minimize);
+
+    fuzz.thread_pool.wait(&fuzz.wait_group);
+    fuzz.wait_group.reset();
+
+    for (fuzz.run_steps) |run| {
+        for (run.fuzz_tests.items) |unit_test_index| {
+            const test_name = run.cached_test_metadata.?.testName(unit_test_index);
+            const result = fuzz.minimizeCorpus(run, test_name) catch |err| {
+                log.err("step '{s}': failed to minimize corpus of '{s}': {t}", .{ run.step.name, test_name, err });
+                continue;
+            };
+            std.debug.print("Fuzz test \"{s}\": kept {d} of {d} inputs\n", .{ test_name, result.kept, result.total });
+        }
+    }
+}
+
+fn minimizeCorpus(fuzz: *Fuzz, run: *Step.Run, test_name: []const u8) !Minimized {
+    var dir = try openCorpusDir(run, test_name);
+    defer dir.close();
+    return minimizeCorpusDir(fuzz.gpa, dir, fuzz.instances_per_test);
+}
+
+const Minimized = struct { kept: usize, total: usize };
+
+/// Replaces the corpus in `dir` with the inputs selected by the tables which
+/// `instance_count` processes wrote there with `abi.fuzzer_minimize_corpus`. The
+/// tables are deleted however this ends, including when a process crashed
+/// before writing its own, which leaves the corpus as it was.
+fn minimizeCorpusDir(gpa: Allocator, dir: std.fs.Dir, instance_count: u32) !Minimized {
+    defer for (0..instance_count) |instance_id| {
+        var name_buf: [16]u8 = undefined;
+        const name = minimizeTableName(&name_buf, @intCast(instance_id));
+        dir.deleteFile(name) catch |err| switch (err) {
+            error.FileNotFound => {},
+            else => log.warn("failed to delete '{s}': {t}", .{ name, err }),
+        };
+    };
+
+    // Each process picked the smallest input for each pc among those it ran.
+    var best: []abi.MinimizeEntry = &.{};
+    defer gpa.free(best);
+    for (0..instance_count) |instance_id| {
+        var name_buf: [16]u8 = undefined;
+        const name = minimizeTableName(&name_buf, @intCast(instance_id));
+        const bytes = try dir.readFileAllocOptions(name, gpa, .unlimited, .of(abi.MinimizeEntry), null);
+        defer gpa.free(bytes);
+        if (bytes.len % @sizeOf(abi.MinimizeEntry) != 0) return error.InvalidMinimizeTable;
+        const table = std.mem.bytesAsSlice(abi.MinimizeEntry, bytes);
+        if (instance_id == 0) {
+            best = try gpa.dupe(abi.MinimizeEntry, table);
+            continue;
+        }
+        if (table.len != best.len) return error.InvalidMinimizeTable;
+        for (best, table) |*b, entry| {
+            if (@as(u64, @bitCast(entry)) < @as(u64, @bitCast(b.*))) b.* = entry;
+        }
+    }
+
+    var keep: std.ArrayListUnmanaged(u32) = .empty;
+    defer keep.deinit(gpa);
+    for (best) |entry| {
+        if (entry == abi.MinimizeEntry.none) continue;
+        try keep.append(gpa, entry.index);
+    }
+    std.mem.sortUnstable(u32, keep.items, {}, std.sort.asc(u32));
+    var kept: usize = 0;
+    for (keep.items) |index| {
+        if (kept != 0 and keep.items[kept - 1] == index) continue;
+        keep.items[kept] = index;
+        kept += 1;
+    }
+    keep.shrinkRetainingCapacity(kept);
+
+    const total = try corpusLen(dir);
+
+    // The kept inputs move down to the lowest indexes. Each one lands either on
+    // an input which is not kept, or on one which has already been moved.
+    for (keep.items, 0..) |old_index, new_index| {
+        if (old_index == new_index) continue;
+        var old_buf: [8]u8 = undefined;
+        var new_buf: [8]u8 = undefined;
+        try dir.rename(corpusFileName(&old_buf, old_index), corpusFileName(&new_buf, @intCast(new_index)));
+    }
+    for (keep.items.len..total) |index| {
+        var name_buf: [8]u8 = undefined;
+        dir.deleteFile(corpusFileName(&name_buf, @intCast(index))) catch |err| switch (err) {
+            error.FileNotFound => {},
+            else => |e| return e,
+        };
+    }
+
+    return .{ .kept = keep.items.len, .total = total };
+}
+
+/// The table a replaying process writes into the corpus directory. See
+/// `abi.fuzzer_minimize_corpus`.
+fn minimizeTableName(buf: *[16]u8, instance_id: u32) []const u8 {
+    return std.fmt.bufPrint(buf, "cmin{d}", .{instance_id}) catch unreachable;
+}
+
+/// Appends the corpus of a unit test in `merge_dir` to its corpus in the cache.
+fn importCorpus(gpa: Allocator, run: *Step.Run, unit_test_index: u32, merge_dir: []const u8) !void {
+    const test_name = run.cached_test_metadata.?.testName(unit_test_index);
+    var src_dir = try std.fs.cwd().openDir(merge_dir, .{});
+    defer src_dir.close();
+    var src_test_dir = src_dir.openDir(test_name, .{}) catch |err| switch (err) {
+        error.FileNotFound => return, // nothing to merge for this test
+        else => |e| return e,
+    };
+    defer src_test_dir.close();
+    var dest_dir = try openCorpusDir(run, test_name);
+    defer dest_dir.close();
+    try importCorpusDir(gpa, src_test_dir, dest_dir);
+}
+
+/// Appends the corpus in `src_dir` to the one in `dest_dir`.
+fn importCorpusDir(gpa: Allocator, src_dir: std.fs.Dir, dest_dir: std.fs.Dir) !void {
+    var dest_index = try corpusLen(dest_dir);
+    var src_index: u32 = 0;
+    while (true) : (src_index += 1) {
+        var src_buf: [8]u8 = undefined;
+        const bytes = src_dir.readFileAlloc(corpusFileName(&src_buf, src_index), gpa, .unlimited) catch |err| switch (err) {
+            error.FileNotFound => break,
+            else => |e| return e,
+        };
+        defer gpa.free(bytes);
+        var dest_buf: [8]u8 = undefined;
+        try dest_dir.writeFile(.{ .sub_path = corpusFileName(&dest_buf, dest_index), .data = bytes });
+        dest_index += 1;
+    }
+}
+
+/// The number of corpus files in `dir`, which are numbered from zero.
+fn corpusLen(dir: std.fs.Dir) !u32 {
+    var len: u32 = 0;
+    while (true) : (len += 1) {
+        var name_buf: [8]u8 = undefined;
+        dir.access(corpusFileName(&name_buf, len), .{}) catch |err| switch (err) {
+            error.FileNotFound => return len,
+            else => |e| return e,
+        };
+    }
+}
+
+/// The directory where `libfuzzer` keeps the corpus of a unit test.
+fn openCorpusDir(run: *Step.Run, test_name: []const u8) !std.fs.Dir {
+    var f_dir = try run.step.owner.cache_root.handle.makeOpenPath("f", .{});
+    defer f_dir.close();
+    return f_dir.makeOpenPath(test_name, .{});
+}
+
+/// Corpus files are named after their index in hexadecimal.
+fn corpusFileName(buf: *[8]u8, index: u32) []const u8 {
+    return std.fmt.bufPrint(buf, "{x}", .{index}) catch unreachable;
+}
+
 pub fn waitAndPrintReport(fuzz: *Fuzz) void {
     assert(fuzz.mode == .limit);
     const io = fuzz.io;
 
-    fuzz.wait_group.wait();
+    fuzz.thread_pool.wait(&fuzz.wait_group);
     fuzz.wait_group.reset();
 
     std.debug.print("======= FUZZING REPORT =======\n", .{});
@@ -570,3 +786,76 @@ pub fn waitAndPrintReport(fuzz: *Fuzz) void {
         \\
     , .{});
 }
+
+fn writeTestCorpus(dir: std.fs.Dir, inputs: []const []const u8) !void {
+    for (inputs, 0..) |input, index| {
+        var name_buf: [8]u8 = undefined;
+        try dir.writeFile(.{ .sub_path = corpusFileName(&name_buf, @intCast(index)), .data = input });
+    }
+}
+
+fn expectTestCorpus(dir: std.fs.Dir, inputs: []const []const u8) !void {
+    try std.testing.expectEqual(inputs.len, try corpusLen(dir));
+    for (inputs, 0..) |input, index| {
+        var name_buf: [8]u8 = undefined;
+        var buf: [16]u8 = undefined;
+        try std.testing.expectEqualStrings(input, try dir.readFile(corpusFileName(&name_buf, @intCast(index)), &buf));
+    }
+}
+
+test minimizeCorpusDir {
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    try writeTestCorpus(tmp.dir, &.{ "aaa", "bbb", "c", "dd", "eeeee" });
+    // Instance 0 ran inputs 0, 2 and 4, and instance 1 ran inputs 1 and 3.
+    // Where both hit a pc, the shorter input is kept.
+    const tables: [2][3]abi.MinimizeEntry = .{
+        .{ .{ .index = 2, .len = 1 }, .{ .index = 4, .len = 5 }, .none },
+        .{ .{ .index = 1, .len = 3 }, .{ .index = 3, .len = 2 }, .{ .index = 3, .len = 2 } },
+    };
+    for (&tables, 0..) |*table, instance_id| {
+        var name_buf: [16]u8 = undefined;
+        try tmp.dir.writeFile(.{
+            .sub_path = minimizeTableName(&name_buf, @intCast(instance_id)),
+            .data = std.mem.sliceAsBytes(table),
+        });
+    }
+
+    const result = try minimizeCorpusDir(std.testing.allocator, tmp.dir, tables.len);
+    try std.testing.expectEqual(2, result.kept);
+    try std.testing.expectEqual(5, result.total);
+    try expectTestCorpus(tmp.dir, &.{ "c", "dd" });
+    try std.testing.expectError(error.FileNotFound, tmp.dir.access("cmin0", .{}));
+    try std.testing.expectError(error.FileNotFound, tmp.dir.access("cmin1", .{}));
+}
+
+test "minimizeCorpusDir leaves the corpus as it was when a process crashed" {
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    try writeTestCorpus(tmp.dir, &.{ "aaa", "bbb" });
+    // Instance 1 never wrote its table.
+    const table: [1]abi.MinimizeEntry = .{.{ .index = 0, .len = 3 }};
+    try tmp.dir.writeFile(.{ .sub_path = "cmin0", .data = std.mem.sliceAsBytes(&table) });
+
+    try std.testing.expectError(error.FileNotFound, minimizeCorpusDir(std.testing.allocator, tmp.dir, 2));
+    try expectTestCorpus(tmp.dir, &.{ "aaa", "bbb" });
+    try std.testing.expectError(error.FileNotFound, tmp.dir.access("cmin0", .{}));
+}
+
+test importCorpusDir {
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    var src_dir = try tmp.dir.makeOpenPath("src", .{});
+    defer src_dir.close();
+    var dest_dir = try tmp.dir.makeOpenPath("dest", .{});
+    defer dest_dir.close();
+    try writeTestCorpus(src_dir, &.{ "c", "d", "e" });
+    try writeTestCorpus(dest_dir, &.{ "a", "b" });
+
+    try importCorpusDir(std.testing.allocator, src_dir, dest_dir);
+    try expectTestCorpus(dest_dir, &.{ "a", "b", "c", "d", "e" });
+    try expectTestCorpus(src_dir, &.{ "c", "d", "e" });
+}
@@ -13,6 +13,10 @@ const ArrayList = std.ArrayList;
 id: Id,
 name: []const u8,
 owner: *Build,
+/// Identifies the step from one run of the build script to the next: the
+/// `dep_prefix` of the owner and the name the step was created with, followed
+/// by how many steps with the same prefix and name were created before it.
+key: []const u8,
 makeFn: MakeFn,
 
 dependencies: std.array_list.Managed(*Step),
@@ -240,11 +244,18 @@ pub const StepOptions = struct {
 
 pub fn init(options: StepOptions) Step {
     const arena = options.owner.allocator;
+    const graph = options.owner.graph;
+
+    const prefixed_name = std.fmt.allocPrint(arena, "{s}{s}", .{ options.owner.dep_prefix, options.name }) catch @panic("OOM");
+    const count = graph.step_name_counts.getOrPut(graph.arena, prefixed_name) catch @panic("OOM");
+    if (!count.found_existing) count.value_ptr.* = 0;
+    defer count.value_ptr.* += 1;
 
     return .{
         .id = options.id,
         .name = arena.dupe(u8, options.name) catch @panic("OOM"),
         .owner = options.owner,
+        .key = std.fmt.allocPrint(arena, "{s}#{d}", .{ prefixed_name, count.value_ptr.* }) catch @panic("OOM"),
         .makeFn = options.makeFn,
         .dependencies = std.array_list.Managed(*Step).init(arena),
         .dependants = .empty,
@@ -275,6 +286,7 @@ pub fn make(s: *Step, options: MakeOptions) error{ MakeFailed, MakeSkipped }!voi
 
     var timer: ?std.time.Timer = t: {
         if (!s.owner.graph.time_report) break :t null;
+        if (options.web_server == null) break :t null;
         if (s.id == .compile) break :t null;
         if (s.id == .run and s.cast(Run).?.stdio == .zig_test) break :t null;
         break :t std.time.Timer.start() catch @panic("--time-report not supported on this host");
@@ -386,8 +398,49 @@ pub const ZigProcess = struct {
     child: std.process.Child,
     poller: Io.Poller(StreamEnum),
     progress_ipc_fd: if (std.Progress.have_ipc) ?std.posix.fd_t else void,
+    /// Whether the compiler finished the last update and is waiting for more
+    /// messages, as opposed to having exited or crashed.
+    update_done: bool = false,
 
     pub const StreamEnum = enum { stdout, stderr };
+
+    /// Asks the compiler to exit and waits for it.
+    fn stop(zp: *ZigProcess, gpa: Allocator) void {
+        sendMessage(zp.child.stdin.?, .exit) catch {};
+        zp.child.stdin.?.close();
+        zp.child.stdin = null;
+        _ = zp.child.wait() catch {};
+        zp.poller.deinit();
+        gpa.destroy(zp);
+    }
+};
+
+/// Compiler processes which have finished the compilation of one `Compile`
+/// step and are waiting to be given another one with a `compile` message,
+/// saving the cost of starting a compiler for every step.
+/// The number of idle processes is bounded by the number of steps which
+/// run at the same time.
+pub const ZigProcessPool = struct {
+    mutex: std.Thread.Mutex = .{},
+    idle: std.ArrayListUnmanaged(*ZigProcess) = .empty,
+
+    pub fn deinit(pool: *ZigProcessPool, gpa: Allocator) void {
+        for (pool.idle.items) |zp| zp.stop(gpa);
+        pool.idle.deinit(gpa);
+        pool.* = undefined;
+    }
+
+    fn acquire(pool: *ZigProcessPool) ?*ZigProcess {
+        pool.mutex.lock();
+        defer pool.mutex.unlock();
+        return pool.idle.pop();
+    }
+
+    fn release(pool: *ZigProcessPool, gpa: Allocator, zp: *ZigProcess) void {
+        pool.mutex.lock();
+        defer pool.mutex.unlock();
+        pool.idle.append(gpa, zp) catch zp.stop(gpa);
+    }
 };
 
 /// Assumes that argv contains `--listen=-` and that the process being spawned
@@ -408,7 +461,7 @@ pub fn evalZigProcess(
     if (s.getZigProcess()) |zp| update: {
         assert(watch);
         if (std.Progress.have_ipc) if (zp.progress_ipc_fd) |fd| prog_node.setIpcFd(fd);
-        const result = zigProcessUpdate(s, zp, watch, web_server, gpa) catch |err| switch (err) {
+        const result = zigProcessUpdate(s, zp, .update, web_server, gpa) catch |err| switch (err) {
             error.BrokenPipe => {
                 // Process restart required.
                 const term = zp.child.wait() catch |e| {
@@ -445,6 +498,25 @@ pub fn evalZigProcess(
     try handleChildProcUnsupported(s);
     try handleVerbose(s.owner, null, argv);
 
+    // Outside of watch mode, a compiler which another `Compile` step has
+    // finished with can be reused instead of spawning a new one.
+    const pool: ?*ZigProcessPool = if (!watch and s.id == .compile) b.graph.zig_process_pool else null;
+    if (pool) |p| while (p.acquire()) |zp| {
+        if (std.Progress.have_ipc) if (zp.progress_ipc_fd) |fd| prog_node.setIpcFd(fd);
+        const result = zigProcessUpdate(s, zp, .{ .compile = argv[1..] }, web_server, gpa) catch |err| switch (err) {
+            error.BrokenPipe => {
+                // The idle compiler went away; try the next one.
+                zp.stop(gpa);
+                continue;
+            },
+            else => |e| {
+                zp.stop(gpa);
+                return e;
+            },
+        };
+        return finishPooledUpdate(s, p, zp, result, gpa);
+    };
+
     var child = std.process.Child.init(argv, arena);
     child.env_map = &b.graph.env_map;
     child.stdin_behavior = .Pipe;
@@ -467,12 +539,20 @@ pub fn evalZigProcess(
         .progress_ipc_fd = if (std.Progress.have_ipc) child.progress_node.getIpcFd() else {},
     };
     if (watch) s.setZigProcess(zp);
-    defer if (!watch) {
+    defer if (!watch and pool == null) {
         zp.poller.deinit();
         gpa.destroy(zp);
     };
 
-    const result = try zigProcessUpdate(s, zp, watch, web_server, gpa);
+    if (pool) |p| {
+        const result = zigProcessUpdate(s, zp, .update, web_server, gpa) catch |err| {
+            zp.stop(gpa);
+            return err;
+        };
+        return finishPooledUpdate(s, p, zp, result, gpa);
+    }
+
+    const result = try zigProcessUpdate(s, zp, if (watch) .update else .update_and_exit, web_server, gpa);
 
     if (!watch) {
         // Send EOF to stdin.
@@ -530,14 +610,71 @@ pub fn installDir(s: *Step, dest_path: []const u8) !std.fs.Dir.MakePathStatus {
     };
 }
 
-fn zigProcessUpdate(s: *Step, zp: *ZigProcess, watch: bool, web_server: ?*Build.WebServer, gpa: Allocator) !?Path {
+/// Returns a compiler which served a `Compile` step to `pool`, or reaps it if
+/// it exited during the update.
+fn finishPooledUpdate(s: *Step, pool: *ZigProcessPool, zp: *ZigProcess, result: ?Path, gpa: Allocator) !?Path {
+    if (zp.update_done) {
+        // The peak RSS of the process covers every compilation it served, so
+        // it is not reported for the step.
+        pool.release(gpa, zp);
+    } else {
+        zp.child.stdin.?.close();
+        zp.child.stdin = null;
+        const term = zp.child.wait() catch |err| {
+            zp.poller.deinit();
+            gpa.destroy(zp);
+            return s.fail("unable to wait for {s}: {s}", .{ s.owner.graph.zig_exe, @errorName(err) });
+        };
+        s.result_peak_rss = zp.child.resource_usage_statistics.getMaxRss() orelse 0;
+        zp.poller.deinit();
+        gpa.destroy(zp);
+        try handleChildProcessTerm(s, term);
+    }
+
+    // Special handling for Compile step that is expecting compile errors.
+    if (s.cast(Compile).?.expect_errors != null) return error.NeedCompileErrorCheck;
+
+    if (s.result_error_bundle.errorMessageCount() > 0) {
+        return s.fail("{d} compilation errors", .{s.result_error_bundle.errorMessageCount()});
+    }
+
+    return result;
+}
+
+const UpdateRequest = union(enum) {
+    /// Update the compilation, then exit.
+    update_and_exit,
+    /// Update the compilation, then wait for more messages.
+    update,
+    /// Start a new compilation with this command line, without the zig
+    /// executable, and update it, then wait for more messages.
+    compile: []const []const u8,
+};
+
+fn zigProcessUpdate(s: *Step, zp: *ZigProcess, request: UpdateRequest, web_server: ?*Build.WebServer, gpa: Allocator) !?Path {
     const b = s.owner;
     const arena = b.allocator;
 
     var timer = try std.time.Timer.start();
+    const trace_start_ns = if (b.graph.trace) |trace| trace.now() else 0;
 
-    try sendMessage(zp.child.stdin.?, .update);
-    if (!watch) try sendMessage(zp.child.stdin.?, .exit);
+    zp.update_done = false;
+    switch (request) {
+        .update_and_exit => {
+            try sendMessage(zp.child.stdin.?, .update);
+            try sendMessage(zp.child.stdin.?, .exit);
+        },
+        .update => try sendMessage(zp.child.stdin.?, .update),
+        .compile => |args| {
+            const body = try std.mem.join(arena, "\x00", args);
+            const header: std.zig.Client.Message.Header = .{
+                .tag = .compile,
+                .bytes_len = @intCast(body.len),
+            };
+            try zp.child.stdin.?.writeAll(std.mem.asBytes(&header));
+            try zp.child.stdin.?.writeAll(body);
+        },
+    }
 
     var result: ?Path = null;
 
@@ -561,7 +698,8 @@ fn zigProcessUpdate(s: *Step, zp: *ZigProcess, watch: bool, web_server: ?*Build.
             .error_bundle => {
                 s.result_error_bundle = try std.zig.Server.allocErrorBundle(gpa, body);
                 // This message indicates the end of the update.
-                if (watch) break :poll;
+                zp.update_done = true;
+                if (request != .update_and_exit) break :poll;
             },
             .emit_digest => {
                 const EmitDigest = std.zig.Server.Message.EmitDigest;
@@ -619,10 +757,11 @@ fn zigProcessUpdate(s: *Step, zp: *ZigProcess, watch: bool, web_server: ?*Build.
                     }
                 }
             },
-            .time_report => if (web_server) |ws| {
+            .time_report => {
                 const TimeReport = std.zig.Server.Message.TimeReport;
                 const tr: *align(1) const TimeReport = @ptrCast(body[0..@sizeOf(TimeReport)]);
-                ws.updateTimeReportCompile(.{
+                if (b.graph.trace) |trace| trace.addCompilePhases(trace_start_ns, tr.stats);
+                if (web_server) |ws| ws.updateTimeReportCompile(.{
                     .compile = s.cast(Step.Compile).?,
                     .use_llvm = tr.flags.use_llvm,
                     .stats = tr.stats,
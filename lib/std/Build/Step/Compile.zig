@@ -107,6 +107,10 @@ link_function_sections: bool = false,
 /// safely garbage-collected during the linking phase.
 link_data_sections: bool = false,
 
+/// (ELF) Emit the DWARF of C objects into `.dwo` files kept in the cache so
+/// that only the skeleton units are processed during the linking phase.
+split_dwarf: ?bool = null,
+
 /// Remove functions and data that are unreachable by the entry point or
 /// exported symbols.
 link_gc_sections: ?bool = null,
@@ -1523,6 +1527,9 @@ fn getZigArgs(compile: *Compile, fuzz: bool) ![][]const u8 {
     if (compile.link_data_sections) {
         try zig_args.append("-fdata-sections");
     }
+    if (compile.split_dwarf) |x| {
+        try zig_args.append(if (x) "-gsplit-dwarf" else "-gno-split-dwarf");
+    }
     if (compile.link_gc_sections) |x| {
         try zig_args.append(if (x) "--gc-sections" else "--no-gc-sections");
     }
@@ -91,6 +91,9 @@ has_side_effects: bool,
 /// tests that are also fuzz tests.
 fuzz_tests: std.ArrayListUnmanaged(u32),
 cached_test_metadata: ?CachedTestMetadata = null,
+/// If this is a Zig unit test binary, the outcome of each of its tests from
+/// previous runs, which lets tests be skipped. Set by `make`.
+test_record: ?TestRecord = null,
 
 /// Populated during the fuzz phase if this run step corresponds to a unit test
 /// executable that contains fuzz tests.
@@ -902,6 +905,10 @@ fn make(step: *Step, options: Step.MakeOptions) !void {
     }
 
     hashStdIo(&man.hash, run.stdio);
+    if (run.stdio == .zig_test) if (b.graph.test_shard) |shard| {
+        man.hash.add(shard.index);
+        man.hash.add(shard.count);
+    };
 
     for (run.file_inputs.items) |lazy_path| {
         _ = try man.addFile(lazy_path.getPath2(b, step), null);
@@ -968,8 +975,15 @@ fn make(step: *Step, options: Step.MakeOptions) !void {
                 b.fmt("{s}{s}", .{ placeholder.output.prefix, arg_output_path });
         }
 
+        run.test_record = if (run.stdio == .zig_test and !has_side_effects)
+            try run.loadTestRecord(digest)
+        else
+            null;
+
         try runCommand(run, argv_list.items, has_side_effects, output_dir_path, options, null);
-        if (!has_side_effects) try step.writeManifestAndWatch(&man);
+        // Tests left out by `--rerun-failed` have not passed with these inputs.
+        const partial = if (run.test_record) |record| record.partial else false;
+        if (!has_side_effects and !partial) try step.writeManifestAndWatch(&man);
         return;
     };
 
@@ -1064,6 +1078,7 @@ pub fn rerunInFuzzMode(
     run: *Run,
     fuzz: *std.Build.Fuzz,
     unit_test_index: u32,
+    instance_id: u32,
     prog_node: std.Progress.Node,
 ) !void {
     const step = &run.step;
@@ -1129,6 +1144,7 @@ pub fn rerunInFuzzMode(
         .gpa = undefined, // not used by `runCommand`
     }, .{
         .unit_test_index = unit_test_index,
+        .instance_id = instance_id,
         .fuzz = fuzz,
     });
 }
@@ -1201,6 +1217,8 @@ fn termMatches(expected: ?std.process.Child.Term, actual: std.process.Child.Term
 const FuzzContext = struct {
     fuzz: *std.Build.Fuzz,
     unit_test_index: u32,
+    /// Tells apart the processes fuzzing the same unit test at once.
+    instance_id: u32,
 };
 
 fn runCommand(
@@ -1586,6 +1604,7 @@ fn spawnChildAndCollect(
         run.step.result_duration_ns = timer.read();
         run.step.test_results = res.test_results;
         if (res.test_metadata) |tm| {
+            if (run.test_record) |*record| record.save(run, tm);
             run.cached_test_metadata = tm.toCachedTestMetadata();
             if (options.web_server) |ws| {
                 if (b.graph.time_report) {
@@ -1614,34 +1633,183 @@ fn spawnChildAndCollect(
 
 const StdioPollEnum = enum { stdout, stderr };
 
+/// A subset of the tests of every unit test binary, so that they can be split
+/// across several machines. Test number `i` is part of the shard if
+/// `i % count == index`.
+pub const TestShard = struct {
+    /// Zero-based.
+    index: u32,
+    count: u32,
+
+    /// Parses the one-based `<index>/<count>` syntax of `--test-shard`.
+    pub fn parse(text: []const u8) error{InvalidShard}!TestShard {
+        const slash = std.mem.indexOfScalar(u8, text, '/') orelse return error.InvalidShard;
+        const index = std.fmt.parseUnsigned(u32, text[0..slash], 10) catch return error.InvalidShard;
+        const count = std.fmt.parseUnsigned(u32, text[slash + 1 ..], 10) catch return error.InvalidShard;
+        if (index < 1 or index > count) return error.InvalidShard;
+        return .{ .index = index - 1, .count = count };
+    }
+
+    pub fn contains(shard: TestShard, test_index: usize) bool {
+        return test_index % shard.count == shard.index;
+    }
+};
+
+test TestShard {
+    try std.testing.expectEqual(TestShard{ .index = 1, .count = 3 }, try TestShard.parse("2/3"));
+    try std.testing.expectEqual(TestShard{ .index = 0, .count = 1 }, try TestShard.parse("1/1"));
+    for ([_][]const u8{ "", "2", "0/3", "4/3", "1/0", "a/3", "1/3/5" }) |text| {
+        try std.testing.expectError(error.InvalidShard, TestShard.parse(text));
+    }
+
+    // Every test is part of exactly one shard, and the shards differ in size by at most one.
+    const count = 3;
+    var sizes: [count]usize = @splat(0);
+    for (0..10) |test_index| {
+        var shards: usize = 0;
+        for (&sizes, 0..) |*size, shard_index| {
+            const shard: TestShard = .{ .index = @intCast(shard_index), .count = count };
+            if (!shard.contains(test_index)) continue;
+            shards += 1;
+            size.* += 1;
+        }
+        try std.testing.expectEqual(1, shards);
+    }
+    try std.testing.expectEqualSlices(usize, &.{ 4, 3, 3 }, &sizes);
+}
+
+/// State shared by the processes which run the tests of one unit test binary
+/// at the same time. Messages from the processes are handled under `mutex`.
+const ZigTestWorkers = struct {
+    run: *Run,
+    options: Step.MakeOptions,
+    mutex: std.Thread.Mutex = .{},
+    /// Set once the first process has received the test metadata, or has
+    /// failed to.
+    metadata_ready: std.Thread.ResetEvent = .unset,
+    result: EvalZigTestResult,
+    /// Failures of individual tests. They are reported in test order once all
+    /// processes are done, so that the output does not depend on scheduling.
+    test_errors: std.ArrayListUnmanaged(TestError) = .empty,
+    /// The first error returned by a process other than the first one.
+    err: ?anyerror = null,
+
+    const TestError = struct {
+        index: u32,
+        msg: []const u8,
+    };
+
+    fn addTestError(workers: *ZigTestWorkers, index: u32, comptime fmt: []const u8, args: anytype) !void {
+        const arena = workers.run.step.owner.allocator;
+        try workers.test_errors.append(arena, .{
+            .index = index,
+            .msg = try std.fmt.allocPrint(arena, fmt, args),
+        });
+    }
+
+    fn updatePeakRss(workers: *ZigTestWorkers, child: *const std.process.Child) void {
+        workers.run.step.result_peak_rss = @max(
+            workers.run.step.result_peak_rss,
+            child.resource_usage_statistics.getMaxRss() orelse 0,
+        );
+    }
+};
+
 fn evalZigTest(
     run: *Run,
     child: *std.process.Child,
     options: Step.MakeOptions,
     fuzz_context: ?FuzzContext,
 ) !EvalZigTestResult {
-    const gpa = run.step.owner.allocator;
     const arena = run.step.owner.allocator;
 
     // We will update this every time a child runs.
     run.step.result_peak_rss = 0;
 
-    var result: EvalZigTestResult = .{
-        .test_results = .{
-            .test_count = 0,
-            .skip_count = 0,
-            .fail_count = 0,
-            .crash_count = 0,
-            .timeout_count = 0,
-            .leak_count = 0,
-            .log_err_count = 0,
+    var workers: ZigTestWorkers = .{
+        .run = run,
+        .options = options,
+        .result = .{
+            .test_results = .{
+                .test_count = 0,
+                .skip_count = 0,
+                .fail_count = 0,
+                .crash_count = 0,
+                .timeout_count = 0,
+                .leak_count = 0,
+                .log_err_count = 0,
+            },
+            .test_metadata = null,
         },
-        .test_metadata = null,
     };
 
+    // The other processes start once the first one has received the test metadata.
+    const jobs: u32 = if (builtin.single_threaded or fuzz_context != null) 1 else run.step.owner.graph.test_jobs;
+    const children = try arena.alloc(std.process.Child, jobs - 1);
+    const threads = try arena.alloc(std.Thread, jobs - 1);
+    var threads_len: usize = 0;
+    defer for (threads[0..threads_len]) |thread| thread.join();
+    // With several processes, each one shows the test it is running under a node of its own.
+    const first_prog_node = if (jobs > 1) options.progress_node.start("test process 1", 0) else options.progress_node;
+    defer if (jobs > 1) first_prog_node.end();
+    for (children, threads, 2..) |*other_child, *thread, n| {
+        other_child.* = child.*;
+        const prog_node = options.progress_node.start(run.step.owner.fmt("test process {d}", .{n}), 0);
+        thread.* = std.Thread.spawn(.{}, evalZigTestOther, .{ &workers, other_child, prog_node }) catch |err| {
+            prog_node.end();
+            return err;
+        };
+        threads_len += 1;
+    }
+
+    const first_result = evalZigTestWorker(&workers, child, first_prog_node, fuzz_context);
+    workers.metadata_ready.set();
+    for (threads[0..threads_len]) |thread| thread.join();
+    threads_len = 0;
+
+    std.sort.block(ZigTestWorkers.TestError, workers.test_errors.items, {}, struct {
+        fn lessThan(_: void, a: ZigTestWorkers.TestError, b: ZigTestWorkers.TestError) bool {
+            return a.index < b.index;
+        }
+    }.lessThan);
+    for (workers.test_errors.items) |test_error| try run.step.result_error_msgs.append(arena, test_error.msg);
+    try first_result;
+    if (workers.err) |err| return err;
+
+    return workers.result;
+}
+
+fn evalZigTestOther(workers: *ZigTestWorkers, child: *std.process.Child, prog_node: std.Progress.Node) void {
+    defer prog_node.end();
+    workers.metadata_ready.wait();
+    {
+        workers.mutex.lock();
+        defer workers.mutex.unlock();
+        const metadata = workers.result.test_metadata orelse return;
+        if (metadata.next_index == std.math.maxInt(u32)) return; // nothing left to run
+    }
+    evalZigTestWorker(workers, child, prog_node, null) catch |err| {
+        workers.mutex.lock();
+        defer workers.mutex.unlock();
+        if (workers.err == null) workers.err = err;
+    };
+}
+
+/// Runs tests in `child` until none are left, restarting it whenever a test
+/// crashes or times out. The running test is shown under `prog_node`.
+fn evalZigTestWorker(
+    workers: *ZigTestWorkers,
+    child: *std.process.Child,
+    prog_node: std.Progress.Node,
+    fuzz_context: ?FuzzContext,
+) !void {
+    const run = workers.run;
+    const arena = run.step.owner.allocator;
+    const result = &workers.result;
+
     while (true) {
         try child.spawn();
-        var poller = std.Io.poll(gpa, StdioPollEnum, .{
+        var poller = std.Io.poll(arena, StdioPollEnum, .{
             .stdout = child.stdout.?,
             .stderr = child.stderr.?,
         });
@@ -1649,28 +1817,19 @@ fn evalZigTest(
         defer if (!child_killed) {
             _ = child.kill() catch {};
             poller.deinit();
-            run.step.result_peak_rss = @max(
-                run.step.result_peak_rss,
-                child.resource_usage_statistics.getMaxRss() orelse 0,
-            );
+            workers.mutex.lock();
+            defer workers.mutex.unlock();
+            workers.updatePeakRss(child);
         };
 
         try child.waitForSpawn();
 
-        switch (try pollZigTest(
-            run,
-            child,
-            options,
-            fuzz_context,
-            &poller,
-            &result.test_metadata,
-            &result.test_results,
-        )) {
+        switch (try pollZigTest(workers, child, prog_node, fuzz_context, &poller)) {
             .write_failed => |err| {
                 // The runner unexpectedly closed a stdio pipe, which means a crash. Make sure we've captured
                 // all available stderr to make our error output as useful as possible.
                 while (try poller.poll()) {}
-                run.step.result_stderr = try arena.dupe(u8, poller.reader(.stderr).buffered());
+                const stderr_owned = try arena.dupe(u8, poller.reader(.stderr).buffered());
 
                 // Clean up everything and wait for the child to exit.
                 child.stdin.?.close();
@@ -1678,13 +1837,13 @@ fn evalZigTest(
                 poller.deinit();
                 child_killed = true;
                 const term = try child.wait();
-                run.step.result_peak_rss = @max(
-                    run.step.result_peak_rss,
-                    child.resource_usage_statistics.getMaxRss() orelse 0,
-                );
 
+                workers.mutex.lock();
+                defer workers.mutex.unlock();
+                workers.updatePeakRss(child);
+                run.step.result_stderr = stderr_owned;
                 try run.step.addError("unable to write stdin ({t}); test process unexpectedly {f}", .{ err, fmtTerm(term) });
-                return result;
+                return;
             },
             .no_poll => |no_poll| {
                 // This might be a success (we requested exit and the child dutifully closed stdout) or
@@ -1698,17 +1857,18 @@ fn evalZigTest(
                 poller.deinit();
                 child_killed = true;
                 const term = try child.wait();
-                run.step.result_peak_rss = @max(
-                    run.step.result_peak_rss,
-                    child.resource_usage_statistics.getMaxRss() orelse 0,
-                );
+
+                workers.mutex.lock();
+                defer workers.mutex.unlock();
+                workers.updatePeakRss(child);
 
                 if (no_poll.active_test_index) |test_index| {
                     // A test was running, so this is definitely a crash. Report it against that
                     // test, and continue to the next test.
                     result.test_metadata.?.ns_per_test[test_index] = no_poll.ns_elapsed;
+                    result.test_metadata.?.recordResult(run, test_index, .fail);
                     result.test_results.crash_count += 1;
-                    try run.step.addError("'{s}' {f}{s}{s}", .{
+                    try workers.addTestError(test_index, "'{s}' {f}{s}{s}", .{
                         result.test_metadata.?.testName(test_index),
                         fmtTerm(term),
                         if (stderr_owned.len != 0) " with stderr:\n" else "",
@@ -1723,17 +1883,22 @@ fn evalZigTest(
                 if (!tests_done or !termMatches(.{ .Exited = 0 }, term)) {
                     try run.step.addError("test process unexpectedly {f}", .{fmtTerm(term)});
                 }
-                return result;
+                return;
             },
             .timeout => |timeout| {
                 const stderr = poller.reader(.stderr).buffered();
                 poller.reader(.stderr).tossBuffered();
+
+                workers.mutex.lock();
+                defer workers.mutex.unlock();
+
                 if (timeout.active_test_index) |test_index| {
                     // A test was running. Report the timeout against that test, and continue on to
                     // the next test.
                     result.test_metadata.?.ns_per_test[test_index] = timeout.ns_elapsed;
+                    result.test_metadata.?.recordResult(run, test_index, .fail);
                     result.test_results.timeout_count += 1;
-                    try run.step.addError("'{s}' timed out after {D}{s}{s}", .{
+                    try workers.addTestError(test_index, "'{s}' timed out after {D}{s}{s}", .{
                         result.test_metadata.?.testName(test_index),
                         timeout.ns_elapsed,
                         if (stderr.len != 0) " with stderr:\n" else "",
@@ -1755,13 +1920,11 @@ fn evalZigTest(
 /// * A test (or a response from the test runner) times out
 /// * `poll` fails, indicating the child closed stdout and stderr
 fn pollZigTest(
-    run: *Run,
+    workers: *ZigTestWorkers,
     child: *std.process.Child,
-    options: Step.MakeOptions,
+    prog_node: std.Progress.Node,
     fuzz_context: ?FuzzContext,
     poller: *std.Io.Poller(StdioPollEnum),
-    opt_metadata: *?TestMetadata,
-    results: *Step.TestResults,
 ) !union(enum) {
     write_failed: anyerror,
     no_poll: struct {
@@ -1773,39 +1936,58 @@ fn pollZigTest(
         ns_elapsed: u64,
     },
 } {
+    const run = workers.run;
+    const options = workers.options;
+    const opt_metadata = &workers.result.test_metadata;
+    const results = &workers.result.test_results;
     const gpa = run.step.owner.allocator;
     const arena = run.step.owner.allocator;
 
     var sub_prog_node: ?std.Progress.Node = null;
     defer if (sub_prog_node) |n| n.end();
 
-    if (fuzz_context) |ctx| {
-        assert(opt_metadata.* == null); // fuzz processes are never restarted
-        switch (ctx.fuzz.mode) {
-            .forever => {
-                sendRunFuzzTestMessage(
-                    child.stdin.?,
-                    ctx.unit_test_index,
-                    .forever,
-                    0, // instance ID; will be used by multiprocess forever fuzzing in the future
-                ) catch |err| return .{ .write_failed = err };
-            },
-            .limit => |limit| {
-                sendRunFuzzTestMessage(
-                    child.stdin.?,
-                    ctx.unit_test_index,
-                    .iterations,
-                    limit.amount,
-                ) catch |err| return .{ .write_failed = err };
-            },
+    // The test which was last requested from this process.
+    var requested_index: ?u32 = null;
+
+    {
+        workers.mutex.lock();
+        defer workers.mutex.unlock();
+        if (fuzz_context) |ctx| {
+            assert(opt_metadata.* == null); // fuzz processes are never restarted
+            switch (ctx.fuzz.mode) {
+                .forever => {
+                    sendRunFuzzTestMessage(
+                        child.stdin.?,
+                        ctx.unit_test_index,
+                        .forever,
+                        ctx.instance_id,
+                    ) catch |err| return .{ .write_failed = err };
+                },
+                .limit => |limit| {
+                    sendRunFuzzTestMessage(
+                        child.stdin.?,
+                        ctx.unit_test_index,
+                        .iterations,
+                        limit.amount,
+                    ) catch |err| return .{ .write_failed = err };
+                },
+                .minimize => {
+                    sendRunFuzzTestMessage(
+                        child.stdin.?,
+                        ctx.unit_test_index,
+                        .minimize,
+                        @as(u64, ctx.fuzz.instances_per_test) << 32 | ctx.instance_id,
+                    ) catch |err| return .{ .write_failed = err };
+                },
+            }
+        } else if (opt_metadata.*) |*md| {
+            // Previous unit test process died or was killed; we're continuing where it left off
+            requested_index = requestNextTest(child.stdin.?, md, prog_node, &sub_prog_node) catch |err| return .{ .write_failed = err };
+        } else {
+            // Running unit tests normally
+            run.fuzz_tests.clearRetainingCapacity();
+            sendMessage(child.stdin.?, .query_test_metadata) catch |err| return .{ .write_failed = err };
         }
-    } else if (opt_metadata.*) |*md| {
-        // Previous unit test process died or was killed; we're continuing where it left off
-        requestNextTest(child.stdin.?, md, &sub_prog_node) catch |err| return .{ .write_failed = err };
-    } else {
-        // Running unit tests normally
-        run.fuzz_tests.clearRetainingCapacity();
-        sendMessage(child.stdin.?, .query_test_metadata) catch |err| return .{ .write_failed = err };
     }
 
     var active_test_index: ?u32 = null;
@@ -1877,138 +2059,155 @@ fn pollZigTest(
             .ns_elapsed = if (timer) |*t| t.read() else 0,
         } };
         const body = stdout.take(header.bytes_len) catch unreachable;
-        switch (header.tag) {
-            .zig_version => {
-                if (!std.mem.eql(u8, builtin.zig_version_string, body)) return run.step.fail(
-                    "zig version mismatch build runner vs compiler: '{s}' vs '{s}'",
-                    .{ builtin.zig_version_string, body },
-                );
-            },
-            .test_metadata => {
-                assert(fuzz_context == null);
-
-                // `metadata` would only be populated if we'd already seen a `test_metadata`, but we
-                // only request it once (and importantly, we don't re-request it if we kill and
-                // restart the test runner).
-                assert(opt_metadata.* == null);
-
-                const TmHdr = std.zig.Server.Message.TestMetadata;
-                const tm_hdr: *align(1) const TmHdr = @ptrCast(body);
-                results.test_count = tm_hdr.tests_len;
-
-                const names_bytes = body[@sizeOf(TmHdr)..][0 .. results.test_count * @sizeOf(u32)];
-                const expected_panic_msgs_bytes = body[@sizeOf(TmHdr) + names_bytes.len ..][0 .. results.test_count * @sizeOf(u32)];
-                const string_bytes = body[@sizeOf(TmHdr) + names_bytes.len + expected_panic_msgs_bytes.len ..][0..tm_hdr.string_bytes_len];
-
-                const names = std.mem.bytesAsSlice(u32, names_bytes);
-                const expected_panic_msgs = std.mem.bytesAsSlice(u32, expected_panic_msgs_bytes);
-
-                const names_aligned = try arena.alloc(u32, names.len);
-                for (names_aligned, names) |*dest, src| dest.* = src;
-
-                const expected_panic_msgs_aligned = try arena.alloc(u32, expected_panic_msgs.len);
-                for (expected_panic_msgs_aligned, expected_panic_msgs) |*dest, src| dest.* = src;
-
-                options.progress_node.setEstimatedTotalItems(names.len);
-                opt_metadata.* = .{
-                    .string_bytes = try arena.dupe(u8, string_bytes),
-                    .ns_per_test = try arena.alloc(u64, results.test_count),
-                    .names = names_aligned,
-                    .expected_panic_msgs = expected_panic_msgs_aligned,
-                    .next_index = 0,
-                    .prog_node = options.progress_node,
-                };
-                @memset(opt_metadata.*.?.ns_per_test, std.math.maxInt(u64));
-
-                active_test_index = null;
-                if (timer) |*t| t.reset();
-
-                requestNextTest(child.stdin.?, &opt_metadata.*.?, &sub_prog_node) catch |err| return .{ .write_failed = err };
-            },
-            .test_started => {
-                active_test_index = opt_metadata.*.?.next_index - 1;
-                if (timer) |*t| t.reset();
-            },
-            .test_results => {
-                assert(fuzz_context == null);
-                const md = &opt_metadata.*.?;
-
-                const TrHdr = std.zig.Server.Message.TestResults;
-                const tr_hdr: *align(1) const TrHdr = @ptrCast(body);
-                assert(tr_hdr.index == active_test_index);
-
-                switch (tr_hdr.flags.status) {
-                    .pass => {},
-                    .skip => results.skip_count +|= 1,
-                    .fail => results.fail_count +|= 1,
-                }
-                const leak_count = tr_hdr.flags.leak_count;
-                const log_err_count = tr_hdr.flags.log_err_count;
-                results.leak_count +|= leak_count;
-                results.log_err_count +|= log_err_count;
-
-                if (tr_hdr.flags.fuzz) try run.fuzz_tests.append(gpa, tr_hdr.index);
-
-                if (tr_hdr.flags.status == .fail) {
-                    const name = std.mem.sliceTo(md.testName(tr_hdr.index), 0);
-                    const stderr_bytes = std.mem.trim(u8, stderr.buffered(), "\n");
-                    stderr.tossBuffered();
-                    if (stderr_bytes.len == 0) {
-                        try run.step.addError("'{s}' failed without output", .{name});
-                    } else {
-                        try run.step.addError("'{s}' failed:\n{s}", .{ name, stderr_bytes });
+        {
+            workers.mutex.lock();
+            defer workers.mutex.unlock();
+            switch (header.tag) {
+                .zig_version => {
+                    if (!std.mem.eql(u8, builtin.zig_version_string, body)) return run.step.fail(
+                        "zig version mismatch build runner vs compiler: '{s}' vs '{s}'",
+                        .{ builtin.zig_version_string, body },
+                    );
+                },
+                .test_metadata => {
+                    assert(fuzz_context == null);
+
+                    // `metadata` would only be populated if we'd already seen a `test_metadata`, but we
+                    // only request it once (and importantly, we don't re-request it if we kill and
+                    // restart the test runner).
+                    assert(opt_metadata.* == null);
+
+                    const TmHdr = std.zig.Server.Message.TestMetadata;
+                    const tm_hdr: *align(1) const TmHdr = @ptrCast(body);
+                    results.test_count = tm_hdr.tests_len;
+
+                    const names_bytes = body[@sizeOf(TmHdr)..][0 .. results.test_count * @sizeOf(u32)];
+                    const expected_panic_msgs_bytes = body[@sizeOf(TmHdr) + names_bytes.len ..][0 .. results.test_count * @sizeOf(u32)];
+                    const string_bytes = body[@sizeOf(TmHdr) + names_bytes.len + expected_panic_msgs_bytes.len ..][0..tm_hdr.string_bytes_len];
+
+                    const names = std.mem.bytesAsSlice(u32, names_bytes);
+                    const expected_panic_msgs = std.mem.bytesAsSlice(u32, expected_panic_msgs_bytes);
+
+                    const names_aligned = try arena.alloc(u32, names.len);
+                    for (names_aligned, names) |*dest, src| dest.* = src;
+
+                    const expected_panic_msgs_aligned = try arena.alloc(u32, expected_panic_msgs.len);
+                    for (expected_panic_msgs_aligned, expected_panic_msgs) |*dest, src| dest.* = src;
+
+                    opt_metadata.* = .{
+                        .string_bytes = try arena.dupe(u8, string_bytes),
+                        .ns_per_test = try arena.alloc(u64, results.test_count),
+                        .recorded = try arena.alloc(?TestRecord.Entry, results.test_count),
+                        .selected = try arena.alloc(bool, results.test_count),
+                        .names = names_aligned,
+                        .expected_panic_msgs = expected_panic_msgs_aligned,
+                        .next_index = 0,
+                        .prog_node = options.progress_node,
+                    };
+                    @memset(opt_metadata.*.?.ns_per_test, std.math.maxInt(u64));
+                    @memset(opt_metadata.*.?.recorded, null);
+                    @memset(opt_metadata.*.?.selected, true);
+                    try run.selectTests(&opt_metadata.*.?, results);
+                    options.progress_node.setEstimatedTotalItems(results.test_count);
+                    workers.metadata_ready.set();
+
+                    active_test_index = null;
+                    if (timer) |*t| t.reset();
+
+                    requested_index = requestNextTest(child.stdin.?, &opt_metadata.*.?, prog_node, &sub_prog_node) catch |err| return .{ .write_failed = err };
+                },
+                .test_started => {
+                    active_test_index = requested_index;
+                    if (timer) |*t| t.reset();
+                },
+                .test_results => {
+                    assert(fuzz_context == null);
+                    const md = &opt_metadata.*.?;
+
+                    const TrHdr = std.zig.Server.Message.TestResults;
+                    const tr_hdr: *align(1) const TrHdr = @ptrCast(body);
+                    assert(tr_hdr.index == active_test_index);
+
+                    switch (tr_hdr.flags.status) {
+                        .pass => {},
+                        .skip => results.skip_count +|= 1,
+                        .fail => results.fail_count +|= 1,
+                    }
+                    const leak_count = tr_hdr.flags.leak_count;
+                    const log_err_count = tr_hdr.flags.log_err_count;
+                    results.leak_count +|= leak_count;
+                    results.log_err_count +|= log_err_count;
+                    // Leaks and logged errors fail the step, so the test must run again to report them.
+                    const recorded_status: TestRecord.Status = if (leak_count > 0 or log_err_count > 0) .fail else switch (tr_hdr.flags.status) {
+                        .pass => if (tr_hdr.flags.fuzz) .fuzz else .pass,
+                        .skip => .skip,
+                        .fail => .fail,
+                    };
+                    md.recordResult(run, tr_hdr.index, recorded_status);
+
+                    if (tr_hdr.flags.fuzz) try run.fuzz_tests.append(gpa, tr_hdr.index);
+
+                    if (tr_hdr.flags.status == .fail) {
+                        const name = std.mem.sliceTo(md.testName(tr_hdr.index), 0);
+                        const stderr_bytes = std.mem.trim(u8, stderr.buffered(), "\n");
+                        stderr.tossBuffered();
+                        if (stderr_bytes.len == 0) {
+                            try workers.addTestError(tr_hdr.index, "'{s}' failed without output", .{name});
+                        } else {
+                            try workers.addTestError(tr_hdr.index, "'{s}' failed:\n{s}", .{ name, stderr_bytes });
+                        }
+                    } else if (leak_count > 0) {
+                        const name = std.mem.sliceTo(md.testName(tr_hdr.index), 0);
+                        const stderr_bytes = std.mem.trim(u8, stderr.buffered(), "\n");
+                        stderr.tossBuffered();
+                        try workers.addTestError(tr_hdr.index, "'{s}' leaked {d} allocations:\n{s}", .{ name, leak_count, stderr_bytes });
+                    } else if (log_err_count > 0) {
+                        const name = std.mem.sliceTo(md.testName(tr_hdr.index), 0);
+                        const stderr_bytes = std.mem.trim(u8, stderr.buffered(), "\n");
+                        stderr.tossBuffered();
+                        try workers.addTestError(tr_hdr.index, "'{s}' logged {d} errors:\n{s}", .{ name, log_err_count, stderr_bytes });
                     }
-                } else if (leak_count > 0) {
-                    const name = std.mem.sliceTo(md.testName(tr_hdr.index), 0);
-                    const stderr_bytes = std.mem.trim(u8, stderr.buffered(), "\n");
-                    stderr.tossBuffered();
-                    try run.step.addError("'{s}' leaked {d} allocations:\n{s}", .{ name, leak_count, stderr_bytes });
-                } else if (log_err_count > 0) {
-                    const name = std.mem.sliceTo(md.testName(tr_hdr.index), 0);
-                    const stderr_bytes = std.mem.trim(u8, stderr.buffered(), "\n");
-                    stderr.tossBuffered();
-                    try run.step.addError("'{s}' logged {d} errors:\n{s}", .{ name, log_err_count, stderr_bytes });
-                }
 
-                active_test_index = null;
-                if (timer) |*t| md.ns_per_test[tr_hdr.index] = t.lap();
+                    active_test_index = null;
+                    if (timer) |*t| md.ns_per_test[tr_hdr.index] = t.lap();
 
-                requestNextTest(child.stdin.?, md, &sub_prog_node) catch |err| return .{ .write_failed = err };
-            },
-            .coverage_id => {
-                const fuzz = fuzz_context.?.fuzz;
-                const msg_ptr: *align(1) const [4]u64 = @ptrCast(body);
-                coverage_id = msg_ptr[0];
-                {
-                    fuzz.queue_mutex.lock();
-                    defer fuzz.queue_mutex.unlock();
-                    try fuzz.msg_queue.append(fuzz.gpa, .{ .coverage = .{
-                        .id = coverage_id.?,
-                        .cumulative = .{
-                            .runs = msg_ptr[1],
-                            .unique = msg_ptr[2],
-                            .coverage = msg_ptr[3],
-                        },
-                        .run = run,
-                    } });
-                    fuzz.queue_cond.signal();
-                }
-            },
-            .fuzz_start_addr => {
-                const fuzz = fuzz_context.?.fuzz;
-                const msg_ptr: *align(1) const u64 = @ptrCast(body);
-                const addr = msg_ptr.*;
-                {
-                    fuzz.queue_mutex.lock();
-                    defer fuzz.queue_mutex.unlock();
-                    try fuzz.msg_queue.append(fuzz.gpa, .{ .entry_point = .{
-                        .addr = addr,
-                        .coverage_id = coverage_id.?,
-                    } });
-                    fuzz.queue_cond.signal();
-                }
-            },
-            else => {}, // ignore other messages
+                    requested_index = requestNextTest(child.stdin.?, md, prog_node, &sub_prog_node) catch |err| return .{ .write_failed = err };
+                },
+                .coverage_id => {
+                    const fuzz = fuzz_context.?.fuzz;
+                    const msg_ptr: *align(1) const [4]u64 = @ptrCast(body);
+                    coverage_id = msg_ptr[0];
+                    {
+                        fuzz.queue_mutex.lock();
+                        defer fuzz.queue_mutex.unlock();
+                        try fuzz.msg_queue.append(fuzz.gpa, .{ .coverage = .{
+                            .id = coverage_id.?,
+                            .cumulative = .{
+                                .runs = msg_ptr[1],
+                                .unique = msg_ptr[2],
+                                .coverage = msg_ptr[3],
+                            },
+                            .run = run,
+                        } });
+                        fuzz.queue_cond.signal();
+                    }
+                },
+                .fuzz_start_addr => {
+                    const fuzz = fuzz_context.?.fuzz;
+                    const msg_ptr: *align(1) const u64 = @ptrCast(body);
+                    const addr = msg_ptr.*;
+                    {
+                        fuzz.queue_mutex.lock();
+                        defer fuzz.queue_mutex.unlock();
+                        try fuzz.msg_queue.append(fuzz.gpa, .{ .entry_point = .{
+                            .addr = addr,
+                            .coverage_id = coverage_id.?,
+                        } });
+                        fuzz.queue_cond.signal();
+                    }
+                },
+                else => {}, // ignore other messages
+            }
         }
     }
 }
@@ -2016,6 +2215,11 @@ fn pollZigTest(
 const TestMetadata = struct {
     names: []const u32,
     ns_per_test: []u64,
+    /// The outcome of each test for `Run.test_record`. Tests which already
+    /// have one when they come up are not run.
+    recorded: []?TestRecord.Entry,
+    /// Tests outside of `Graph.test_shard` are not run.
+    selected: []bool,
     expected_panic_msgs: []const u32,
     string_bytes: []const u8,
     next_index: u32,
@@ -2031,8 +2235,205 @@ const TestMetadata = struct {
     fn testName(tm: TestMetadata, index: u32) []const u8 {
         return tm.toCachedTestMetadata().testName(index);
     }
+
+    fn recordResult(tm: TestMetadata, run: *const Run, index: u32, status: TestRecord.Status) void {
+        const record = run.test_record orelse return;
+        tm.recorded[index] = .{ .status = status, .digest = record.digest };
+    }
 };
 
+/// The outcome of each test of a Zig unit test binary, along with the digest
+/// of the step inputs it was obtained with, kept in the local cache across
+/// builds. A test which passed with the same inputs is not run again, and
+/// with `--rerun-failed`, only tests which did not pass the last time they
+/// ran are run.
+const TestRecord = struct {
+    /// Relative to the local cache root.
+    sub_path: []const u8,
+    /// The manifest digest of the current run of the step.
+    digest: Build.Cache.HexDigest,
+    /// Keyed by test name.
+    entries: std.StringHashMapUnmanaged(Entry),
+    /// Whether `--rerun-failed` left out tests which have not passed with the
+    /// current inputs, in which case the step must not be cached as a whole.
+    partial: bool,
+
+    const Status = enum { pass, fuzz, skip, fail };
+
+    const Entry = struct {
+        status: Status,
+        digest: Build.Cache.HexDigest,
+    };
+
+    /// Fills in the outcome of the tests which need not run.
+    fn skipTests(record: *TestRecord, run: *Run, tm: *TestMetadata, results: *Step.TestResults) !void {
+        const gpa = run.step.owner.allocator;
+        const rerun_failed = run.step.owner.graph.rerun_failed_tests;
+        for (tm.recorded, tm.selected, 0..) |*recorded, selected, i| {
+            if (!selected) continue;
+            const index: u32 = @intCast(i);
+            const entry = record.entries.get(tm.testName(index)) orelse continue;
+            if (entry.status == .fail) continue;
+            if (std.mem.eql(u8, &entry.digest, &record.digest)) {
+                if (entry.status == .skip) results.skip_count +|= 1;
+            } else {
+                if (!rerun_failed) continue;
+                results.skip_count +|= 1;
+                record.partial = true;
+            }
+            if (entry.status == .fuzz) try run.fuzz_tests.append(gpa, index);
+            recorded.* = entry;
+            tm.prog_node.completeOne();
+        }
+    }
+
+    /// Failure is only worth a warning, since it only costs running tests again.
+    fn save(record: *const TestRecord, run: *Run, tm: TestMetadata) void {
+        const b = run.step.owner;
+        record.write(b, tm) catch |err| {
+            std.log.warn("unable to save test results in '{f}{s}': {t}", .{ b.cache_root, record.sub_path, err });
+        };
+    }
+
+    fn write(record: *const TestRecord, b: *Build, tm: TestMetadata) !void {
+        try b.cache_root.handle.makePath(fs.path.dirname(record.sub_path).?);
+        var buffer: [4096]u8 = undefined;
+        var af = try b.cache_root.handle.atomicFile(record.sub_path, .{ .write_buffer = &buffer });
+        defer af.deinit();
+        const w = &af.file_writer.interface;
+        for (tm.recorded, 0..) |opt_entry, i| {
+            const entry = opt_entry orelse continue;
+            const name = tm.testName(@intCast(i));
+            if (std.mem.indexOfScalar(u8, name, '\n') != null) continue;
+            w.print("{t} {s} {s}\n", .{ entry.status, &entry.digest, name }) catch return af.file_writer.err.?;
+        }
+        try af.finish();
+    }
+};
+
+/// Leaves out the tests which are not part of `Graph.test_shard`, and those
+/// whose outcome is already known from `test_record`.
+fn selectTests(run: *Run, tm: *TestMetadata, results: *Step.TestResults) !void {
+    if (run.step.owner.graph.test_shard) |shard| {
+        for (tm.selected, 0..) |*selected, i| {
+            if (shard.contains(i)) continue;
+            selected.* = false;
+            results.test_count -= 1;
+            // Keep the outcome recorded by the shard which runs this test.
+            if (run.test_record) |record| tm.recorded[i] = record.entries.get(tm.testName(@intCast(i)));
+        }
+    }
+    if (run.test_record) |*record| try record.skipTests(run, tm, results);
+}
+
+/// The per-test results of a step are found by a key which, unlike the
+/// manifest digest, stays the same when the test binary is rebuilt.
+fn loadTestRecord(run: *Run, digest: Build.Cache.HexDigest) !TestRecord {
+    const b = run.step.owner;
+    const arena = b.allocator;
+
+    var record: TestRecord = .{
+        .sub_path = try run.testRecordSubPath(),
+        .digest = digest,
+        .entries = .empty,
+        .partial = false,
+    };
+
+    const contents = b.cache_root.handle.readFileAlloc(record.sub_path, arena, .limited(64 * 1024 * 1024)) catch return record;
+    var it = std.mem.splitScalar(u8, contents, '\n');
+    while (it.next()) |line| {
+        var fields = std.mem.splitScalar(u8, line, ' ');
+        const status = std.meta.stringToEnum(TestRecord.Status, fields.first()) orelse continue;
+        const entry_digest = fields.next() orelse continue;
+        if (entry_digest.len != Build.Cache.hex_digest_len) continue;
+        try record.entries.put(arena, fields.rest(), .{
+            .status = status,
+            .digest = entry_digest[0..Build.Cache.hex_digest_len].*,
+        });
+    }
+    return record;
+}
+
+/// Returns the path of the test record of this step in the cache. It depends on the
+/// identity of the step rather than on the test binary, so that it survives a rebuild
+/// of the binary.
+fn testRecordSubPath(run: *Run) ![]const u8 {
+    const b = run.step.owner;
+    const arena = b.allocator;
+
+    var hash: Build.Cache.HashHelper = .{};
+    hash.addOptionalBytes(b.build_root.path);
+    hash.addBytes(b.dep_prefix);
+    hash.addBytes(run.step.name);
+    for (run.argv.items) |arg| switch (arg) {
+        .bytes => |bytes| hash.addBytes(bytes),
+        .artifact => |pa| {
+            // The artifacts of a test matrix usually share their name.
+            const artifact = pa.artifact;
+            const target = artifact.rootModuleTarget();
+            hash.addBytes(artifact.name);
+            hash.addBytes(try target.zigTriple(arena));
+            hash.addBytes(target.cpu.model.name);
+            hash.addOptional(artifact.root_module.optimize);
+            if (artifact.root_module.root_source_file) |root| hash.addBytes(root.getDisplayName());
+        },
+        else => {},
+    };
+    return fs.path.join(arena, &.{ "t", &hash.final() });
+}
+
+test testRecordSubPath {
+    if (builtin.os.tag == .wasi) return error.SkipZigTest;
+
+    const io = std.testing.io;
+
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+
+    var graph: std.Build.Graph = .{
+        .io = io,
+        .arena = arena.allocator(),
+        .cache = .{
+            .io = io,
+            .gpa = arena.allocator(),
+            .manifest_dir = std.fs.cwd(),
+        },
+        .zig_exe = "test",
+        .env_map = std.process.EnvMap.init(arena.allocator()),
+        .global_cache_root = .{ .path = "test", .handle = std.fs.cwd() },
+        .host = .{
+            .query = .{},
+            .result = try std.zig.system.resolveTargetQuery(io, .{}),
+        },
+        .zig_lib_directory = std.Build.Cache.Directory.cwd(),
+        .time_report = false,
+    };
+
+    var b = try std.Build.create(
+        &graph,
+        .{ .path = "test", .handle = std.fs.cwd() },
+        .{ .path = "test", .handle = std.fs.cwd() },
+        &.{},
+    );
+
+    // Both artifacts are named "test", and so are the steps running them.
+    var sub_paths: [3][]const u8 = undefined;
+    for (&sub_paths, [_]std.Target.Query{
+        .{ .cpu_arch = .x86_64, .os_tag = .linux },
+        .{ .cpu_arch = .aarch64, .os_tag = .linux },
+        .{ .cpu_arch = .x86_64, .os_tag = .linux },
+    }) |*sub_path, query| {
+        const artifact = b.addTest(.{ .root_module = b.createModule(.{
+            .root_source_file = b.path("main.zig"),
+            .target = b.resolveTargetQuery(query),
+            .optimize = .Debug,
+        }) });
+        sub_path.* = try b.addRunArtifact(artifact).testRecordSubPath();
+    }
+    try std.testing.expect(!mem.eql(u8, sub_paths[0], sub_paths[1]));
+    try std.testing.expectEqualStrings(sub_paths[0], sub_paths[2]);
+}
+
 pub const CachedTestMetadata = struct {
     names: []const u32,
     string_bytes: []const u8,
@@ -2042,22 +2443,33 @@ pub const CachedTestMetadata = struct {
     }
 };
 
-fn requestNextTest(in: fs.File, metadata: *TestMetadata, sub_prog_node: *?std.Progress.Node) !void {
+/// Returns the index of the requested test, or `null` if there are none left
+/// and the process was told to exit instead.
+fn requestNextTest(
+    in: fs.File,
+    metadata: *TestMetadata,
+    prog_node: std.Progress.Node,
+    sub_prog_node: *?std.Progress.Node,
+) !?u32 {
     while (metadata.next_index < metadata.names.len) {
         const i = metadata.next_index;
         metadata.next_index += 1;
 
         if (metadata.expected_panic_msgs[i] != 0) continue;
+        if (!metadata.selected[i]) continue;
+        // The outcome of this test is already known from `Run.test_record`.
+        if (metadata.recorded[i] != null) continue;
 
         const name = metadata.testName(i);
         if (sub_prog_node.*) |n| n.end();
-        sub_prog_node.* = metadata.prog_node.start(name, 0);
+        sub_prog_node.* = prog_node.start(name, 0);
 
         try sendRunTestMessage(in, .run_test, i);
-        return;
+        return i;
     } else {
         metadata.next_index = std.math.maxInt(u32); // indicate that all tests are done
         try sendMessage(in, .exit);
+        return null;
     }
 }
 
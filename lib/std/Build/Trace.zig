@@ -0,0 +1,236 @@
+//! A timeline of a build, written with `zig build --trace=[file]` in the
+//! Chrome trace event format, which can be opened in Perfetto or
+//! `chrome://tracing`.
+//!
+//! Every step which runs is a slice on the thread which ran it, annotated with
+//! its outcome, whether it was a cache hit, and its peak memory usage. With
+//! `--time-report`, the phases of each compilation are nested inside the slice
+//! of the `Step.Compile` which requested it.
+
+const Trace = @This();
+
+const std = @import("../std.zig");
+const Step = std.Build.Step;
+const Allocator = std.mem.Allocator;
+const Io = std.Io;
+const Writer = Io.Writer;
+const Stats = std.Build.abi.time_report.CompileResult.Stats;
+
+gpa: Allocator,
+io: Io,
+/// Protects `events` and `base_timestamp`.
+mutex: std.Thread.Mutex,
+/// Allocated into `gpa`.
+events: std.ArrayListUnmanaged(Event),
+/// The start of the current build, which all event timestamps are relative to.
+base_timestamp: Io.Timestamp,
+
+const clock: Io.Clock = .awake;
+
+pub const Event = struct {
+    /// Not owned by the trace; step names outlive it.
+    name: []const u8,
+    tid: std.Thread.Id,
+    start_ns: u64,
+    duration_ns: u64,
+    args: Args,
+
+    pub const Args = union(enum) {
+        step: struct {
+            state: Step.State,
+            cached: bool,
+            peak_rss: usize,
+        },
+        compile_phase: struct {
+            /// Summed over all compiler threads, so it can exceed the
+            /// duration of the phase.
+            cpu_ns: u64,
+        },
+    };
+};
+
+pub fn init(gpa: Allocator, io: Io) Io.Clock.Error!Trace {
+    return .{
+        .gpa = gpa,
+        .io = io,
+        .mutex = .{},
+        .events = .empty,
+        .base_timestamp = try clock.now(io),
+    };
+}
+
+pub fn deinit(trace: *Trace) void {
+    trace.events.deinit(trace.gpa);
+    trace.* = undefined;
+}
+
+/// Discards all events, so that the trace covers only the next build.
+pub fn reset(trace: *Trace) void {
+    trace.mutex.lock();
+    defer trace.mutex.unlock();
+    trace.events.clearRetainingCapacity();
+    trace.base_timestamp = clock.now(trace.io) catch trace.base_timestamp;
+}
+
+/// Returns the timestamp to pass as `start_ns`.
+pub fn now(trace: *Trace) u64 {
+    trace.mutex.lock();
+    defer trace.mutex.unlock();
+    return trace.read();
+}
+
+/// Asserts the mutex is held.
+fn read(trace: *Trace) u64 {
+    const ts = clock.now(trace.io) catch trace.base_timestamp;
+    return std.math.lossyCast(u64, trace.base_timestamp.durationTo(ts).toNanoseconds());
+}
+
+/// Records a step which has finished running on the calling thread.
+pub fn addStep(trace: *Trace, s: *const Step, start_ns: u64, state: Step.State) void {
+    trace.mutex.lock();
+    defer trace.mutex.unlock();
+    trace.events.append(trace.gpa, .{
+        .name = s.name,
+        .tid = std.Thread.getCurrentId(),
+        .start_ns = start_ns,
+        .duration_ns = trace.read() -| start_ns,
+        .args = .{ .step = .{
+            .state = state,
+            .cached = s.result_cached,
+            .peak_rss = s.result_peak_rss,
+        } },
+    }) catch @panic("OOM");
+}
+
+/// Records the phases of a compilation which has just finished, as reported
+/// by the compiler. They are placed back to back, ending now, but not before
+/// `update_start_ns`, when the update was requested.
+pub fn addCompilePhases(trace: *Trace, update_start_ns: u64, stats: Stats) void {
+    const phases = [_]struct { []const u8, u64, u64 }{
+        .{ "AstGen", stats.real_ns_files, stats.cpu_ns_parse + stats.cpu_ns_astgen },
+        .{ "Sema and codegen", stats.real_ns_decls, stats.cpu_ns_sema + stats.cpu_ns_codegen },
+        .{ "LLVM emit", stats.real_ns_llvm_emit, 0 },
+        .{ "Link", stats.real_ns_link_flush, stats.cpu_ns_link },
+    };
+    var total_ns: u64 = 0;
+    for (phases) |phase| total_ns += phase[1];
+
+    trace.mutex.lock();
+    defer trace.mutex.unlock();
+    const tid = std.Thread.getCurrentId();
+    var start_ns = @max(trace.read() -| total_ns, update_start_ns);
+    for (phases) |phase| {
+        const name, const real_ns, const cpu_ns = phase;
+        if (real_ns == 0) continue;
+        trace.events.append(trace.gpa, .{
+            .name = name,
+            .tid = tid,
+            .start_ns = start_ns,
+            .duration_ns = real_ns,
+            .args = .{ .compile_phase = .{ .cpu_ns = cpu_ns } },
+        }) catch @panic("OOM");
+        start_ns += real_ns;
+    }
+}
+
+pub fn write(trace: *Trace, w: *Writer) Writer.Error!void {
+    trace.mutex.lock();
+    defer trace.mutex.unlock();
+
+    try w.writeAll(
+        \\{"displayTimeUnit":"ms","traceEvents":[
+        \\{"ph":"M","pid":1,"tid":0,"name":"process_name","args":{"name":"zig build"}}
+    );
+    for (trace.events.items) |event| {
+        try w.print(",\n{{\"ph\":\"X\",\"pid\":1,\"tid\":{d},\"name\":{f},\"cat\":\"{t}\",\"ts\":{f},\"dur\":{f},\"args\":", .{
+            event.tid,
+            std.json.fmt(event.name, .{}),
+            event.args,
+            fmtMicroseconds(event.start_ns),
+            fmtMicroseconds(event.duration_ns),
+        });
+        switch (event.args) {
+            .step => |step| try w.print("{{\"state\":\"{t}\",\"cached\":{},\"peak_rss\":{d}}}}}", .{
+                step.state, step.cached, step.peak_rss,
+            }),
+            .compile_phase => |phase| try w.print("{{\"cpu_ms\":{f}}}}}", .{fmtMilliseconds(phase.cpu_ns)}),
+        }
+    }
+    try w.writeAll("\n]}\n");
+}
+
+/// Failure is only worth a warning, since the build itself is unaffected.
+pub fn save(trace: *Trace, path: []const u8) void {
+    trace.writeFile(path) catch |err| {
+        std.log.warn("unable to write trace to '{s}': {t}", .{ path, err });
+    };
+}
+
+fn writeFile(trace: *Trace, path: []const u8) !void {
+    var buffer: [4096]u8 = undefined;
+    var af = try std.fs.cwd().atomicFile(path, .{ .write_buffer = &buffer });
+    defer af.deinit();
+    trace.write(&af.file_writer.interface) catch return af.file_writer.err.?;
+    try af.finish();
+}
+
+/// The trace event format counts time in microseconds.
+fn fmtMicroseconds(ns: u64) std.fmt.Alt(u64, formatFraction(std.time.ns_per_us)) {
+    return .{ .data = ns };
+}
+
+fn fmtMilliseconds(ns: u64) std.fmt.Alt(u64, formatFraction(std.time.ns_per_ms)) {
+    return .{ .data = ns };
+}
+
+fn formatFraction(comptime unit: u64) fn (u64, *Writer) Writer.Error!void {
+    return struct {
+        fn format(ns: u64, w: *Writer) Writer.Error!void {
+            try w.print("{d}.{d:0>3}", .{ ns / unit, ns % unit * 1000 / unit });
+        }
+    }.format;
+}
+
+test write {
+    const gpa = std.testing.allocator;
+    var trace: Trace = .{
+        .gpa = gpa,
+        .io = undefined,
+        .mutex = .{},
+        .events = .empty,
+        .base_timestamp = undefined,
+    };
+    defer trace.deinit();
+    try trace.events.appendSlice(gpa, &.{
+        .{
+            .name = "compile exe \"foo\"",
+            .tid = 7,
+            .start_ns = 1_500,
+            .duration_ns = 2_000_250,
+            .args = .{ .step = .{ .state = .success, .cached = false, .peak_rss = 4096 } },
+        },
+        .{
+            .name = "Sema and codegen",
+            .tid = 7,
+            .start_ns = 2_000,
+            .duration_ns = 1_000_000,
+            .args = .{ .compile_phase = .{ .cpu_ns = 3_500_000 } },
+        },
+    });
+
+    var out: Writer.Allocating = .init(gpa);
+    defer out.deinit();
+    try trace.write(&out.writer);
+    try std.testing.expectEqualStrings(
+        \\{"displayTimeUnit":"ms","traceEvents":[
+        \\{"ph":"M","pid":1,"tid":0,"name":"process_name","args":{"name":"zig build"}},
+        \\{"ph":"X","pid":1,"tid":7,"name":"compile exe \"foo\"","cat":"step","ts":1.500,"dur":2000.250,"args":{"state":"success","cached":false,"peak_rss":4096}},
+        \\{"ph":"X","pid":1,"tid":7,"name":"Sema and codegen","cat":"compile_phase","ts":2.000,"dur":1000.000,"args":{"cpu_ms":3.500}}
+        \\]}
+        \\
+    , out.written());
+
+    // The output must be valid JSON.
+    const parsed = try std.json.parseFromSlice(std.json.Value, gpa, out.written(), .{});
+    defer parsed.deinit();
+}
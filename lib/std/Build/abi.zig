@@ -142,9 +142,19 @@ pub const fuzz = struct {
     pub const TestOne = *const fn (Slice) callconv(.c) void;
     pub extern fn fuzzer_init(cache_dir_path: Slice) void;
     pub extern fn fuzzer_coverage() Coverage;
-    pub extern fn fuzzer_init_test(test_one: TestOne, unit_test_name: Slice) void;
+    /// `instance_id` tells apart the processes fuzzing the same test at once,
+    /// which share their corpus through the cache directory. With
+    /// `fork_server`, `test_one` is only called in forked child processes.
+    pub extern fn fuzzer_init_test(test_one: TestOne, unit_test_name: Slice, instance_id: u32, fork_server: bool) void;
     pub extern fn fuzzer_new_input(bytes: Slice) void;
     pub extern fn fuzzer_main(limit_kind: LimitKind, amount: u64) void;
+    /// Instead of fuzzing, runs the corpus files of the unit test whose index
+    /// modulo `instance_count` is `instance_id`, and writes the file
+    /// `cmin{instance_id}` into the corpus directory. It holds a
+    /// `MinimizeEntry` for each pc, naming the smallest of those inputs to hit
+    /// it. The smallest inputs across all instances together cover everything
+    /// the corpus does.
+    pub extern fn fuzzer_minimize_corpus(test_one: TestOne, unit_test_name: Slice, instance_id: u32, instance_count: u32) void;
 
     pub const Slice = extern struct {
         ptr: [*]const u8,
@@ -159,7 +169,24 @@ pub const fuzz = struct {
         }
     };
 
-    pub const LimitKind = enum(u8) { forever, iterations };
+    pub const LimitKind = enum(u8) {
+        forever,
+        iterations,
+        /// See `fuzzer_minimize_corpus`. The amount holds the instance ID in
+        /// its low 32 bits and the number of instances in its high 32 bits.
+        minimize,
+    };
+
+    /// Ordered by input length first, so that the smallest entry wins.
+    pub const MinimizeEntry = packed struct(u64) {
+        /// Index of the corpus file.
+        index: u32,
+        /// Saturates at the maximum.
+        len: u32,
+
+        /// No input hits the pc.
+        pub const none: MinimizeEntry = @bitCast(~@as(u64, 0));
+    };
 
     /// libfuzzer uses this and its usize is the one that counts. To match the ABI,
     /// make the ints be the size of the target used with libfuzzer.
@@ -228,9 +255,14 @@ pub const fuzz = struct {
     /// * one bit per source_locations_len, contained in u64 elements
     pub const CoverageUpdateHeader = extern struct {
         tag: ToClientTag = .fuzz_coverage_update,
-        _: [7]u8 = @splat(0),
+        _: [3]u8 = @splat(0),
+        /// How many processes are fuzzing the unit tests of this executable.
+        processes: u32,
         n_runs: u64,
         unique_runs: u64,
+        /// `n_runs` when fuzzing started. `n_runs` also counts the runs of
+        /// previous fuzzing sessions which used the same cache directory.
+        start_n_runs: u64,
 
         pub const trailing = .{
             .pc_bits_usize,
@@ -2,12 +2,20 @@ const std = @import("std");
 const builtin = @import("builtin");
 const Pool = @This();
 const WaitGroup = @import("WaitGroup.zig");
+const Jobserver = std.process.Jobserver;
 
 mutex: std.Thread.Mutex = .{},
 cond: std.Thread.Condition = .{},
 run_queue: std.SinglyLinkedList = .{},
 is_running: bool = true,
 allocator: std.mem.Allocator,
+jobserver: ?*Jobserver = null,
+/// The thread which called `init`, which holds the job slot that this process
+/// owns without a jobserver token.
+owner: std.Thread.Id,
+/// When there is a jobserver, `join` writes to this pipe to interrupt workers
+/// waiting for a token.
+wake_pipe: if (Jobserver.is_supported) [2]std.posix.fd_t else void = undefined,
 threads: if (builtin.single_threaded) [0]std.Thread else []std.Thread,
 ids: if (builtin.single_threaded) struct {
     inline fn deinit(_: @This(), _: std.mem.Allocator) void {}
@@ -23,11 +31,22 @@ const Runnable = struct {
 
 const RunProto = *const fn (*Runnable, id: ?usize) void;
 
+/// The pool that the current thread is a worker of, if any.
+threadlocal var current_pool: ?*const Pool = null;
+/// The job slot that the current worker thread runs its job in.
+threadlocal var current_slot: Slot = .unlimited;
+
 pub const Options = struct {
     allocator: std.mem.Allocator,
     n_jobs: ?usize = null,
     track_ids: bool = false,
     stack_size: usize = std.Thread.SpawnConfig.default_stack_size,
+    /// When set, workers share the concurrency limit of the jobserver with the
+    /// rest of the process tree. The slot owned by this process belongs to the
+    /// thread calling `init`, so each worker acquires a token before running a
+    /// job. Jobs run by `waitAndWork` use the slot of the waiting thread
+    /// instead, and `wait` lends it to the workers.
+    jobserver: ?*Jobserver = null,
 };
 
 pub fn init(pool: *Pool, options: Options) !void {
@@ -37,12 +56,19 @@ pub fn init(pool: *Pool, options: Options) !void {
         .allocator = allocator,
         .threads = if (builtin.single_threaded) .{} else &.{},
         .ids = .{},
+        .jobserver = options.jobserver,
+        .owner = std.Thread.getCurrentId(),
     };
 
     if (builtin.single_threaded) {
         return;
     }
 
+    if (Jobserver.is_supported and options.jobserver != null) {
+        pool.wake_pipe = try std.posix.pipe2(.{ .CLOEXEC = true });
+    }
+    errdefer pool.closeWakePipe();
+
     const thread_count = options.n_jobs orelse @max(1, std.Thread.getCpuCount() catch 1);
     if (options.track_ids) {
         try pool.ids.ensureTotalCapacity(allocator, 1 + thread_count);
@@ -65,10 +91,16 @@ pub fn init(pool: *Pool, options: Options) !void {
 
 pub fn deinit(pool: *Pool) void {
     pool.join(pool.threads.len); // kill and join all threads.
+    pool.closeWakePipe();
     pool.ids.deinit(pool.allocator);
     pool.* = undefined;
 }
 
+fn closeWakePipe(pool: *Pool) void {
+    if (builtin.single_threaded or !Jobserver.is_supported or pool.jobserver == null) return;
+    for (pool.wake_pipe) |fd| std.posix.close(fd);
+}
+
 fn join(pool: *Pool, spawned: usize) void {
     if (builtin.single_threaded) {
         return;
@@ -85,6 +117,10 @@ fn join(pool: *Pool, spawned: usize) void {
     // wake up any sleeping threads (this can be done outside the mutex)
     // then wait for all the threads we know are spawned to complete.
     pool.cond.broadcast();
+    if (Jobserver.is_supported and pool.jobserver != null) {
+        // The byte is never read, so that every waiting worker sees it.
+        _ = std.posix.write(pool.wake_pipe[1], "x") catch {};
+    }
     for (pool.threads[0..spawned]) |thread| {
         thread.join();
     }
@@ -276,7 +312,126 @@ test spawn {
     try std.testing.expectEqual(true, completed);
 }
 
+test "jobserver limits concurrency" {
+    if (builtin.single_threaded or !Jobserver.is_supported) return error.SkipZigTest;
+
+    var jobserver: Jobserver = try .initServer(2);
+    defer jobserver.deinit();
+
+    const Counter = struct {
+        mutex: std.Thread.Mutex = .{},
+        running: usize = 0,
+        max_running: usize = 0,
+
+        fn run(counter: *@This()) void {
+            {
+                counter.mutex.lock();
+                defer counter.mutex.unlock();
+                counter.running += 1;
+                counter.max_running = @max(counter.max_running, counter.running);
+            }
+            std.Thread.yield() catch {};
+            counter.mutex.lock();
+            defer counter.mutex.unlock();
+            counter.running -= 1;
+        }
+    };
+    var counter: Counter = .{};
+
+    {
+        var pool: Pool = undefined;
+        try pool.init(.{
+            .allocator = std.testing.allocator,
+            .n_jobs = 4,
+            .jobserver = &jobserver,
+        });
+        defer pool.deinit();
+
+        // This thread works in the slot that the process owns while the first
+        // jobs run, and then lends it to the workers.
+        var wait_group: WaitGroup = .{};
+        {
+            counter.mutex.lock();
+            defer counter.mutex.unlock();
+            counter.running += 1;
+        }
+        for (0..32) |_| pool.spawnWg(&wait_group, Counter.run, .{&counter});
+        std.Thread.yield() catch {};
+        {
+            counter.mutex.lock();
+            defer counter.mutex.unlock();
+            counter.running -= 1;
+        }
+        pool.wait(&wait_group);
+    }
+
+    try std.testing.expect(counter.max_running <= 2);
+    // Every token was returned.
+    try std.testing.expectEqual('+', (try jobserver.acquire(null)).?);
+}
+
+test "deinit while all jobserver tokens are taken" {
+    if (builtin.single_threaded or !Jobserver.is_supported) return error.SkipZigTest;
+
+    var jobserver: Jobserver = try .initServer(2);
+    defer jobserver.deinit();
+    const token = (try jobserver.acquire(null)).?;
+    defer jobserver.release(token);
+
+    const Job = struct {
+        fn run() void {
+            // Keep the slot lent by `wait` busy so that another worker waits for a token.
+            std.Io.Clock.Duration.sleep(.{ .clock = .awake, .raw = .fromMilliseconds(10) }, std.testing.io) catch {};
+        }
+    };
+
+    var pool: Pool = undefined;
+    try pool.init(.{
+        .allocator = std.testing.allocator,
+        .n_jobs = 2,
+        .jobserver = &jobserver,
+    });
+    defer pool.deinit();
+
+    var wait_group: WaitGroup = .{};
+    for (0..2) |_| pool.spawnWg(&wait_group, Job.run, .{});
+    pool.wait(&wait_group);
+}
+
+test "waiting lends the job slot of the process to the workers" {
+    if (builtin.single_threaded or !Jobserver.is_supported) return error.SkipZigTest;
+
+    // A single slot, which this thread holds, so there are no tokens.
+    var jobserver: Jobserver = try .initServer(1);
+    defer jobserver.deinit();
+
+    const Job = struct {
+        fn run(count: *std.atomic.Value(usize)) void {
+            _ = count.fetchAdd(1, .monotonic);
+        }
+    };
+    var count: std.atomic.Value(usize) = .init(0);
+
+    var pool: Pool = undefined;
+    try pool.init(.{
+        .allocator = std.testing.allocator,
+        .n_jobs = 2,
+        .jobserver = &jobserver,
+    });
+    defer pool.deinit();
+
+    var wait_group: WaitGroup = .{};
+    for (0..8) |_| pool.spawnWg(&wait_group, Job.run, .{&count});
+    pool.wait(&wait_group);
+    try std.testing.expectEqual(8, count.load(.monotonic));
+
+    // The slot was taken back, so the jobserver is empty again.
+    var fds = [_]std.posix.pollfd{.{ .fd = jobserver.read_fd, .events = std.posix.POLL.IN, .revents = 0 }};
+    try std.testing.expectEqual(0, try std.posix.poll(&fds, 0));
+}
+
 fn worker(pool: *Pool) void {
+    current_pool = pool;
     pool.mutex.lock();
     defer pool.mutex.unlock();
 
@@ -284,7 +439,17 @@ fn worker(pool: *Pool) void {
     if (id) |_| pool.ids.putAssumeCapacityNoClobber(std.Thread.getCurrentId(), {});
 
     while (true) {
-        while (pool.run_queue.popFirst()) |run_node| {
+        while (pool.run_queue.first != null) {
+            // The slot is acquired before taking a job, so that a job is never stuck
+            // waiting for a token while `waitAndWork` could run it right away.
+            current_slot = pool.acquireSlot();
+            const run_node = pool.run_queue.popFirst() orelse {
+                pool.releaseSlot(current_slot);
+                continue;
+            };
+            // The job may have exchanged its slot for another one in `wait`.
+            defer pool.releaseSlot(current_slot);
+
             // Temporarily unlock the mutex in order to execute the run_node
             pool.mutex.unlock();
             defer pool.mutex.lock();
@@ -302,6 +467,31 @@ fn worker(pool: *Pool) void {
     }
 }
 
+const Slot = union(enum) {
+    unlimited,
+    token: Jobserver.Token,
+};
+
+/// Called with the mutex held, which is released while waiting for a token.
+fn acquireSlot(pool: *Pool) Slot {
+    if (!Jobserver.is_supported) return .unlimited;
+    const jobserver = pool.jobserver orelse return .unlimited;
+    pool.mutex.unlock();
+    defer pool.mutex.lock();
+    // Running the job anyway is better than never running it. This includes
+    // jobs still queued once `join` interrupts the wait.
+    const token = jobserver.acquire(pool.wake_pipe[0]) catch return .unlimited;
+    return .{ .token = token orelse return .unlimited };
+}
+
+/// Called with the mutex held.
+fn releaseSlot(pool: *Pool, slot: Slot) void {
+    switch (slot) {
+        .unlimited => {},
+        .token => |token| if (Jobserver.is_supported) pool.jobserver.?.release(token) else unreachable,
+    }
+}
+
 pub fn waitAndWork(pool: *Pool, wait_group: *WaitGroup) void {
     var id: ?usize = null;
 
@@ -316,11 +506,42 @@ pub fn waitAndWork(pool: *Pool, wait_group: *WaitGroup) void {
         }
 
         pool.mutex.unlock();
-        wait_group.wait();
+        pool.wait(wait_group);
         return;
     }
 }
 
+/// Waits for `wait_group` without running any jobs. When there is a jobserver,
+/// the job slot of the calling thread is given back to it meanwhile, so that
+/// the jobs being waited for can run in it even if no other slot is free, and
+/// taken again afterwards. This is the slot owned by this process for the
+/// thread which called `init`, and the token of the current job for a worker.
+pub fn wait(pool: *Pool, wait_group: *WaitGroup) void {
+    if (builtin.single_threaded or !Jobserver.is_supported) return wait_group.wait();
+    const jobserver = pool.jobserver orelse return wait_group.wait();
+    if (wait_group.isDone()) return;
+    const is_worker = pool.isWorker();
+    const lent_token: Jobserver.Token = if (is_worker) switch (current_slot) {
+        .unlimited => return wait_group.wait(),
+        .token => |token| token,
+    } else if (std.Thread.getCurrentId() == pool.owner)
+        '+'
+    else
+        return wait_group.wait();
+    jobserver.release(lent_token);
+    wait_group.wait();
+    // As with workers, running without a slot is better than not running at all.
+    const token = jobserver.acquire(pool.wake_pipe[0]) catch null;
+    if (is_worker) current_slot = if (token) |t| .{ .token = t } else .unlimited;
+}
+
+/// Whether the calling thread is one of the workers of `pool`. Such a thread
+/// must not block waiting for jobs of `pool` without running them itself, since
+/// every other worker might be doing the same.
+pub fn isWorker(pool: *const Pool) bool {
+    return current_pool == pool;
+}
+
 pub fn getIdCount(pool: *Pool) usize {
     return @intCast(1 + pool.threads.len);
 }
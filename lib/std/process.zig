@@ -12,6 +12,7 @@ const windows = std.os.windows;
 const unicode = std.unicode;
 
 pub const Child = @import("process/Child.zig");
+pub const Jobserver = @import("process/Jobserver.zig");
 pub const abort = posix.abort;
 pub const exit = posix.exit;
 pub const changeCurDir = posix.chdir;
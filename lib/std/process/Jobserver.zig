@@ -0,0 +1,204 @@
+//! Both sides of the GNU make jobserver protocol, which lets a tree of
+//! processes share one limit on the number of concurrent jobs.
+//!
+//! The jobserver is a pipe holding one byte, a token, per job slot beyond the
+//! first. Every process in the tree implicitly owns one slot, and must read a
+//! token before running any job in addition to that one, writing the same
+//! token back once the job is done. The pipe is found through the
+//! `--jobserver-auth` option in the `MAKEFLAGS` environment variable, either
+//! as inherited file descriptors (`R,W`) or as a named pipe (`fifo:PATH`).
+//!
+//! Windows, where make uses a named semaphore instead, is not supported.
+
+const Jobserver = @This();
+
+const builtin = @import("builtin");
+const std = @import("../std.zig");
+const mem = std.mem;
+const posix = std.posix;
+const testing = std.testing;
+
+read_fd: posix.fd_t,
+write_fd: posix.fd_t,
+/// Whether the file descriptors were opened by this process, and are closed by
+/// `deinit`.
+owned: bool,
+
+pub const Token = u8;
+
+pub const is_supported = switch (builtin.os.tag) {
+    .windows, .wasi => false,
+    else => true,
+};
+
+/// Creates a jobserver for `slot_count` concurrent jobs. The file descriptors
+/// are inherited by child processes, which find them through `makeflags`.
+pub fn initServer(slot_count: usize) !Jobserver {
+    if (!is_supported) return error.Unsupported;
+    const fds = try posix.pipe2(.{});
+    errdefer for (fds) |fd| posix.close(fd);
+    const jobserver: Jobserver = .{ .read_fd = fds[0], .write_fd = fds[1], .owned = true };
+    // The tokens fit in the pipe buffer for any reasonable number of slots.
+    for (1..slot_count) |_| try jobserver.writeToken('+');
+    return jobserver;
+}
+
+/// Returns the jobserver advertised by `makeflags`, the value of the
+/// `MAKEFLAGS` environment variable, or `null` if there is none, or it is not
+/// reachable from this process.
+pub fn initClient(makeflags_value: []const u8) ?Jobserver {
+    if (!is_supported) return null;
+    const auth = parseAuth(makeflags_value) orelse return null;
+    switch (auth) {
+        .fifo => |path| {
+            const fd = posix.open(path, .{ .ACCMODE = .RDWR, .CLOEXEC = true }, 0) catch return null;
+            if (!isPipe(fd)) {
+                posix.close(fd);
+                return null;
+            }
+            return .{ .read_fd = fd, .write_fd = fd, .owned = true };
+        },
+        .fds => |fds| {
+            // make only passes the file descriptors on to processes it knows to be
+            // jobserver clients, so they may be closed, or reused for something else.
+            if (!isPipe(fds[0]) or !isPipe(fds[1])) return null;
+            return .{ .read_fd = fds[0], .write_fd = fds[1], .owned = false };
+        },
+    }
+}
+
+pub fn deinit(jobserver: *Jobserver) void {
+    if (jobserver.owned) {
+        posix.close(jobserver.read_fd);
+        if (jobserver.write_fd != jobserver.read_fd) posix.close(jobserver.write_fd);
+    }
+    jobserver.* = undefined;
+}
+
+pub const AcquireError = posix.ReadError || posix.PollError || error{ EndOfStream, Unsupported };
+
+/// Blocks until a job slot is available, or until `cancel_fd` becomes readable,
+/// in which case `null` is returned. A token may never become available, for
+/// example when the parent process holds every token while waiting for this
+/// one, so a thread that may have to give up waiting passes a `cancel_fd`.
+pub fn acquire(jobserver: Jobserver, cancel_fd: ?posix.fd_t) AcquireError!?Token {
+    if (!is_supported) return error.Unsupported;
+    var token: [1]Token = undefined;
+    var fds = [_]posix.pollfd{
+        .{ .fd = jobserver.read_fd, .events = posix.POLL.IN, .revents = 0 },
+        // Negative file descriptors are ignored by poll.
+        .{ .fd = cancel_fd orelse -1, .events = posix.POLL.IN, .revents = 0 },
+    };
+    while (true) {
+        _ = try posix.poll(&fds, -1);
+        if (fds[1].revents != 0) return null;
+        if (fds[0].revents == 0) continue;
+        // Another process may take the token first. The read then blocks until the
+        // next token is returned, which happens once that process finishes its job.
+        const n = posix.read(jobserver.read_fd, &token) catch |err| switch (err) {
+            // Another process may have made the pipe non-blocking.
+            error.WouldBlock => continue,
+            else => |e| return e,
+        };
+        if (n == 0) return error.EndOfStream;
+        return token[0];
+    }
+}
+
+/// Returns a token obtained from `acquire`.
+pub fn release(jobserver: Jobserver, token: Token) void {
+    // Failing to return a token only lowers the concurrency of the build.
+    jobserver.writeToken(token) catch {};
+}
+
+fn writeToken(jobserver: Jobserver, token: Token) posix.WriteError!void {
+    while (try posix.write(jobserver.write_fd, &.{token}) != 1) {}
+}
+
+/// Formats the `MAKEFLAGS` value which advertises this jobserver to child
+/// processes, such as a nested make.
+pub fn makeflags(jobserver: Jobserver, slot_count: usize, buf: []u8) error{NoSpaceLeft}![]const u8 {
+    return std.fmt.bufPrint(buf, "-j{d} --jobserver-auth={d},{d}", .{
+        slot_count, jobserver.read_fd, jobserver.write_fd,
+    });
+}
+
+const Auth = union(enum) {
+    fifo: []const u8,
+    fds: [2]posix.fd_t,
+};
+
+fn parseAuth(makeflags_value: []const u8) ?Auth {
+    var result: ?Auth = null;
+    var it = mem.tokenizeScalar(u8, makeflags_value, ' ');
+    while (it.next()) |arg| {
+        // Older versions of make use `--jobserver-fds`. When there are several, the last wins.
+        const value = for ([_][]const u8{ "--jobserver-auth=", "--jobserver-fds=" }) |prefix| {
+            if (mem.startsWith(u8, arg, prefix)) break arg[prefix.len..];
+        } else continue;
+        if (mem.startsWith(u8, value, "fifo:")) {
+            result = .{ .fifo = value["fifo:".len..] };
+            continue;
+        }
+        const comma = mem.indexOfScalar(u8, value, ',') orelse {
+            result = null;
+            continue;
+        };
+        const read_fd = std.fmt.parseInt(posix.fd_t, value[0..comma], 10) catch null;
+        const write_fd = std.fmt.parseInt(posix.fd_t, value[comma + 1 ..], 10) catch null;
+        // make passes negative file descriptors to processes it does not consider to be clients.
+        result = if (read_fd != null and write_fd != null and read_fd.? >= 0 and write_fd.? >= 0)
+            .{ .fds = .{ read_fd.?, write_fd.? } }
+        else
+            null;
+    }
+    return result;
+}
+
+fn isPipe(fd: posix.fd_t) bool {
+    const stat = posix.fstat(fd) catch return false;
+    return posix.S.ISFIFO(stat.mode);
+}
+
+test parseAuth {
+    try testing.expectEqual(null, parseAuth(""));
+    try testing.expectEqual(null, parseAuth("-j8 -k"));
+    try testing.expectEqualDeep(Auth{ .fds = .{ 3, 4 } }, parseAuth(" -j8 --jobserver-auth=3,4").?);
+    try testing.expectEqualDeep(Auth{ .fds = .{ 5, 6 } }, parseAuth("--jobserver-fds=5,6 -j").?);
+    try testing.expectEqualDeep(Auth{ .fifo = "/tmp/GMfifo1" }, parseAuth("-j --jobserver-auth=fifo:/tmp/GMfifo1").?);
+    try testing.expectEqual(null, parseAuth("--jobserver-auth=-2,-2"));
+    try testing.expectEqual(null, parseAuth("--jobserver-auth=3,4 --jobserver-auth=-2,-2"));
+}
+
+test "tokens round-trip through a server and a client" {
+    if (!is_supported) return error.SkipZigTest;
+
+    var server: Jobserver = try .initServer(3);
+    defer server.deinit();
+
+    var buf: [64]u8 = undefined;
+    var client = initClient(try server.makeflags(3, &buf)).?;
+    defer client.deinit();
+
+    const a = (try client.acquire(null)).?;
+    const b = (try server.acquire(null)).?;
+    // Both tokens are taken; a third job would have to wait.
+    client.release(a);
+    const c = (try client.acquire(null)).?;
+    server.release(b);
+    client.release(c);
+}
+
+test "waiting for a token can be cancelled" {
+    if (!is_supported) return error.SkipZigTest;
+
+    // A single slot, which this process owns implicitly, so there are no tokens.
+    var server: Jobserver = try .initServer(1);
+    defer server.deinit();
+
+    const cancel_fds = try posix.pipe2(.{ .CLOEXEC = true });
+    defer for (cancel_fds) |fd| posix.close(fd);
+    _ = try posix.write(cancel_fds[1], "x");
+
+    try testing.expectEqual(null, try server.acquire(cancel_fds[0]));
+}
@@ -51,7 +51,10 @@ pub const Diagnostics = struct {
         },
     };
 
-    fn findRoot(d: *Diagnostics, kind: FileKind, path: []const u8) !void {
+    /// Updates `root_dir` with an entry of the archive. `pipeToFileSystem`
+    /// calls this for every entry; users of `Iterator` extracting archives
+    /// themselves can do the same.
+    pub fn findRoot(d: *Diagnostics, kind: FileKind, path: []const u8) !void {
         if (path.len == 0) return;
 
         d.entries += 1;
@@ -1197,6 +1197,12 @@ pub fn refAllDeclsRecursive(comptime T: type) void {
 
 pub const FuzzInputOptions = struct {
     corpus: []const []const u8 = &.{},
+    /// Run the inputs in a child process forked from the fuzzer, which is
+    /// replaced by a fresh one after every batch of inputs, and after an input
+    /// crashes. This keeps global state changed by the test from affecting
+    /// later inputs, and lets fuzzing go on after a crash, at some cost in
+    /// speed. Crashing inputs are saved in the cache directory.
+    fork_server: bool = false,
 };
 
 /// Inline to avoid coverage instrumentation.
@@ -705,7 +705,9 @@ pub const EnvVar = enum {
     ZIG_VERBOSE_CC,
     ZIG_BTRFS_WORKAROUND,
     ZIG_DEBUG_CMD,
+    ZIG_REMOTE_CACHE,
     CC,
+    MAKEFLAGS,
     NO_COLOR,
     CLICOLOR_FORCE,
     XDG_CACHE_HOME,
@@ -37,8 +37,21 @@ pub const Message = struct {
         /// The message body is:
         /// - a u32 test index.
         /// - a u8 test limit kind (std.Build.api.fuzz.LimitKind)
-        /// - a u64 value whose meaning depends on FuzzLimitKind (either a limit amount or an instance id)
+        /// - a u64 value whose meaning depends on FuzzLimitKind (a limit amount, an instance id,
+        ///   or an instance id and count)
         start_fuzzing,
+        /// Tells the compiler to end the current compilation and start a new
+        /// one in the same process, as if it had been spawned with the command
+        /// line in the message body, and then to update it as with `update`.
+        /// This lets a client reuse one compiler process for many compilations.
+        /// The client must wait for the results of the update before sending
+        /// another message.
+        /// Only supported when serving over stdio, for `build-exe`,
+        /// `build-lib`, `build-obj`, `test` and `test-obj` command lines
+        /// which include `--listen=-`.
+        /// The message body is the command line without the zig executable,
+        /// with each argument separated by a zero byte.
+        compile,
 
         _,
     };
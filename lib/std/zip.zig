@@ -455,25 +455,50 @@ pub const Iterator = struct {
         uncompressed_size: u64,
         file_offset: u64,
 
-        pub fn extract(
+        /// Reads the name of the entry from the central directory into
+        /// `filename_buf`, normalizing backslashes to forward slashes if
+        /// `options.allow_backslashes` is set. Names which would be extracted
+        /// outside of the destination directory are rejected.
+        pub fn readFilename(
             self: Entry,
             stream: *File.Reader,
             options: ExtractOptions,
             filename_buf: []u8,
-            dest: std.fs.Dir,
-        ) !void {
+        ) ![]u8 {
             if (filename_buf.len < self.filename_len)
                 return error.ZipInsufficientBuffer;
-            switch (self.compression_method) {
-                .store, .deflate => {},
-                else => return error.UnsupportedCompressionMethod,
-            }
             const filename = filename_buf[0..self.filename_len];
             {
                 try stream.seekTo(self.header_zip_offset + @sizeOf(CentralDirectoryFileHeader));
                 try stream.interface.readSliceAll(filename);
             }
 
+            if (options.allow_backslashes) {
+                std.mem.replaceScalar(u8, filename, '\\', '/');
+            } else {
+                if (std.mem.indexOfScalar(u8, filename, '\\')) |_|
+                    return error.ZipFilenameHasBackslash;
+            }
+
+            if (isBadFilename(filename))
+                return error.ZipBadFilename;
+
+            return filename;
+        }
+
+        pub fn extract(
+            self: Entry,
+            stream: *File.Reader,
+            options: ExtractOptions,
+            filename_buf: []u8,
+            dest: std.fs.Dir,
+        ) !void {
+            switch (self.compression_method) {
+                .store, .deflate => {},
+                else => return error.UnsupportedCompressionMethod,
+            }
+            const filename = try self.readFilename(stream, options, filename_buf);
+
             const local_data_header_offset: u64 = local_data_header_offset: {
                 const local_header = blk: {
                     try stream.seekTo(self.file_offset);
@@ -536,16 +561,6 @@ pub const Iterator = struct {
                     @as(u64, local_header.extra_len);
             };
 
-            if (options.allow_backslashes) {
-                std.mem.replaceScalar(u8, filename, '\\', '/');
-            } else {
-                if (std.mem.indexOfScalar(u8, filename, '\\')) |_|
-                    return error.ZipFilenameHasBackslash;
-            }
-
-            if (isBadFilename(filename))
-                return error.ZipBadFilename;
-
             // All entries that end in '/' are directories
             if (filename[filename.len - 1] == '/') {
                 if (self.uncompressed_size != 0)
@@ -660,3 +675,207 @@ pub fn extract(dest: std.fs.Dir, fr: *File.Reader, options: ExtractOptions) !voi
         }
     }
 }
+
+/// Like `extract`, but extracts the entries concurrently on `thread_pool`.
+///
+/// The central directory is read once up front, and all filenames are checked
+/// and passed to `options.diagnostics` in order before anything is extracted.
+/// Each entry is then extracted by a task of its own, which reads from
+/// `fr.file` with positional reads through a `File.Reader` of its own. If
+/// several entries fail to extract, the error of the first one in the archive
+/// is returned, which is the one `extract` would return. Entries after it may
+/// have been extracted anyway.
+///
+/// It is safe to call this function from a task running on `thread_pool`,
+/// since it runs other tasks while waiting for its own.
+pub fn extractConcurrently(
+    gpa: std.mem.Allocator,
+    thread_pool: *std.Thread.Pool,
+    dest: std.fs.Dir,
+    fr: *File.Reader,
+    options: ExtractOptions,
+) !void {
+    if (options.verify_checksums) @panic("TODO unimplemented");
+
+    var entries: std.ArrayListUnmanaged(Iterator.Entry) = .empty;
+    defer entries.deinit(gpa);
+    {
+        var iter = try Iterator.init(fr);
+        var filename_buf: [std.fs.max_path_bytes]u8 = undefined;
+        while (try iter.next()) |entry| {
+            const filename = try entry.readFilename(fr, options, &filename_buf);
+            if (options.diagnostics) |d| {
+                try d.nextFilename(filename);
+            }
+            try entries.append(gpa, entry);
+        }
+    }
+
+    const results = try gpa.alloc(ExtractEntryError!void, entries.items.len);
+    defer gpa.free(results);
+    @memset(results, {});
+
+    var first_failure: std.atomic.Value(usize) = .init(std.math.maxInt(usize));
+    var wait_group: std.Thread.WaitGroup = .{};
+    for (entries.items, results, 0..) |entry, *result, index| {
+        thread_pool.spawnWg(&wait_group, extractEntryTask, .{ entry, index, fr, options, dest, result, &first_failure });
+    }
+    thread_pool.waitAndWork(&wait_group);
+
+    for (results) |result| try result;
+}
+
+const ExtractEntryError = @typeInfo(@typeInfo(@TypeOf(Iterator.Entry.extract)).@"fn".return_type.?).error_union.error_set;
+
+fn extractEntryTask(
+    entry: Iterator.Entry,
+    index: usize,
+    fr: *const File.Reader,
+    options: ExtractOptions,
+    dest: std.fs.Dir,
+    result: *(ExtractEntryError!void),
+    first_failure: *std.atomic.Value(usize),
+) void {
+    // Entries after one which failed need not be extracted, but the ones
+    // before it must be, since one of them may fail first.
+    if (first_failure.load(.monotonic) < index) return;
+    var buffer: [4096]u8 = undefined;
+    var stream: File.Reader = .init(fr.file, fr.io, &buffer);
+    stream.size = fr.size;
+    var filename_buf: [std.fs.max_path_bytes]u8 = undefined;
+    result.* = entry.extract(&stream, options, &filename_buf, dest);
+    if (result.*) |_| {} else |_| {
+        var current = first_failure.load(.monotonic);
+        while (index < current) {
+            current = first_failure.cmpxchgWeak(current, index, .monotonic, .monotonic) orelse break;
+        }
+    }
+}
+
+const TestEntry = struct {
+    name: []const u8,
+    compression_method: CompressionMethod,
+    /// The data as stored in the archive.
+    data: []const u8,
+    /// The data once extracted.
+    contents: []const u8,
+};
+
+fn writeTestZip(w: *Writer, entries: []const TestEntry) Writer.Error!void {
+    var local_file_header_offsets: [8]u32 = undefined;
+    var offset: u32 = 0;
+    for (entries, local_file_header_offsets[0..entries.len]) |entry, *local_file_header_offset| {
+        local_file_header_offset.* = offset;
+        try w.writeStruct(LocalFileHeader{
+            .signature = local_file_header_sig,
+            .version_needed_to_extract = 20,
+            .flags = .{ .encrypted = false, ._ = 0 },
+            .compression_method = entry.compression_method,
+            .last_modification_time = 0,
+            .last_modification_date = 0,
+            .crc32 = std.hash.Crc32.hash(entry.contents),
+            .compressed_size = @intCast(entry.data.len),
+            .uncompressed_size = @intCast(entry.contents.len),
+            .filename_len = @intCast(entry.name.len),
+            .extra_len = 0,
+        }, .little);
+        try w.writeAll(entry.name);
+        try w.writeAll(entry.data);
+        offset += @intCast(@sizeOf(LocalFileHeader) + entry.name.len + entry.data.len);
+    }
+    const cd_offset = offset;
+    for (entries, local_file_header_offsets[0..entries.len]) |entry, local_file_header_offset| {
+        try w.writeStruct(CentralDirectoryFileHeader{
+            .signature = central_file_header_sig,
+            .version_made_by = 20,
+            .version_needed_to_extract = 20,
+            .flags = .{ .encrypted = false, ._ = 0 },
+            .compression_method = entry.compression_method,
+            .last_modification_time = 0,
+            .last_modification_date = 0,
+            .crc32 = std.hash.Crc32.hash(entry.contents),
+            .compressed_size = @intCast(entry.data.len),
+            .uncompressed_size = @intCast(entry.contents.len),
+            .filename_len = @intCast(entry.name.len),
+            .extra_len = 0,
+            .comment_len = 0,
+            .disk_number = 0,
+            .internal_file_attributes = 0,
+            .external_file_attributes = 0,
+            .local_file_header_offset = local_file_header_offset,
+        }, .little);
+        try w.writeAll(entry.name);
+        offset += @intCast(@sizeOf(CentralDirectoryFileHeader) + entry.name.len);
+    }
+    try w.writeStruct(EndRecord{
+        .signature = end_record_sig,
+        .disk_number = 0,
+        .central_directory_disk_number = 0,
+        .record_count_disk = @intCast(entries.len),
+        .record_count_total = @intCast(entries.len),
+        .central_directory_size = offset - cd_offset,
+        .central_directory_offset = cd_offset,
+        .comment_len = 0,
+    }, .little);
+}
+
+test extractConcurrently {
+    const gpa = std.testing.allocator;
+    const io = std.testing.io;
+
+    const entries = [_]TestEntry{
+        .{ .name = "root/", .compression_method = .store, .data = "", .contents = "" },
+        .{ .name = "root/sub/stored.txt", .compression_method = .store, .data = "stored\n", .contents = "stored\n" },
+        .{
+            .name = "root/deflated.txt",
+            .compression_method = .deflate,
+            .data = "\xcb\x48\xcd\xc9\xc9\x57\xc8\x40\x27\xb9\x00",
+            .contents = "hello hello hello hello\n",
+        },
+    };
+
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+    {
+        var zip_file = try tmp.dir.createFile("test.zip", .{});
+        defer zip_file.close();
+        var zip_file_buffer: [1024]u8 = undefined;
+        var zip_file_writer = zip_file.writer(&zip_file_buffer);
+        try writeTestZip(&zip_file_writer.interface, &entries);
+        try zip_file_writer.interface.flush();
+    }
+
+    var thread_pool: std.Thread.Pool = undefined;
+    try thread_pool.init(.{ .allocator = gpa });
+    defer thread_pool.deinit();
+
+    var diagnostics: [2]Diagnostics = .{ .{ .allocator = gpa }, .{ .allocator = gpa } };
+    defer for (&diagnostics) |*d| d.deinit();
+    var out_dirs: [2]std.fs.Dir = undefined;
+    var opened: usize = 0;
+    defer for (out_dirs[0..opened]) |*dir| dir.close();
+    for ([_][]const u8{ "sequential", "concurrent" }, &out_dirs, &diagnostics, 0..) |name, *out_dir, *d, i| {
+        out_dir.* = try tmp.dir.makeOpenPath(name, .{});
+        opened += 1;
+        var zip_file = try tmp.dir.openFile("test.zip", .{});
+        defer zip_file.close();
+        var zip_file_buffer: [1024]u8 = undefined;
+        var zip_file_reader = zip_file.reader(io, &zip_file_buffer);
+        const options: ExtractOptions = .{ .diagnostics = d };
+        if (i == 0) {
+            try extract(out_dir.*, &zip_file_reader, options);
+        } else {
+            try extractConcurrently(gpa, &thread_pool, out_dir.*, &zip_file_reader, options);
+        }
+    }
+
+    try std.testing.expectEqualStrings("root", diagnostics[0].root_dir);
+    try std.testing.expectEqualStrings(diagnostics[0].root_dir, diagnostics[1].root_dir);
+    for (entries[1..]) |entry| {
+        for (out_dirs) |out_dir| {
+            const contents = try out_dir.readFileAlloc(entry.name, gpa, .limited(1024));
+            defer gpa.free(contents);
+            try std.testing.expectEqualStrings(entry.contents, contents);
+        }
+    }
+}
@@ -91,6 +91,9 @@ libc_installation: ?*const LibCInstallation,
 skip_linker_dependencies: bool,
 function_sections: bool,
 data_sections: bool,
+/// Emit the bulk of the DWARF for C objects into `.dwo` files next to the
+/// cached object so that the linker only has to process skeleton units.
+split_dwarf: bool,
 link_eh_frame_hdr: bool,
 native_system_include_paths: []const []const u8,
 /// List of symbols forced as undefined in the symbol table
@@ -191,6 +194,9 @@ cache_parent: *Cache,
 parent_whole_cache: ?ParentWholeCache,
 /// Path to own executable for invoking `zig clang`.
 self_exe_path: ?[]const u8,
+/// Shared store consulted on `CacheMode.whole` misses, and updated after them.
+/// Owned by the caller of `Compilation.create`.
+remote_cache: ?*Cache.Remote,
 /// Owned by the caller of `Compilation.create`.
 dirs: Directories,
 libc_include_dir_list: []const []const u8,
@@ -1395,6 +1401,7 @@ pub const MiscTask = enum {
     write_builtin_zig,
     rename_results,
     check_whole_cache,
+    map_file,
     glibc_crt_file,
     glibc_shared_objects,
     musl_crt_file,
@@ -1647,6 +1654,8 @@ pub const CreateOptions = struct {
     dirs: Directories,
     thread_pool: *ThreadPool,
     self_exe_path: ?[]const u8 = null,
+    /// Only used with `CacheMode.whole`.
+    remote_cache: ?*Cache.Remote = null,
 
     /// Options that have been resolved by calling `resolveDefaults`.
     config: Compilation.Config,
@@ -1692,6 +1701,7 @@ pub const CreateOptions = struct {
     want_ubsan_rt: ?bool = null,
     function_sections: bool = false,
     data_sections: bool = false,
+    split_dwarf: bool = false,
     time_report: bool = false,
     stack_report: bool = false,
     link_eh_frame_hdr: bool = false,
@@ -1715,6 +1725,7 @@ pub const CreateOptions = struct {
     linker_print_gc_sections: bool = false,
     linker_print_icf_sections: bool = false,
     linker_print_map: bool = false,
+    linker_map_file: ?[]const u8 = null,
     llvm_opt_bisect_limit: i32 = -1,
     build_id: ?std.zig.BuildId = null,
     disable_c_depfile: bool = false,
@@ -2116,6 +2127,7 @@ pub fn create(gpa: Allocator, arena: Allocator, io: Io, diag: *CreateDiagnostic,
             .manifest_dir = options.dirs.local_cache.handle.makeOpenPath("h", .{}) catch |err| {
                 return diag.fail(.{ .create_cache_path = .{ .which = .local, .sub = "h", .err = err } });
             },
+            .thread_pool = options.thread_pool,
         };
         // These correspond to std.zig.Server.Message.PathPrefix.
         cache.addPrefix(.{ .path = null, .handle = fs.cwd() });
@@ -2137,6 +2149,7 @@ pub fn create(gpa: Allocator, arena: Allocator, io: Io, diag: *CreateDiagnostic,
         cache.hash.add(options.config.any_fuzz);
         cache.hash.add(options.function_sections);
         cache.hash.add(options.data_sections);
+        cache.hash.add(options.split_dwarf);
         cache.hash.add(link_libc);
         cache.hash.add(options.config.link_libcpp);
         cache.hash.add(options.config.link_libunwind);
@@ -2245,6 +2258,7 @@ pub fn create(gpa: Allocator, arena: Allocator, io: Io, diag: *CreateDiagnostic,
             .rc_source_files = options.rc_source_files,
             .cache_parent = cache,
             .self_exe_path = options.self_exe_path,
+            .remote_cache = options.remote_cache,
             .libc_include_dir_list = libc_dirs.libc_include_dir_list,
             .libc_framework_dir_list = libc_dirs.libc_framework_dir_list,
             .rc_includes = options.rc_includes,
@@ -2283,6 +2297,7 @@ pub fn create(gpa: Allocator, arena: Allocator, io: Io, diag: *CreateDiagnostic,
             .queued_jobs = .{},
             .function_sections = options.function_sections,
             .data_sections = options.data_sections,
+            .split_dwarf = options.split_dwarf,
             .native_system_include_paths = options.native_system_include_paths,
             .force_undefined_symbols = options.force_undefined_symbols,
             .link_eh_frame_hdr = link_eh_frame_hdr,
@@ -2356,6 +2371,7 @@ pub fn create(gpa: Allocator, arena: Allocator, io: Io, diag: *CreateDiagnostic,
             .print_gc_sections = options.linker_print_gc_sections,
             .print_icf_sections = options.linker_print_icf_sections,
             .print_map = options.linker_print_map,
+            .map_file = options.linker_map_file,
             .tsaware = options.linker_tsaware,
             .nxcompat = options.linker_nxcompat,
             .dynamicbase = options.linker_dynamicbase,
@@ -2920,6 +2936,8 @@ pub fn update(comp: *Compilation, main_progress_node: std.Progress.Node) UpdateE
             if (ignore_hit) {
                 // We're going to do the work regardless of whether this is a hit or a miss.
                 man.want_shared_lock = false;
+            } else if (comp.remote_cache) |remote| {
+                man.remote = .{ .remote = remote, .cache_root = comp.dirs.local_cache.handle };
             }
 
             const is_hit = man.hit() catch |err| switch (err) {
@@ -2962,6 +2980,11 @@ pub fn update(comp: *Compilation, main_progress_node: std.Progress.Node) UpdateE
 
                 comp.digest = bin_digest;
 
+                if (whole.lf_open_opts.map_file) |map_file| {
+                    const o_sub_path = try fs.path.join(arena, &.{ "o", &Cache.binToHex(bin_digest) });
+                    copyMapFile(comp, .restore, o_sub_path, map_file);
+                }
+
                 assert(whole.lock == null);
                 whole.lock = man.toOwnedLock();
                 return;
@@ -3211,6 +3234,13 @@ pub fn update(comp: *Compilation, main_progress_node: std.Progress.Node) UpdateE
             // cache manifest must not be written.
             if (anyErrors(comp)) return;
 
+            // The map file is written outside of the cache directory, so keep a
+            // copy of it with the other artifacts to restore on a cache hit.
+            if (whole.lf_open_opts.map_file) |map_file| {
+                copyMapFile(comp, .save, o_sub_path, map_file);
+                if (anyErrors(comp)) return;
+            }
+
             // Failure here only means an unnecessary cache miss.
             man.writeManifest() catch |err| {
                 log.warn("failed to write cache manifest: {s}", .{@errorName(err)});
@@ -3227,6 +3257,34 @@ pub fn update(comp: *Compilation, main_progress_node: std.Progress.Node) UpdateE
     }
 }
 
+/// Basename of the copy of the linker map file kept in the artifact directory.
+const map_file_cache_basename = "map";
+
+/// Copies the linker map file between `map_file`, which is relative to the
+/// current working directory, and the artifact directory `o_sub_path` of the
+/// local cache. Failures are reported as compilation errors.
+fn copyMapFile(
+    comp: *Compilation,
+    direction: enum { save, restore },
+    o_sub_path: []const u8,
+    map_file: []const u8,
+) void {
+    const cache_dir = comp.dirs.local_cache.handle;
+    var o_dir = cache_dir.openDir(o_sub_path, .{}) catch |err| {
+        return comp.setMiscFailure(.map_file, "failed to open artifact directory '{f}{s}': {t}", .{
+            comp.dirs.local_cache, o_sub_path, err,
+        });
+    };
+    defer o_dir.close();
+    const result = switch (direction) {
+        .save => fs.cwd().copyFile(map_file, o_dir, map_file_cache_basename, .{}),
+        .restore => o_dir.copyFile(map_file_cache_basename, fs.cwd(), map_file, .{}),
+    };
+    result catch |err| comp.setMiscFailure(.map_file, "failed to {t} map file '{s}': {t}", .{
+        direction, map_file, err,
+    });
+}
+
 pub fn appendFileSystemInput(comp: *Compilation, path: Compilation.Path) Allocator.Error!void {
     const gpa = comp.gpa;
     const fsi = comp.file_system_inputs orelse return;
@@ -3489,6 +3547,7 @@ fn addNonIncrementalStuffToCacheManifest(
 
     try man.addOptionalFile(opts.linker_script);
     try man.addOptionalFile(opts.version_script);
+    man.hash.addOptionalBytes(opts.map_file);
     man.hash.add(opts.allow_undefined_version);
     man.hash.addOptional(opts.enable_new_dtags);
 
@@ -4588,10 +4647,10 @@ fn performAllTheWork(
     // only needs to be finished by the end of this function.
 
     var work_queue_wait_group: WaitGroup = .{};
-    defer work_queue_wait_group.wait();
+    defer comp.thread_pool.wait(&work_queue_wait_group);
 
     comp.link_task_wait_group.reset();
-    defer comp.link_task_wait_group.wait();
+    defer comp.thread_pool.wait(&comp.link_task_wait_group);
 
     // Already-queued prelink tasks
     comp.link_prog_node.increaseEstimatedTotalItems(comp.link_task_queue.queued_prelink.items.len);
@@ -4816,7 +4875,7 @@ fn performAllTheWork(
         };
 
         var astgen_wait_group: WaitGroup = .{};
-        defer astgen_wait_group.wait();
+        defer comp.thread_pool.wait(&astgen_wait_group);
 
         if (comp.zcu) |zcu| {
             const gpa = zcu.gpa;
@@ -4983,7 +5042,7 @@ fn performAllTheWork(
 
     if (!comp.separateCodegenThreadOk()) {
         // Waits until all input files have been parsed.
-        comp.link_task_wait_group.wait();
+        comp.thread_pool.wait(&comp.link_task_wait_group);
         comp.link_task_wait_group.reset();
         std.log.scoped(.link).debug("finished waiting for link_task_wait_group", .{});
     }
@@ -5433,6 +5492,7 @@ fn workerDocsWasmFallible(comp: *Compilation, prog_node: std.Progress.Node) SubU
     const sub_compilation = Compilation.create(gpa, arena, io, &sub_create_diag, .{
         .dirs = dirs,
         .self_exe_path = comp.self_exe_path,
+        .remote_cache = comp.remote_cache,
         .config = config,
         .root_mod = root_mod,
         .entry = .disabled,
@@ -6273,6 +6333,15 @@ fn updateCObject(comp: *Compilation, c_object: *CObject, c_obj_prog_node: std.Pr
             null
         else
             try std.fmt.allocPrint(arena, "{s}.d", .{out_obj_path});
+        const out_dwo_path = if (comp.clang_preprocessor_mode != .no or !comp.wantSplitDwarf(target, ext))
+            null
+        else
+            try std.fmt.allocPrint(arena, "{s}.dwo", .{out_obj_path});
+        const dwo_basename = try std.fmt.allocPrint(arena, "{s}.dwo", .{o_basename_noext});
+        // The digest that names the directory the `.dwo` file ends up in is not known until
+        // clang has run, so a random stand-in of the same length takes its place in the path
+        // that clang records, and is replaced once the digest is known.
+        const dwo_digest_placeholder = Cache.binToHex(std.crypto.random.array(u8, Cache.bin_digest_len));
 
         try comp.addCCArgs(arena, &argv, ext, out_dep_path, c_object.src.owner);
         try argv.appendSlice(c_object.src.extra_flags);
@@ -6297,6 +6366,23 @@ fn updateCObject(comp: *Compilation, c_object: *CObject, c_obj_prog_node: std.Pr
             }
         }
 
+        if (out_dwo_path) |dwo_file_path| {
+            // The skeleton unit refers to the `.dwo` file by the absolute path it will have next
+            // to the object file in `o/<digest>/`, not by the temporary path it is written to.
+            // A relative name would be resolved against the compilation directory instead.
+            const final_dwo_path = try fs.path.resolve(arena, &.{
+                comp.dirs.cwd,
+                comp.dirs.local_cache.path orelse ".",
+                "o",
+                &dwo_digest_placeholder,
+                dwo_basename,
+            });
+            try argv.appendSlice(&.{
+                "-Xclang", "-split-dwarf-file",   "-Xclang", final_dwo_path,
+                "-Xclang", "-split-dwarf-output", "-Xclang", dwo_file_path,
+            });
+        }
+
         if (comp.verbose_cc) {
             dump_argv(argv.items);
         }
@@ -6402,6 +6488,12 @@ fn updateCObject(comp: *Compilation, c_object: *CObject, c_obj_prog_node: std.Pr
         var o_dir = try comp.dirs.local_cache.handle.makeOpenPath(o_sub_path, .{});
         defer o_dir.close();
         const tmp_basename = fs.path.basename(out_obj_path);
+        if (out_dwo_path) |dwo_file_path| {
+            const tmp_dwo_basename = fs.path.basename(dwo_file_path);
+            try replaceDigestPlaceholder(gpa, zig_cache_tmp_dir, tmp_basename, &dwo_digest_placeholder, &digest);
+            try replaceDigestPlaceholder(gpa, zig_cache_tmp_dir, tmp_dwo_basename, &dwo_digest_placeholder, &digest);
+            try fs.rename(zig_cache_tmp_dir, tmp_dwo_basename, o_dir, dwo_basename);
+        }
         try fs.rename(zig_cache_tmp_dir, tmp_basename, o_dir, o_basename);
         break :blk digest;
     };
@@ -6741,6 +6833,33 @@ fn spawnZigRc(
     }
 }
 
+/// Overwrites each occurrence of `placeholder` in the file `sub_path` with `digest`. Since both
+/// have the same length, this leaves the offsets within the file intact.
+fn replaceDigestPlaceholder(
+    gpa: Allocator,
+    dir: fs.Dir,
+    sub_path: []const u8,
+    placeholder: *const Cache.HexDigest,
+    digest: *const Cache.HexDigest,
+) !void {
+    const bytes = try dir.readFileAlloc(sub_path, gpa, .unlimited);
+    defer gpa.free(bytes);
+    var replaced = false;
+    var i: usize = 0;
+    while (mem.indexOfPos(u8, bytes, i, placeholder)) |pos| {
+        @memcpy(bytes[pos..][0..digest.len], digest);
+        i = pos + placeholder.len;
+        replaced = true;
+    }
+    if (replaced) try dir.writeFile(.{ .sub_path = sub_path, .data = bytes });
+}
+
+/// Whether clang should be asked to emit split DWARF for a C object of kind `ext`.
+fn wantSplitDwarf(comp: *const Compilation, target: *const Target, ext: FileExt) bool {
+    return comp.split_dwarf and comp.config.debug_format == .dwarf and
+        target.ofmt == .elf and ext.clangSupportsSplitDwarf();
+}
+
 pub fn tmpFilePath(comp: Compilation, ally: Allocator, suffix: []const u8) error{OutOfMemory}![]const u8 {
     const s = fs.path.sep_str;
     const rand_int = std.crypto.random.int(u64);
@@ -6814,6 +6933,7 @@ fn addCommonCCArgs(
                 .@"32" => argv.appendAssumeCapacity("-gdwarf32"),
                 .@"64" => argv.appendAssumeCapacity("-gdwarf64"),
             }
+            if (comp.wantSplitDwarf(target, ext)) try argv.append("-gsplit-dwarf");
         },
     }
 
@@ -7493,6 +7613,29 @@ pub const FileExt = enum {
         };
     }
 
+    pub fn clangSupportsSplitDwarf(ext: FileExt) bool {
+        return switch (ext) {
+            .c, .cpp, .m, .mm, .ll, .bc => true,
+
+            .h,
+            .hpp,
+            .hm,
+            .hmm,
+            .assembly,
+            .assembly_with_cpp,
+            .shared_library,
+            .object,
+            .static_library,
+            .zig,
+            .def,
+            .rc,
+            .res,
+            .manifest,
+            .unknown,
+            => false,
+        };
+    }
+
     pub fn canonicalName(ext: FileExt, target: *const Target) [:0]const u8 {
         return switch (ext) {
             .c => ".c",
@@ -7870,6 +8013,7 @@ fn buildOutputFromZig(
         .cache_mode = .whole,
         .parent_whole_cache = parent_whole_cache,
         .self_exe_path = comp.self_exe_path,
+        .remote_cache = comp.remote_cache,
         .config = config,
         .root_mod = root_mod,
         .root_name = root_name,
@@ -8005,6 +8149,7 @@ pub fn build_crt_file(
     const sub_compilation = Compilation.create(gpa, arena, io, &sub_create_diag, .{
         .dirs = comp.dirs.withoutLocalCache(),
         .self_exe_path = comp.self_exe_path,
+        .remote_cache = comp.remote_cache,
         .cache_mode = .whole,
         .config = config,
         .root_mod = root_mod,
@@ -44,6 +44,7 @@ const git = @import("Fetch/git.zig");
 const Package = @import("../Package.zig");
 const Manifest = Package.Manifest;
 const ErrorBundle = std.zig.ErrorBundle;
+const log = std.log.scoped(.fetch);
 
 arena: std.heap.ArenaAllocator,
 io: Io,
@@ -549,7 +550,7 @@ fn runResource(
         // Empty directories have already been omitted by `unpackResource`.
         // Compute the package hash based on the remaining files in the temporary
         // directory.
-        f.computed_hash = try computeHash(f, pkg_path, filter);
+        f.computed_hash = try computeHash(f, pkg_path, filter, &unpack_result.hashed_files);
 
         break :blk if (unpack_result.root_dir.len > 0)
             try fs.path.join(arena, &.{ tmp_dir_sub_path, unpack_result.root_dir })
@@ -1253,20 +1254,114 @@ fn unpackResource(
 fn unpackTarball(f: *Fetch, out_dir: fs.Dir, reader: *Io.Reader) RunError!UnpackResult {
     const eb = &f.error_bundle;
     const arena = f.arena.allocator();
+    const gpa = f.arena.child_allocator;
+    const thread_pool = f.job_queue.thread_pool;
 
     var diagnostics: std.tar.Diagnostics = .{ .allocator = arena };
 
-    std.tar.pipeToFileSystem(out_dir, reader, .{
+    var file_name_buffer: [fs.max_path_bytes]u8 = undefined;
+    var link_name_buffer: [fs.max_path_bytes]u8 = undefined;
+    var it: std.tar.Iterator = .init(reader, .{
+        .file_name_buffer = &file_name_buffer,
+        .link_name_buffer = &link_name_buffer,
         .diagnostics = &diagnostics,
-        .strip_components = 0,
-        .mode_mode = .ignore,
-        .exclude_empty_directories = true,
-    }) catch |err| return f.fail(
-        f.location_tok,
-        try eb.printString("unable to unpack tarball to temporary directory: {t}", .{err}),
-    );
+    });
+
+    var unpacked_files: std.ArrayListUnmanaged(*UnpackedFile) = .empty;
+    defer unpacked_files.deinit(gpa);
+
+    // Decompression happens on this thread, and so does creating every file,
+    // directory and symlink, in archive order. Most file contents are then
+    // written and hashed on the thread pool, and held in memory in between.
+    var buffered_bytes: std.atomic.Value(usize) = .init(0);
+
+    {
+        var wait_group: WaitGroup = .{};
+        // `unpackTarball` is called from a worker thread so there must not be
+        // any waiting without working or a deadlock could occur.
+        defer thread_pool.waitAndWork(&wait_group);
+
+        while (it.next() catch |err| return f.fail(
+            f.location_tok,
+            try eb.printString("unable to unpack tarball to temporary directory: {t}", .{err}),
+        )) |file| {
+            try diagnostics.findRoot(file.kind, file.name);
+
+            switch (file.kind) {
+                // Empty directories are omitted from packages, and the others
+                // are created along with the files in them.
+                .directory => {},
+                .file => {
+                    const fs_path = try arena.dupe(u8, file.name);
+                    const unpacked_file = try arena.create(UnpackedFile);
+                    unpacked_file.* = .{
+                        .fs_path = fs_path,
+                        .pkg_path = stripRoot(fs_path, diagnostics.root_dir),
+                        .size = file.size,
+                        .hash = undefined, // to be populated by the worker
+                        .failure = undefined, // to be populated by the worker
+                    };
+                    try unpacked_files.append(gpa, unpacked_file);
+
+                    if (file.size <= max_buffered_file_size and
+                        buffered_bytes.load(.monotonic) + file.size <= max_buffered_bytes)
+                    {
+                        const contents = try gpa.alloc(u8, @intCast(file.size));
+                        var contents_writer: Io.Writer = .fixed(contents);
+                        it.streamRemaining(file, &contents_writer) catch |err| {
+                            gpa.free(contents);
+                            return f.fail(f.location_tok, try eb.printString(
+                                "unable to unpack tarball to temporary directory: {t}",
+                                .{err},
+                            ));
+                        };
+                        const new_file = createUnpackedFile(out_dir, fs_path, contents) catch |err| {
+                            unpacked_file.failure = err;
+                            gpa.free(contents);
+                            continue;
+                        };
+                        new_file.close();
+                        _ = buffered_bytes.fetchAdd(contents.len, .monotonic);
+                        thread_pool.spawnWg(&wait_group, workerUnpackFile, .{
+                            gpa, out_dir, unpacked_file, contents, &buffered_bytes,
+                        });
+                    } else {
+                        // Too large to hold in memory, or the workers are not
+                        // keeping up: write the file on this thread instead.
+                        unpackFileStreaming(out_dir, unpacked_file, &it) catch |err| return f.fail(
+                            f.location_tok,
+                            try eb.printString("unable to unpack tarball to temporary directory: {t}", .{err}),
+                        );
+                    }
+                },
+                .sym_link => {
+                    createDirAndSymlink(out_dir, file.link_name, file.name) catch |err| {
+                        try diagnostics.errors.append(arena, .{ .unable_to_create_sym_link = .{
+                            .code = err,
+                            .file_name = try arena.dupe(u8, file.name),
+                            .link_name = try arena.dupe(u8, file.link_name),
+                        } });
+                    };
+                },
+            }
+        }
+    }
 
     var res: UnpackResult = .{ .root_dir = diagnostics.root_dir };
+    for (unpacked_files.items) |unpacked_file| {
+        unpacked_file.failure catch |err| {
+            try diagnostics.errors.append(arena, .{ .unable_to_create_file = .{
+                .code = err,
+                .file_name = unpacked_file.fs_path,
+            } });
+            continue;
+        };
+        // Files unpacked before the package turned out not to be in a
+        // sub-directory were hashed with the wrong path.
+        if (!std.mem.eql(u8, stripRoot(unpacked_file.fs_path, res.root_dir), unpacked_file.pkg_path)) continue;
+        try res.hashed_files.put(arena, unpacked_file.pkg_path, unpacked_file);
+    }
+
     if (diagnostics.errors.items.len > 0) {
         try res.allocErrors(arena, diagnostics.errors.items.len, "unable to unpack tarball");
         for (diagnostics.errors.items) |item| {
@@ -1281,6 +1376,108 @@ fn unpackTarball(f: *Fetch, out_dir: fs.Dir, reader: *Io.Reader) RunError!Unpack
     return res;
 }
 
+/// Files up to this size are read into memory while decompressing, to be
+/// written to disk on the thread pool. Larger files are written directly.
+const max_buffered_file_size = 1 << 20;
+
+/// Limits the memory used by files which are waiting to be written to disk.
+const max_buffered_bytes = 64 << 20;
+
+/// A file written by `unpackTarball`. Its hash is computed from its contents as
+/// they are written, so that `computeHash` does not have to read it back.
+const UnpackedFile = struct {
+    fs_path: []const u8,
+    /// The path within the package covered by `hash`. This is guessed when the
+    /// file is unpacked, before the root directory of the package is known.
+    pkg_path: []const u8,
+    size: u64,
+    hash: Package.Hash.Digest,
+    failure: anyerror!void,
+};
+
+/// Writes the contents of a file which `unpackTarball` already created, so that
+/// conflicts between paths in the archive are resolved in archive order rather
+/// than in whichever order the workers run.
+fn workerUnpackFile(
+    gpa: Allocator,
+    dir: fs.Dir,
+    unpacked_file: *UnpackedFile,
+    contents: []u8,
+    buffered_bytes: *std.atomic.Value(usize),
+) void {
+    defer {
+        _ = buffered_bytes.fetchSub(contents.len, .monotonic);
+        gpa.free(contents);
+    }
+    var file = dir.openFile(unpacked_file.fs_path, .{ .mode = .write_only }) catch |err| {
+        unpacked_file.failure = err;
+        return;
+    };
+    defer file.close();
+    var contents_reader: Io.Reader = .fixed(contents);
+    unpacked_file.failure = writeUnpackedFile(file, unpacked_file, &contents_reader);
+}
+
+/// Unpacks a file straight from the archive. Only failing to create the file
+/// is recorded as its `failure`: the archive cannot be read any further after
+/// failing midway through the file, so other errors are returned.
+fn unpackFileStreaming(dir: fs.Dir, unpacked_file: *UnpackedFile, it: *std.tar.Iterator) !void {
+    const header_len = @sizeOf(@FieldType(FileHeader, "header"));
+    const header = try it.reader.peek(@intCast(@min(unpacked_file.size, header_len)));
+    var file = createUnpackedFile(dir, unpacked_file.fs_path, header) catch |err| {
+        unpacked_file.failure = err;
+        return;
+    };
+    defer file.close();
+    try writeUnpackedFile(file, unpacked_file, it.reader);
+    it.unread_file_bytes = 0;
+    unpacked_file.failure = {};
+}
+
+/// `header` is the start of the contents, used to detect executable files.
+fn createUnpackedFile(dir: fs.Dir, fs_path: []const u8, header: []const u8) !fs.File {
+    const file = dir.createFile(fs_path, .{ .exclusive = true }) catch |err| file: {
+        if (err != error.FileNotFound) return err;
+        const dir_name = fs.path.dirname(fs_path) orelse return err;
+        try dir.makePath(dir_name);
+        break :file try dir.createFile(fs_path, .{ .exclusive = true });
+    };
+    errdefer file.close();
+    var file_header: FileHeader = .{};
+    file_header.update(header);
+    if (file_header.isExecutable()) {
+        try setExecutable(file);
+    }
+    return file;
+}
+
+/// Hashes the file the same way as `hashFileFallible`.
+fn writeUnpackedFile(file: fs.File, unpacked_file: *UnpackedFile, reader: *Io.Reader) !void {
+    var hasher = Package.Hash.Algo.init(.{});
+    hasher.update(unpacked_file.pkg_path);
+    // Hard-coded false executable bit: https://github.com/ziglang/zig/issues/17463
+    hasher.update(&.{ 0, 0 });
+    var remaining = unpacked_file.size;
+    while (remaining > 0) {
+        const buffered = try reader.peekGreedy(1);
+        const chunk = buffered[0..@intCast(@min(buffered.len, remaining))];
+        hasher.update(chunk);
+        try file.writeAll(chunk);
+        reader.toss(chunk.len);
+        remaining -= chunk.len;
+    }
+    hasher.final(&unpacked_file.hash);
+}
+
+fn createDirAndSymlink(dir: fs.Dir, link_name: []const u8, file_name: []const u8) !void {
+    dir.symLink(link_name, file_name, .{}) catch |err| {
+        if (err != error.FileNotFound) return err;
+        const dir_name = fs.path.dirname(file_name) orelse return err;
+        try dir.makePath(dir_name);
+        try dir.symLink(link_name, file_name, .{});
+    };
+}
+
 fn unzip(f: *Fetch, out_dir: fs.Dir, reader: *Io.Reader) error{ ReadFailed, OutOfMemory, FetchFailed }!UnpackResult {
     // We write the entire contents to a file first because zip files
     // must be processed back to front and they could be too large to
@@ -1336,7 +1533,7 @@ fn unzip(f: *Fetch, out_dir: fs.Dir, reader: *Io.Reader) error{ ReadFailed, OutO
 
     zip_file_reader.seekTo(0) catch |err|
         return f.fail(f.location_tok, try eb.printString("failed to seek temporary zip file: {t}", .{err}));
-    std.zip.extract(out_dir, &zip_file_reader, .{
+    std.zip.extractConcurrently(f.arena.child_allocator, f.job_queue.thread_pool, out_dir, &zip_file_reader, .{
         .allow_backslashes = true,
         .diagnostics = &diagnostics,
     }) catch |err| return f.fail(f.location_tok, try eb.printString("zip extract failed: {t}", .{err}));
@@ -1380,7 +1577,7 @@ fn unpackGitPack(f: *Fetch, out_dir: fs.Dir, resource: *Resource.Git) anyerror!U
         {
             const index_prog_node = f.prog_node.start("Index pack", 0);
             defer index_prog_node.end();
-            try git.indexPack(gpa, object_format, &pack_file_reader, &index_file_writer);
+            try git.indexPack(gpa, f.job_queue.thread_pool, object_format, &pack_file_reader, &index_file_writer);
         }
 
         {
@@ -1484,8 +1681,13 @@ const ComputedHash = struct {
 /// prior to calling this function. This ensures that files not protected by
 /// the hash are not present on the file system. Empty directories are *not
 /// hashed* and must not be present on the file system when calling this
-/// function.
-fn computeHash(f: *Fetch, pkg_path: Cache.Path, filter: Filter) RunError!ComputedHash {
+/// function. Files in `hashed_files` are not read again.
+fn computeHash(
+    f: *Fetch,
+    pkg_path: Cache.Path,
+    filter: Filter,
+    hashed_files: *const std.StringHashMapUnmanaged(*const UnpackedFile),
+) RunError!ComputedHash {
     // All the path name strings need to be in memory for sorting.
     const arena = f.arena.allocator();
     const gpa = f.arena.child_allocator;
@@ -1511,6 +1713,21 @@ fn computeHash(f: *Fetch, pkg_path: Cache.Path, filter: Filter) RunError!Compute
     // Total number of bytes of file contents included in the package.
     var total_size: u64 = 0;
 
+    // Files are deduplicated as they are hashed. If the store cannot be
+    // opened, they are simply left as private copies.
+    var file_store: FileStore = undefined;
+    const store: ?*FileStore = if (!file_store_supported) null else if (f.job_queue.global_cache.handle.makeOpenPath(
+        Cache.file_store_sub_path,
+        .{},
+    )) |dir| b: {
+        file_store = .{ .dir = dir, .io = f.io };
+        break :b &file_store;
+    } else |err| b: {
+        log.warn("unable to open package file store: {t}", .{err});
+        break :b null;
+    };
+    defer if (store) |fst| fst.dir.close();
+
     {
         // The final hash will be a hash of each file hashed independently. This
         // allows hashing in parallel.
@@ -1570,8 +1787,17 @@ fn computeHash(f: *Fetch, pkg_path: Cache.Path, filter: Filter) RunError!Compute
                 .failure = undefined, // to be populated by the worker
                 .size = undefined, // to be populated by the worker
             };
-            thread_pool.spawnWg(&wait_group, workerHashFile, .{ root_dir, hashed_file });
             try all_files.append(hashed_file);
+
+            const unpacked_file = if (kind == .file) hashed_files.get(hashed_file.normalized_path) else null;
+            if (unpacked_file) |uf| {
+                hashed_file.hash = uf.hash;
+                hashed_file.failure = {};
+                hashed_file.size = uf.size;
+                if (store) |fst| thread_pool.spawnWg(&wait_group, dedupeFile, .{ root_dir, fst, hashed_file });
+                continue;
+            }
+            thread_pool.spawnWg(&wait_group, workerHashFile, .{ root_dir, store, hashed_file });
         }
     }
 
@@ -1660,8 +1886,11 @@ fn dumpHashInfo(all_files: []const *const HashedFile) !void {
     try w.flush();
 }
 
-fn workerHashFile(dir: fs.Dir, hashed_file: *HashedFile) void {
+fn workerHashFile(dir: fs.Dir, store: ?*FileStore, hashed_file: *HashedFile) void {
     hashed_file.failure = hashFileFallible(dir, hashed_file);
+    if (hashed_file.failure) |_| {
+        if (store) |fst| if (hashed_file.kind == .file) dedupeFile(dir, fst, hashed_file);
+    } else |_| {}
 }
 
 fn workerDeleteFile(dir: fs.Dir, deleted_file: *DeletedFile) void {
@@ -1707,6 +1936,97 @@ fn hashFileFallible(dir: fs.Dir, hashed_file: *HashedFile) HashedFile.Error!void
     hashed_file.size = file_size;
 }
 
+/// The files shared between fetched packages, in `Cache.file_store_sub_path`
+/// of the global cache, each named by its `HashedFile.hash`. Package files are
+/// copy-on-write clones of these, so files which are unchanged between versions
+/// of a package only take up space once, while every package still has its own
+/// copy, which can be changed without affecting any other. The hash covers the
+/// path of the file within the package as well as its contents, so only files
+/// which stay in place are shared.
+///
+/// Using a store file bumps its modification time, by which `Cache.gc` evicts
+/// the files no fetch has used in a while.
+const FileStore = struct {
+    dir: fs.Dir,
+    io: Io,
+    /// Set once cloning has failed because the file system does not support
+    /// it, after which files are left as they are.
+    unsupported: std.atomic.Value(bool) = .init(false),
+
+    /// Logs why `fs_path` could not be shared, other than by a lack of support.
+    fn fail(store: *FileStore, fs_path: []const u8, err: anyerror) void {
+        switch (err) {
+            error.Unsupported => if (!store.unsupported.swap(true, .monotonic)) {
+                log.debug("file system does not support cloning files; package files are not shared", .{});
+            },
+            else => log.warn("unable to share package file '{s}' through the file store: {t}", .{ fs_path, err }),
+        }
+    }
+};
+
+const file_store_supported = native_os == .linux;
+
+/// Makes `hashed_file` share its contents with the same file in the store,
+/// first adding it to the store if it is not there yet. This is best-effort:
+/// on failure, the file is left as the private copy it already was.
+fn dedupeFile(dir: fs.Dir, store: *FileStore, hashed_file: *const HashedFile) void {
+    if (store.unsupported.load(.monotonic)) return;
+    const store_name = std.fmt.bytesToHex(hashed_file.hash, .lower);
+    if (store.dir.openFile(&store_name, .{})) |store_file| {
+        defer store_file.close();
+        replaceWithClone(store_file, store.dir, dir, hashed_file.fs_path) catch |err|
+            return store.fail(hashed_file.fs_path, err);
+        const now = Io.Clock.real.now(store.io) catch return;
+        store_file.updateTimes(now, now) catch {};
+    } else |open_err| switch (open_err) {
+        error.FileNotFound => {
+            const file = dir.openFile(hashed_file.fs_path, .{}) catch |err|
+                return store.fail(hashed_file.fs_path, err);
+            defer file.close();
+            // Should another process add the same file first, replacing it
+            // is harmless since the contents are identical.
+            replaceWithClone(file, store.dir, store.dir, &store_name) catch |err|
+                return store.fail(hashed_file.fs_path, err);
+        },
+        else => |err| return store.fail(hashed_file.fs_path, err),
+    }
+}
+
+/// Atomically replaces `dst_path` with a copy-on-write clone of `src`. The
+/// clone is created in `tmp_dir` before being moved into place, so that it
+/// never appears in the package directory while that is being walked.
+fn replaceWithClone(src: fs.File, tmp_dir: fs.Dir, dst_dir: fs.Dir, dst_path: []const u8) !void {
+    var tmp_path_buffer: [16 + ".tmp".len]u8 = undefined;
+    const tmp_path = std.fmt.bufPrint(&tmp_path_buffer, "{x:0>16}.tmp", .{
+        std.crypto.random.int(u64),
+    }) catch unreachable;
+    try cloneFile(src, tmp_dir, tmp_path);
+    errdefer tmp_dir.deleteFile(tmp_path) catch {};
+    try fs.rename(tmp_dir, tmp_path, dst_dir, dst_path);
+}
+
+/// Creates `dst_path` as a copy-on-write clone of `src`, or fails with
+/// `error.Unsupported` if the file system cannot clone between these
+/// directories.
+fn cloneFile(src: fs.File, dst_dir: fs.Dir, dst_path: []const u8) !void {
+    switch (native_os) {
+        .linux => {
+            const linux = std.os.linux;
+            const stat = try src.stat();
+            var dst = try dst_dir.createFile(dst_path, .{ .exclusive = true, .mode = stat.mode });
+            defer dst.close();
+            errdefer dst_dir.deleteFile(dst_path) catch {};
+            const FICLONE = linux.IOCTL.IOW(0x94, 9, c_int);
+            switch (linux.E.init(linux.ioctl(dst.handle, FICLONE, @intCast(src.handle)))) {
+                .SUCCESS => {},
+                .OPNOTSUPP, .XDEV, .INVAL, .NOTTY => return error.Unsupported,
+                else => |e| return std.posix.unexpectedErrno(e),
+            }
+        },
+        else => return error.Unsupported,
+    }
+}
+
 fn deleteFileFallible(dir: fs.Dir, deleted_file: *DeletedFile) DeletedFile.Error!void {
     try dir.deleteFile(deleted_file.fs_path);
 }
@@ -1900,6 +2220,9 @@ const UnpackResult = struct {
     // sub-directory indicated by the named path.
     root_dir: []const u8 = "",
 
+    // Files which were hashed while being unpacked, by path within the package.
+    hashed_files: std.StringHashMapUnmanaged(*const UnpackedFile) = .empty,
+
     const Error = union(enum) {
         unable_to_create_sym_link: struct {
             code: anyerror,
@@ -2231,6 +2554,121 @@ test "set executable bit based on file content" {
     // -rwxrwxr-x 1    17 Apr   script_with_shebang_without_exec_bit
 }
 
+test "files unpacked from a tarball hash the same as files read back" {
+    // The large file is written straight from the archive, and the small ones
+    // on the thread pool. Either way, the hash is computed while writing.
+    const gpa = std.testing.allocator;
+    const io = std.testing.io;
+
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    const big = try gpa.alloc(u8, max_buffered_file_size + 1);
+    defer gpa.free(big);
+    for (big, 0..) |*byte, i| byte.* = @truncate(i *% 31);
+    const files = [_]struct { []const u8, []const u8 }{
+        .{ "small", "small contents\n" },
+        .{ "sub/big", big },
+        .{ "sub/script", "#!/bin/sh\n" },
+    };
+
+    {
+        var tar_file = try tmp.dir.createFile("pkg.tar", .{});
+        defer tar_file.close();
+        var tar_file_buffer: [4096]u8 = undefined;
+        var tar_file_writer = tar_file.writer(&tar_file_buffer);
+        var tar_writer: std.tar.Writer = .{ .underlying_writer = &tar_file_writer.interface };
+        try tar_writer.setRoot("pkg");
+        var pkg_dir = try tmp.dir.makeOpenPath("pkg", .{});
+        defer pkg_dir.close();
+        for (files) |file| {
+            const sub_path, const contents = file;
+            try tar_writer.writeFileBytes(sub_path, contents, .{});
+            if (fs.path.dirname(sub_path)) |dir_name| try pkg_dir.makePath(dir_name);
+            try pkg_dir.writeFile(.{ .sub_path = sub_path, .data = contents });
+        }
+        try tar_file_writer.interface.flush();
+    }
+
+    var digests: [2]Package.Hash.Digest = undefined;
+    for ([_][]const u8{ "pkg.tar", "pkg" }, &digests) |name, *digest| {
+        const path = try std.fmt.allocPrint(gpa, ".zig-cache/tmp/{s}/{s}", .{ tmp.sub_path, name });
+        defer gpa.free(path);
+        var fb: TestFetchBuilder = undefined;
+        var fetch = try fb.build(gpa, io, tmp.dir, path);
+        defer fb.deinit();
+        try fetch.run();
+        digest.* = fetch.computed_hash.digest;
+    }
+    try std.testing.expectEqualSlices(u8, &digests[1], &digests[0]);
+}
+
+test "packages share identical files through the file store" {
+    const gpa = std.testing.allocator;
+    const io = std.testing.io;
+
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    // Package files are only shared where the file system can clone them.
+    {
+        try tmp.dir.writeFile(.{ .sub_path = "probe", .data = "probe" });
+        const probe = try tmp.dir.openFile("probe", .{});
+        defer probe.close();
+        cloneFile(probe, tmp.dir, "probe clone") catch |err| switch (err) {
+            error.Unsupported => return error.SkipZigTest,
+            else => |e| return e,
+        };
+    }
+
+    for ([_][]const u8{ "a", "b" }) |name| {
+        var pkg_dir = try tmp.dir.makeOpenPath(name, .{});
+        defer pkg_dir.close();
+        try pkg_dir.writeFile(.{ .sub_path = "shared", .data = "shared contents\n" });
+        try pkg_dir.writeFile(.{ .sub_path = name, .data = name });
+    }
+
+    var package_dirs: [2]fs.Dir = undefined;
+    var fetched: usize = 0;
+    defer for (package_dirs[0..fetched]) |*dir| dir.close();
+    for ([_][]const u8{ "a", "b" }, &package_dirs) |name, *package_dir| {
+        const path = try std.fmt.allocPrint(gpa, ".zig-cache/tmp/{s}/{s}", .{ tmp.sub_path, name });
+        defer gpa.free(path);
+        var fb: TestFetchBuilder = undefined;
+        var fetch = try fb.build(gpa, io, tmp.dir, path);
+        defer fb.deinit();
+        try fetch.run();
+        package_dir.* = try fb.packageDir();
+        fetched += 1;
+    }
+
+    // The store holds a single copy of the shared file, and one of each file
+    // only found in one package.
+    var store_dir = try tmp.dir.openDir("zig-global-cache/" ++ Cache.file_store_sub_path, .{ .iterate = true });
+    defer store_dir.close();
+    var store_count: usize = 0;
+    var it = store_dir.iterate();
+    while (try it.next()) |entry| {
+        try std.testing.expect(!std.mem.endsWith(u8, entry.name, ".tmp"));
+        store_count += 1;
+    }
+    try std.testing.expectEqual(3, store_count);
+
+    // Each package has a copy of its own, which can be changed without
+    // affecting the other package or the store.
+    const stat_a = try package_dirs[0].statFile("shared");
+    const stat_b = try package_dirs[1].statFile("shared");
+    try std.testing.expect(stat_a.inode != stat_b.inode);
+    try package_dirs[0].writeFile(.{ .sub_path = "shared", .data = "changed\n" });
+    var buf: [64]u8 = undefined;
+    try std.testing.expectEqualStrings("shared contents\n", try package_dirs[1].readFile("shared", &buf));
+    it = store_dir.iterate();
+    while (try it.next()) |entry| {
+        const contents = try store_dir.readFile(entry.name, &buf);
+        try std.testing.expect(!std.mem.eql(u8, contents, "changed\n"));
+    }
+}
+
 fn saveEmbedFile(comptime tarball_name: []const u8, dir: fs.Dir) !void {
     //const tarball_name = "duplicate_paths_excluded.tar.gz";
     const tarball_content = @embedFile("Fetch/testdata/" ++ tarball_name);
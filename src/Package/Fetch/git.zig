@@ -1265,10 +1265,29 @@ const IndexEntry = struct {
     crc32: u32,
 };
 
+/// A deltified object whose ID is not known until its base is resolved.
+const PendingDelta = struct {
+    entry: IndexEntry,
+    base: union(enum) {
+        offset: u64,
+        oid: Oid,
+    },
+    /// Set by the thread which resolves this delta. Normally each delta is
+    /// reached exactly once, but a ref delta could be reached more than once if
+    /// its base object appears more than once in the pack.
+    claimed: std.atomic.Value(bool) = .init(false),
+    /// Populated once `claimed` is set.
+    oid: Oid = undefined,
+};
+
 /// Writes out a version 2 index for the given packfile, as documented in
 /// [pack-format](https://git-scm.com/docs/pack-format).
+///
+/// Deltas are resolved by walking the tree of deltas based on each
+/// undeltified object, with the trees walked in parallel on `thread_pool`.
 pub fn indexPack(
     allocator: Allocator,
+    thread_pool: *std.Thread.Pool,
     format: Oid.Format,
     pack: *std.fs.File.Reader,
     index_writer: *std.fs.File.Writer,
@@ -1277,26 +1296,47 @@ pub fn indexPack(
 
     var index_entries: std.AutoHashMapUnmanaged(Oid, IndexEntry) = .empty;
     defer index_entries.deinit(allocator);
-    var pending_deltas: std.ArrayListUnmanaged(IndexEntry) = .empty;
+    var pending_deltas: std.ArrayListUnmanaged(PendingDelta) = .empty;
     defer pending_deltas.deinit(allocator);
 
     const pack_checksum = try indexPackFirstPass(allocator, format, pack, &index_entries, &pending_deltas);
 
-    var cache: ObjectCache = .{};
-    defer cache.deinit(allocator);
-    var remaining_deltas = pending_deltas.items.len;
-    while (remaining_deltas > 0) {
-        var i: usize = remaining_deltas;
-        while (i > 0) {
-            i -= 1;
-            const delta = pending_deltas.items[i];
-            if (try indexPackHashDelta(allocator, format, pack, delta, index_entries, &cache)) |oid| {
-                try index_entries.put(allocator, oid, delta);
-                _ = pending_deltas.swapRemove(i);
+    if (pending_deltas.items.len > 0) {
+        var delta_tree: DeltaTree = try .init(allocator, format, pack, pending_deltas.items);
+        defer delta_tree.deinit(allocator);
+
+        const roots = try allocator.alloc(DeltaTree.Root, index_entries.count());
+        defer allocator.free(roots);
+        var roots_len: usize = 0;
+        var index_entries_iter = index_entries.iterator();
+        while (index_entries_iter.next()) |entry| {
+            const root: DeltaTree.Root = .{
+                .offset = entry.value_ptr.offset,
+                .oid = entry.key_ptr.*,
+                .failure = {},
+            };
+            if (!delta_tree.hasChildren(root.offset, root.oid)) continue;
+            roots[roots_len] = root;
+            roots_len += 1;
+        }
+
+        {
+            var wait_group: std.Thread.WaitGroup = .{};
+            // This is called from a worker thread when fetching, so there must
+            // not be any waiting without working or a deadlock could occur.
+            defer thread_pool.waitAndWork(&wait_group);
+            for (roots[0..roots_len]) |*root| {
+                thread_pool.spawnWg(&wait_group, DeltaTree.resolve, .{ &delta_tree, allocator, root });
             }
         }
-        if (pending_deltas.items.len == remaining_deltas) return error.IncompletePack;
-        remaining_deltas = pending_deltas.items.len;
+        for (roots[0..roots_len]) |root| try root.failure;
+
+        try index_entries.ensureUnusedCapacity(allocator, @intCast(pending_deltas.items.len));
+        for (pending_deltas.items) |*delta| {
+            // Anything not reached has a base which is missing from the pack.
+            if (!delta.claimed.load(.monotonic)) return error.IncompletePack;
+            index_entries.putAssumeCapacity(delta.oid, delta.entry);
+        }
     }
 
     var oids: std.ArrayListUnmanaged(Oid) = .empty;
@@ -1372,7 +1412,7 @@ fn indexPackFirstPass(
     format: Oid.Format,
     pack: *std.fs.File.Reader,
     index_entries: *std.AutoHashMapUnmanaged(Oid, IndexEntry),
-    pending_deltas: *std.ArrayListUnmanaged(IndexEntry),
+    pending_deltas: *std.ArrayListUnmanaged(PendingDelta),
 ) !Oid {
     var flate_buffer: [std.compress.flate.max_window_len]u8 = undefined;
     var pack_buffer: [2048]u8 = undefined; // Reasonably large buffer for file system.
@@ -1400,14 +1440,23 @@ fn indexPackFirstPass(
                     .crc32 = 0,
                 });
             },
-            inline .ofs_delta, .ref_delta => |delta| {
+            inline .ofs_delta, .ref_delta => |delta, tag| {
                 var entry_decompress: std.compress.flate.Decompress = .init(&pack_hashed.reader, .zlib, &flate_buffer);
                 const n = try entry_decompress.reader.discardRemaining();
                 if (n != delta.uncompressed_length) return error.InvalidObject;
                 if (!skip_checksums) @compileError("TODO");
                 try pending_deltas.append(allocator, .{
-                    .offset = entry_offset,
-                    .crc32 = 0,
+                    .entry = .{
+                        .offset = entry_offset,
+                        .crc32 = 0,
+                    },
+                    .base = switch (tag) {
+                        .ofs_delta => .{
+                            .offset = std.math.sub(u64, entry_offset, delta.offset) catch return error.InvalidObject,
+                        },
+                        .ref_delta => .{ .oid = delta.base_object },
+                        else => comptime unreachable,
+                    },
                 });
             },
         }
@@ -1417,56 +1466,239 @@ fn indexPackFirstPass(
     return pack_hashed.hasher.finalResult();
 }
 
-/// Attempts to determine the final object ID of the given deltified object.
-/// May return null if this is not yet possible (if the delta is a ref-based
-/// delta and we do not yet know the offset of the base object).
-fn indexPackHashDelta(
-    allocator: Allocator,
+/// The deltas of a pack, arranged by base object so that each undeltified
+/// object can be walked to every object deltified from it, directly or through
+/// other deltas.
+const DeltaTree = struct {
     format: Oid.Format,
     pack: *std.fs.File.Reader,
-    delta: IndexEntry,
-    index_entries: std.AutoHashMapUnmanaged(Oid, IndexEntry),
-    cache: *ObjectCache,
-) !?Oid {
-    // Figure out the chain of deltas to resolve
-    var base_offset = delta.offset;
-    var base_header: EntryHeader = undefined;
-    var delta_offsets: std.ArrayListUnmanaged(u64) = .empty;
-    defer delta_offsets.deinit(allocator);
-    const base_object = while (true) {
-        if (cache.get(base_offset)) |base_object| break base_object;
-
-        try pack.seekTo(base_offset);
-        base_header = try EntryHeader.read(format, &pack.interface);
-        switch (base_header) {
-            .ofs_delta => |ofs_delta| {
-                try delta_offsets.append(allocator, base_offset);
-                base_offset = std.math.sub(u64, base_offset, ofs_delta.offset) catch return error.InvalidObject;
-            },
-            .ref_delta => |ref_delta| {
-                try delta_offsets.append(allocator, base_offset);
-                base_offset = (index_entries.get(ref_delta.base_object) orelse return null).offset;
-            },
-            else => {
-                const base_data = try readObjectRaw(allocator, &pack.interface, base_header.uncompressedLength());
-                errdefer allocator.free(base_data);
-                const base_object: Object = .{ .type = base_header.objectType(), .data = base_data };
-                try cache.put(allocator, base_offset, base_object);
-                break base_object;
-            },
+    deltas: []PendingDelta,
+    /// Indexes into `deltas` of the offset deltas, sorted by base offset.
+    ofs_children: []u32,
+    /// Indexes into `deltas` of the ref deltas, sorted by base object ID.
+    ref_children: []u32,
+
+    /// The most object data a thread walking a tree keeps in memory for use as
+    /// a delta base. Beyond this, the bases furthest from the current object
+    /// are dropped, and are reconstructed if they are needed again.
+    const max_base_bytes = 32 * 1024 * 1024; // 32MiB
+
+    /// An undeltified object with at least one delta based on it.
+    const Root = struct {
+        offset: u64,
+        oid: Oid,
+        failure: anyerror!void,
+    };
+
+    /// An object along the path currently being walked from a `Root`.
+    const Node = struct {
+        offset: u64,
+        /// Null if dropped to stay under `max_base_bytes`.
+        data: ?[]const u8,
+        /// The next children to visit, as indexes into `ofs_children` and
+        /// `ref_children`.
+        ofs_children: [2]usize,
+        ref_children: [2]usize,
+
+        fn nextChild(node: *Node, tree: *const DeltaTree) ?u32 {
+            if (node.ofs_children[0] < node.ofs_children[1]) {
+                defer node.ofs_children[0] += 1;
+                return tree.ofs_children[node.ofs_children[0]];
+            }
+            if (node.ref_children[0] < node.ref_children[1]) {
+                defer node.ref_children[0] += 1;
+                return tree.ref_children[node.ref_children[0]];
+            }
+            return null;
+        }
+
+        fn hasNextChild(node: Node) bool {
+            return node.ofs_children[0] < node.ofs_children[1] or
+                node.ref_children[0] < node.ref_children[1];
         }
     };
 
-    const base_data = try resolveDeltaChain(allocator, format, pack, base_object, delta_offsets.items, cache);
+    fn init(allocator: Allocator, format: Oid.Format, pack: *std.fs.File.Reader, deltas: []PendingDelta) !DeltaTree {
+        var ofs_children: std.ArrayListUnmanaged(u32) = .empty;
+        defer ofs_children.deinit(allocator);
+        var ref_children: std.ArrayListUnmanaged(u32) = .empty;
+        defer ref_children.deinit(allocator);
+        for (deltas, 0..) |delta, i| {
+            const children = switch (delta.base) {
+                .offset => &ofs_children,
+                .oid => &ref_children,
+            };
+            try children.append(allocator, std.math.cast(u32, i) orelse return error.ObjectTooLarge);
+        }
 
-    var entry_hasher_buffer: [64]u8 = undefined;
-    var entry_hasher: Oid.Hashing = .init(format, &entry_hasher_buffer);
-    const entry_hasher_w = entry_hasher.writer();
-    // Writes to hashers cannot fail.
-    entry_hasher_w.print("{t} {d}\x00", .{ base_object.type, base_data.len }) catch unreachable;
-    entry_hasher_w.writeAll(base_data) catch unreachable;
-    return entry_hasher.final();
-}
+        mem.sortUnstable(u32, ofs_children.items, deltas, struct {
+            fn lessThan(d: []PendingDelta, a: u32, b: u32) bool {
+                return d[a].base.offset < d[b].base.offset;
+            }
+        }.lessThan);
+        mem.sortUnstable(u32, ref_children.items, deltas, struct {
+            fn lessThan(d: []PendingDelta, a: u32, b: u32) bool {
+                return mem.lessThan(u8, d[a].base.oid.slice(), d[b].base.oid.slice());
+            }
+        }.lessThan);
+
+        const ofs_children_slice = try ofs_children.toOwnedSlice(allocator);
+        errdefer allocator.free(ofs_children_slice);
+        return .{
+            .format = format,
+            .pack = pack,
+            .deltas = deltas,
+            .ofs_children = ofs_children_slice,
+            .ref_children = try ref_children.toOwnedSlice(allocator),
+        };
+    }
+
+    fn deinit(tree: *DeltaTree, allocator: Allocator) void {
+        allocator.free(tree.ofs_children);
+        allocator.free(tree.ref_children);
+        tree.* = undefined;
+    }
+
+    fn initNode(tree: *const DeltaTree, offset: u64, oid: Oid, data: []const u8) Node {
+        const Context = struct {
+            deltas: []const PendingDelta,
+            offset: u64,
+            oid: *const Oid,
+
+            fn compareOffset(ctx: @This(), i: u32) std.math.Order {
+                return std.math.order(ctx.offset, ctx.deltas[i].base.offset);
+            }
+
+            fn compareOid(ctx: @This(), i: u32) std.math.Order {
+                return mem.order(u8, ctx.oid.slice(), ctx.deltas[i].base.oid.slice());
+            }
+        };
+        const ctx: Context = .{ .deltas = tree.deltas, .offset = offset, .oid = &oid };
+        const ofs_start, const ofs_end = std.sort.equalRange(u32, tree.ofs_children, ctx, Context.compareOffset);
+        const ref_start, const ref_end = std.sort.equalRange(u32, tree.ref_children, ctx, Context.compareOid);
+        return .{
+            .offset = offset,
+            .data = data,
+            .ofs_children = .{ ofs_start, ofs_end },
+            .ref_children = .{ ref_start, ref_end },
+        };
+    }
+
+    fn hasChildren(tree: *const DeltaTree, offset: u64, oid: Oid) bool {
+        return tree.initNode(offset, oid, &.{}).hasNextChild();
+    }
+
+    /// Resolves every delta reachable from `root`, storing any error in
+    /// `root.failure`.
+    fn resolve(tree: *const DeltaTree, allocator: Allocator, root: *Root) void {
+        root.failure = tree.resolveFallible(allocator, root.*);
+    }
+
+    fn resolveFallible(tree: *const DeltaTree, allocator: Allocator, root: Root) !void {
+        // Each thread reads the pack through its own reader, relying on
+        // positional reads to leave the others unaffected.
+        var pack_buffer: [4096]u8 = undefined;
+        var pack: std.fs.File.Reader = .init(tree.pack.file, tree.pack.io, &pack_buffer);
+
+        try pack.seekTo(root.offset);
+        const root_header = try EntryHeader.read(tree.format, &pack.interface);
+        const object_type = root_header.objectType();
+
+        var path: std.ArrayListUnmanaged(Node) = .empty;
+        defer {
+            for (path.items) |node| if (node.data) |data| allocator.free(data);
+            path.deinit(allocator);
+        }
+        var path_bytes: usize = 0;
+
+        {
+            const root_data = try readObjectRaw(allocator, &pack.interface, root_header.uncompressedLength());
+            errdefer allocator.free(root_data);
+            try path.append(allocator, tree.initNode(root.offset, root.oid, root_data));
+            path_bytes += root_data.len;
+        }
+
+        while (path.items.len > 0) {
+            const parent = &path.items[path.items.len - 1];
+            const delta_index = parent.nextChild(tree) orelse {
+                if (parent.data) |data| {
+                    path_bytes -= data.len;
+                    allocator.free(data);
+                }
+                path.items.len -= 1;
+                continue;
+            };
+            const delta = &tree.deltas[delta_index];
+            if (delta.claimed.swap(true, .monotonic)) continue;
+
+            if (parent.data == null) {
+                const data = try tree.reconstruct(allocator, &pack, path.items);
+                parent.data = data;
+                path_bytes += data.len;
+            }
+            const data = try applyDelta(allocator, tree.format, &pack, delta.entry.offset, parent.data.?);
+            errdefer allocator.free(data);
+
+            var entry_hasher_buffer: [64]u8 = undefined;
+            var entry_hasher: Oid.Hashing = .init(tree.format, &entry_hasher_buffer);
+            const entry_hasher_w = entry_hasher.writer();
+            // Writes to hashers cannot fail.
+            entry_hasher_w.print("{t} {d}\x00", .{ object_type, data.len }) catch unreachable;
+            entry_hasher_w.writeAll(data) catch unreachable;
+            delta.oid = entry_hasher.final();
+
+            const node = tree.initNode(delta.entry.offset, delta.oid, data);
+            if (!node.hasNextChild()) {
+                allocator.free(data);
+                continue;
+            }
+            if (!parent.hasNextChild()) {
+                // The parent is no longer needed, but it is kept in the path
+                // in case the child has to be reconstructed from its base.
+                if (parent.data) |parent_data| {
+                    path_bytes -= parent_data.len;
+                    allocator.free(parent_data);
+                    parent.data = null;
+                }
+            }
+            try path.append(allocator, node);
+            path_bytes += data.len;
+
+            for (path.items[0 .. path.items.len - 1]) |*base| {
+                if (path_bytes <= max_base_bytes) break;
+                if (base.data) |base_data| {
+                    path_bytes -= base_data.len;
+                    allocator.free(base_data);
+                    base.data = null;
+                }
+            }
+        }
+    }
+
+    /// Returns the data of the last node of `path`, which has been dropped, by
+    /// reapplying the deltas from the nearest node before it which has not.
+    fn reconstruct(tree: *const DeltaTree, allocator: Allocator, pack: *std.fs.File.Reader, path: []const Node) ![]const u8 {
+        var start = path.len - 1;
+        var data = while (start > 0) {
+            start -= 1;
+            if (path[start].data) |data| break data;
+        } else data: {
+            // Every node has been dropped, so start over from the root.
+            try pack.seekTo(path[0].offset);
+            const root_header = try EntryHeader.read(tree.format, &pack.interface);
+            break :data try readObjectRaw(allocator, &pack.interface, root_header.uncompressedLength());
+        };
+        var owned = path[start].data == null;
+        errdefer if (owned) allocator.free(data);
+        for (path[start + 1 ..]) |node| {
+            const next = try applyDelta(allocator, tree.format, pack, node.offset, data);
+            if (owned) allocator.free(data);
+            data = next;
+            owned = true;
+        }
+        return data;
+    }
+};
 
 /// Resolves a chain of deltas, returning the final base object data. `pack` is
 /// assumed to be looking at the start of the object data for the base object of
@@ -1486,27 +1718,40 @@ fn resolveDeltaChain(
         i -= 1;
 
         const delta_offset = delta_offsets[i];
-        try pack.seekTo(delta_offset);
-        const delta_header = try EntryHeader.read(format, &pack.interface);
-        const delta_data = try readObjectRaw(allocator, &pack.interface, delta_header.uncompressedLength());
-        defer allocator.free(delta_data);
-        var delta_reader: Io.Reader = .fixed(delta_data);
-        _ = try delta_reader.takeLeb128(u64); // base object size
-        const expanded_size = try delta_reader.takeLeb128(u64);
-
-        const expanded_alloc_size = std.math.cast(usize, expanded_size) orelse return error.ObjectTooLarge;
-        const expanded_data = try allocator.alloc(u8, expanded_alloc_size);
+        const expanded_data = try applyDelta(allocator, format, pack, delta_offset, base_data);
         errdefer allocator.free(expanded_data);
-        var expanded_delta_stream: Io.Writer = .fixed(expanded_data);
-        try expandDelta(base_data, &delta_reader, &expanded_delta_stream);
-        if (expanded_delta_stream.end != expanded_size) return error.InvalidObject;
-
         try cache.put(allocator, delta_offset, .{ .type = base_object.type, .data = expanded_data });
         base_data = expanded_data;
     }
     return base_data;
 }
 
+/// Reads the delta object at `delta_offset` in `pack` and applies it to
+/// `base_data`, returning the resulting object data.
+fn applyDelta(
+    allocator: Allocator,
+    format: Oid.Format,
+    pack: *std.fs.File.Reader,
+    delta_offset: u64,
+    base_data: []const u8,
+) ![]u8 {
+    try pack.seekTo(delta_offset);
+    const delta_header = try EntryHeader.read(format, &pack.interface);
+    const delta_data = try readObjectRaw(allocator, &pack.interface, delta_header.uncompressedLength());
+    defer allocator.free(delta_data);
+    var delta_reader: Io.Reader = .fixed(delta_data);
+    _ = try delta_reader.takeLeb128(u64); // base object size
+    const expanded_size = try delta_reader.takeLeb128(u64);
+
+    const expanded_alloc_size = std.math.cast(usize, expanded_size) orelse return error.ObjectTooLarge;
+    const expanded_data = try allocator.alloc(u8, expanded_alloc_size);
+    errdefer allocator.free(expanded_data);
+    var expanded_delta_stream: Io.Writer = .fixed(expanded_data);
+    try expandDelta(base_data, &delta_reader, &expanded_delta_stream);
+    if (expanded_delta_stream.end != expanded_size) return error.InvalidObject;
+    return expanded_data;
+}
+
 /// Reads the complete contents of an object from `reader`. This function may
 /// read more bytes than required from `reader`, so the reader position after
 /// returning is not reliable.
@@ -1593,7 +1838,10 @@ fn runRepositoryTest(io: Io, comptime format: Oid.Format, head_commit: []const u
     defer index_file.close();
     var index_file_buffer: [2000]u8 = undefined;
     var index_file_writer = index_file.writer(&index_file_buffer);
-    try indexPack(testing.allocator, format, &pack_file_reader, &index_file_writer);
+    var thread_pool: std.Thread.Pool = undefined;
+    try thread_pool.init(.{ .allocator = testing.allocator });
+    defer thread_pool.deinit();
+    try indexPack(testing.allocator, &thread_pool, format, &pack_file_reader, &index_file_writer);
 
     // Arbitrary size limit on files read while checking the repository contents
     // (all files in the test repo are known to be smaller than this)
@@ -1695,6 +1943,189 @@ test "SHA-256 packfile indexing and checkout" {
     try runRepositoryTest(std.testing.io, .sha256, "7f444a92bd4572ee4a28b2c63059924a9ca1829138553ef3e7c41ee159afae7a");
 }
 
+/// A stand-in for a smart HTTP Git server, which serves the SHA-1 test
+/// repository packfile for a single fetch regardless of what is requested.
+const TestServer = struct {
+    net_server: Io.net.Server,
+    advertise_shallow: bool,
+    /// Whether the fetch request asked for a depth 1 history.
+    requested_shallow: ?bool = null,
+
+    fn run(server: *TestServer, io: Io, result: *anyerror!void) void {
+        result.* = server.runFallible(io);
+    }
+
+    fn runFallible(server: *TestServer, io: Io) !void {
+        var recv_buffer: [4096]u8 = undefined;
+        var send_buffer: [4096]u8 = undefined;
+        // One request for the capabilities and one for the fetch
+        var requests_left: usize = 2;
+        while (requests_left > 0) {
+            var stream = try server.net_server.accept(io);
+            defer stream.close(io);
+            var stream_reader = stream.reader(io, &recv_buffer);
+            var stream_writer = stream.writer(io, &send_buffer);
+            var http_server = std.http.Server.init(&stream_reader.interface, &stream_writer.interface);
+            while (requests_left > 0) : (requests_left -= 1) {
+                var request = http_server.receiveHead() catch |err| switch (err) {
+                    error.HttpConnectionClosing => break,
+                    else => |e| return e,
+                };
+                try server.serve(&request);
+            }
+        }
+    }
+
+    fn serve(server: *TestServer, request: *std.http.Server.Request) !void {
+        const gpa = testing.allocator;
+        var response: Io.Writer.Allocating = .init(gpa);
+        defer response.deinit();
+        const w = &response.writer;
+
+        if (mem.eql(u8, request.head.target, "/repo/info/refs?service=git-upload-pack")) {
+            try Packet.write(.{ .data = "version 2\n" }, w);
+            try Packet.write(.{ .data = "agent=test\n" }, w);
+            try Packet.write(.{ .data = "ls-refs\n" }, w);
+            try Packet.write(.{ .data = if (server.advertise_shallow) "fetch=shallow\n" else "fetch\n" }, w);
+            try Packet.write(.{ .data = "object-format=sha1\n" }, w);
+            try Packet.write(.flush, w);
+        } else if (mem.eql(u8, request.head.target, "/repo/git-upload-pack")) {
+            var body_buffer: [64]u8 = undefined;
+            const body_reader = try request.readerExpectContinue(&body_buffer);
+            const body = try body_reader.allocRemaining(gpa, .limited(Packet.max_data_length));
+            defer gpa.free(body);
+            try testing.expect(mem.startsWith(u8, body, "0012command=fetch\n"));
+            server.requested_shallow = mem.indexOf(u8, body, "deepen 1\n") != null;
+
+            if (server.requested_shallow.?) {
+                // With a depth of 1, each wanted commit is a shallow boundary,
+                // which a real server announces before the packfile.
+                try Packet.write(.{ .data = "shallow-info\n" }, w);
+                var request_reader: Io.Reader = .fixed(body);
+                while (true) switch (try Packet.read(&request_reader)) {
+                    .flush => break,
+                    .data => |data| {
+                        const line = Packet.normalizeText(data);
+                        if (!mem.startsWith(u8, line, "want ")) continue;
+                        var buf: [Packet.max_data_length]u8 = undefined;
+                        const shallow = try std.fmt.bufPrint(&buf, "shallow {s}\n", .{line["want ".len..]});
+                        try Packet.write(.{ .data = shallow }, w);
+                    },
+                    else => {},
+                };
+                try Packet.write(.delimiter, w);
+            }
+            try Packet.write(.{ .data = "packfile\n" }, w);
+            var pack: []const u8 = @embedFile("git/testdata/testrepo-sha1.pack");
+            while (pack.len > 0) {
+                var data: [Packet.max_data_length]u8 = undefined;
+                const n = @min(pack.len, data.len - 1);
+                data[0] = @intFromEnum(Session.FetchStream.StreamCode.pack_data);
+                @memcpy(data[1..][0..n], pack[0..n]);
+                try Packet.write(.{ .data = data[0 .. n + 1] }, w);
+                pack = pack[n..];
+            }
+            try Packet.write(.flush, w);
+        } else {
+            return request.respond("", .{ .status = .not_found });
+        }
+        try request.respond(response.written(), .{});
+    }
+};
+
+/// Fetches and checks out the SHA-1 test repository over HTTP, checking that a
+/// shallow fetch is requested exactly when the server supports it.
+fn runFetchTest(io: Io, advertise_shallow: bool) !void {
+    if (@import("builtin").single_threaded) return error.SkipZigTest;
+    const gpa = testing.allocator;
+    const head_commit = "dd582c0720819ab7130b103635bd7271b9fd4feb";
+
+    const address = try Io.net.IpAddress.parse("127.0.0.1", 0);
+    var server: TestServer = .{
+        .net_server = try address.listen(io, .{ .reuse_address = true }),
+        .advertise_shallow = advertise_shallow,
+    };
+    defer server.net_server.deinit(io);
+    var server_result: anyerror!void = {};
+    const server_thread = try std.Thread.spawn(.{}, TestServer.run, .{ &server, io, &server_result });
+    var server_joined = false;
+    defer if (!server_joined) {
+        // Let the server finish waiting for its requests.
+        for (0..2) |_| {
+            var stream = server.net_server.socket.address.connect(io, .{ .mode = .stream }) catch break;
+            stream.close(io);
+        }
+        server_thread.join();
+    };
+
+    var arena_instance: std.heap.ArenaAllocator = .init(gpa);
+    defer arena_instance.deinit();
+    const arena = arena_instance.allocator();
+
+    var http_client: std.http.Client = .{ .allocator = gpa, .io = io };
+    defer http_client.deinit();
+
+    const uri_string = try std.fmt.allocPrint(arena, "http://127.0.0.1:{d}/repo", .{
+        server.net_server.socket.address.getPort(),
+    });
+    var response_buffer: [Packet.max_data_length]u8 = undefined;
+    var session: Session = try .init(arena, &http_client, try .parse(uri_string), &response_buffer);
+    try testing.expectEqual(advertise_shallow, session.supports_shallow);
+
+    var git_dir = testing.tmpDir(.{});
+    defer git_dir.cleanup();
+    var pack_file = try git_dir.dir.createFile("testrepo.pack", .{ .read = true });
+    defer pack_file.close();
+    var pack_file_buffer: [2000]u8 = undefined;
+    var pack_file_reader = pack_file_reader: {
+        var fetch_stream: Session.FetchStream = undefined;
+        try session.fetch(&fetch_stream, &.{head_commit}, &response_buffer);
+        defer fetch_stream.deinit();
+        var pack_file_writer = pack_file.writer(&pack_file_buffer);
+        _ = try fetch_stream.reader.streamRemaining(&pack_file_writer.interface);
+        try pack_file_writer.interface.flush();
+        break :pack_file_reader pack_file_writer.moveToReader(io);
+    };
+
+    server_thread.join();
+    server_joined = true;
+    try server_result;
+    try testing.expectEqual(advertise_shallow, server.requested_shallow.?);
+
+    var index_file = try git_dir.dir.createFile("testrepo.idx", .{ .read = true });
+    defer index_file.close();
+    var index_file_buffer: [2000]u8 = undefined;
+    var index_file_writer = index_file.writer(&index_file_buffer);
+    var thread_pool: std.Thread.Pool = undefined;
+    try thread_pool.init(.{ .allocator = gpa });
+    defer thread_pool.deinit();
+    try indexPack(gpa, &thread_pool, .sha1, &pack_file_reader, &index_file_writer);
+
+    var index_file_reader = index_file.reader(io, &index_file_buffer);
+    var repository: Repository = undefined;
+    try repository.init(gpa, .sha1, &pack_file_reader, &index_file_reader);
+    defer repository.deinit();
+
+    var worktree = testing.tmpDir(.{});
+    defer worktree.cleanup();
+    var diagnostics: Diagnostics = .{ .allocator = gpa };
+    defer diagnostics.deinit();
+    try repository.checkout(worktree.dir, try .parse(.sha1, head_commit), &diagnostics);
+    try testing.expect(diagnostics.errors.items.len == 0);
+
+    const file_contents = try worktree.dir.readFileAlloc("dir/subdir/file2", gpa, .limited(8192));
+    defer gpa.free(file_contents);
+    try testing.expect(file_contents.len > 0);
+}
+
+test "shallow fetch over HTTP" {
+    try runFetchTest(std.testing.io, true);
+}
+
+test "full fetch over HTTP without server support for shallow fetches" {
+    try runFetchTest(std.testing.io, false);
+}
+
 /// Checks out a commit of a packfile. Intended for experimenting with and
 /// benchmarking possible optimizations to the indexing and checkout behavior.
 pub fn main() !void {
@@ -1729,7 +2160,10 @@ pub fn main() !void {
     defer index_file.close();
     var index_file_buffer: [4096]u8 = undefined;
     var index_file_writer = index_file.writer(&index_file_buffer);
-    try indexPack(allocator, format, &pack_file_reader, &index_file_writer);
+    var thread_pool: std.Thread.Pool = undefined;
+    try thread_pool.init(.{ .allocator = allocator });
+    defer thread_pool.deinit();
+    try indexPack(allocator, &thread_pool, format, &pack_file_reader, &index_file_writer);
 
     std.debug.print("Starting checkout...\n", .{});
     var index_file_reader = index_file.reader(io, &index_file_buffer);
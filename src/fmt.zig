@@ -1,11 +1,13 @@
 const std = @import("std");
 const Io = std.Io;
+const Cache = std.Build.Cache;
 const mem = std.mem;
 const fs = std.fs;
 const process = std.process;
 const Allocator = std.mem.Allocator;
 const Color = std.zig.Color;
 const fatal = std.process.fatal;
+const build_options = @import("build_options");
 
 const usage_fmt =
     \\Usage: zig fmt [file]...
@@ -17,37 +19,59 @@ const usage_fmt =
     \\Options:
     \\  -h, --help             Print this help and exit
     \\  --color [auto|off|on]  Enable or disable colored error messages
+    \\  -j<N>                  Limit concurrent jobs (default is to use all CPU cores)
     \\  --stdin                Format code from stdin; output to stdout
     \\  --check                List non-conforming files and exit with an error
     \\                         if the list is non-empty
     \\  --ast-check            Run zig ast-check on every file
     \\  --exclude [file]       Exclude file or directory from formatting
     \\  --zon                  Treat all input files as ZON, regardless of file extension
+    \\  --cache-dir [path]     Skip files recorded in this directory as already
+    \\                         formatted, and record newly formatted ones
     \\
     \\
 ;
 
 const Fmt = struct {
     seen: SeenMap,
+    jobs: std.ArrayListUnmanaged(Job),
     any_error: bool,
     check_ast: bool,
+    check_mode: bool,
     force_zon: bool,
-    color: Color,
     gpa: Allocator,
     arena: Allocator,
     io: Io,
-    out_buffer: std.Io.Writer.Allocating,
+    /// Contains an empty file for the cache key of each file known to be
+    /// formatted already, see `cacheKey`.
+    cache_dir: ?fs.Dir,
     stdout_writer: *fs.File.Writer,
 
     const SeenMap = std.AutoHashMap(fs.File.INode, void);
 };
 
+/// A file found while walking the inputs. Jobs are processed concurrently and
+/// their results reported afterwards in the order the files were found, so
+/// output does not depend on scheduling.
+const Job = struct {
+    /// Relative to the current working directory.
+    path: []const u8,
+    /// Parse errors, or compile errors when `--ast-check` is used.
+    errors: std.zig.ErrorBundle = .empty,
+    /// The file is not formatted correctly. Unless in check mode, it has been
+    /// rewritten.
+    changed: bool = false,
+    failure: ?anyerror = null,
+};
+
 pub fn run(gpa: Allocator, arena: Allocator, io: Io, args: []const []const u8) !void {
     var color: Color = .auto;
     var stdin_flag = false;
     var check_flag = false;
     var check_ast_flag = false;
     var force_zon = false;
+    var cache_dir_path: ?[]const u8 = null;
+    var n_jobs: ?usize = null;
     var input_files = std.array_list.Managed([]const u8).init(gpa);
     defer input_files.deinit();
     var excluded_files = std.array_list.Managed([]const u8).init(gpa);
@@ -85,6 +109,22 @@ pub fn run(gpa: Allocator, arena: Allocator, io: Io, args: []const []const u8) !
                     try excluded_files.append(next_arg);
                 } else if (mem.eql(u8, arg, "--zon")) {
                     force_zon = true;
+                } else if (mem.eql(u8, arg, "--cache-dir")) {
+                    if (i + 1 >= args.len) {
+                        fatal("expected parameter after --cache-dir", .{});
+                    }
+                    i += 1;
+                    cache_dir_path = args[i];
+                } else if (mem.cutPrefix(u8, arg, "-j")) |str| {
+                    const num = std.fmt.parseUnsigned(u32, str, 10) catch |err| {
+                        fatal("unable to parse jobs count '{s}': {s}", .{
+                            str, @errorName(err),
+                        });
+                    };
+                    if (num < 1) {
+                        fatal("number of jobs must be at least 1\n", .{});
+                    }
+                    n_jobs = num;
                 } else {
                     fatal("unrecognized parameter: '{s}'", .{arg});
                 }
@@ -164,20 +204,29 @@ pub fn run(gpa: Allocator, arena: Allocator, io: Io, args: []const []const u8) !
     var stdout_buffer: [4096]u8 = undefined;
     var stdout_writer = fs.File.stdout().writer(&stdout_buffer);
 
+    var cache_dir: ?fs.Dir = if (cache_dir_path) |path| dir: {
+        const sub_path = try fs.path.join(arena, &.{ path, "fmt" });
+        break :dir fs.cwd().makeOpenPath(sub_path, .{}) catch |err| {
+            fatal("unable to open cache directory '{s}': {s}", .{ sub_path, @errorName(err) });
+        };
+    } else null;
+    defer if (cache_dir) |*dir| dir.close();
+
     var fmt: Fmt = .{
         .gpa = gpa,
         .arena = arena,
         .io = io,
         .seen = .init(gpa),
+        .jobs = .empty,
         .any_error = false,
         .check_ast = check_ast_flag,
+        .check_mode = check_flag,
         .force_zon = force_zon,
-        .color = color,
-        .out_buffer = .init(gpa),
+        .cache_dir = cache_dir,
         .stdout_writer = &stdout_writer,
     };
     defer fmt.seen.deinit();
-    defer fmt.out_buffer.deinit();
+    defer fmt.jobs.deinit(gpa);
 
     // Mark any excluded files/directories as already seen,
     // so that they are skipped later during actual processing
@@ -196,7 +245,35 @@ pub fn run(gpa: Allocator, arena: Allocator, io: Io, args: []const []const u8) !
     }
 
     for (input_files.items) |file_path| {
-        try fmtPath(&fmt, file_path, check_flag, fs.cwd(), file_path);
+        try fmtPath(&fmt, file_path, fs.cwd(), file_path);
+    }
+
+    {
+        var thread_pool: std.Thread.Pool = undefined;
+        try thread_pool.init(.{ .allocator = gpa, .n_jobs = n_jobs });
+        defer thread_pool.deinit();
+
+        var wait_group: std.Thread.WaitGroup = .{};
+        for (fmt.jobs.items) |*job| {
+            thread_pool.spawnWg(&wait_group, workerFmtFile, .{ &fmt, job });
+        }
+        thread_pool.waitAndWork(&wait_group);
+    }
+
+    for (fmt.jobs.items) |*job| {
+        defer job.errors.deinit(gpa);
+        if (job.failure) |err| {
+            std.log.err("unable to format '{s}': {s}", .{ job.path, @errorName(err) });
+            fmt.any_error = true;
+        }
+        if (job.errors.errorMessageCount() != 0) {
+            job.errors.renderToStdErr(.{}, color);
+            fmt.any_error = true;
+        }
+        if (job.changed) {
+            try fmt.stdout_writer.interface.print("{s}\n", .{job.path});
+            if (check_flag) fmt.any_error = true;
+        }
     }
     try fmt.stdout_writer.interface.flush();
     if (fmt.any_error) {
@@ -204,21 +281,22 @@ pub fn run(gpa: Allocator, arena: Allocator, io: Io, args: []const []const u8) !
     }
 }
 
-fn fmtPath(fmt: *Fmt, file_path: []const u8, check_mode: bool, dir: fs.Dir, sub_path: []const u8) !void {
-    fmtPathFile(fmt, file_path, check_mode, dir, sub_path) catch |err| switch (err) {
-        error.IsDir, error.AccessDenied => return fmtPathDir(fmt, file_path, check_mode, dir, sub_path),
+fn fmtPath(fmt: *Fmt, file_path: []const u8, dir: fs.Dir, sub_path: []const u8) !void {
+    const stat = dir.statFile(sub_path) catch |err| switch (err) {
+        error.IsDir, error.AccessDenied => return fmtPathDir(fmt, file_path, dir, sub_path),
         else => {
             std.log.err("unable to format '{s}': {s}", .{ file_path, @errorName(err) });
             fmt.any_error = true;
             return;
         },
     };
+    if (stat.kind == .directory) return fmtPathDir(fmt, file_path, dir, sub_path);
+    try queueFile(fmt, file_path, stat);
 }
 
 fn fmtPathDir(
     fmt: *Fmt,
     file_path: []const u8,
-    check_mode: bool,
     parent_dir: fs.Dir,
     parent_sub_path: []const u8,
 ) !void {
@@ -235,45 +313,50 @@ fn fmtPathDir(
         if (mem.startsWith(u8, entry.name, ".")) continue;
 
         if (is_dir or entry.kind == .file and (mem.endsWith(u8, entry.name, ".zig") or mem.endsWith(u8, entry.name, ".zon"))) {
-            const full_path = try fs.path.join(fmt.gpa, &[_][]const u8{ file_path, entry.name });
-            defer fmt.gpa.free(full_path);
+            // Queued jobs refer to their path until the end of `run`.
+            const full_path = try fs.path.join(fmt.arena, &[_][]const u8{ file_path, entry.name });
 
             if (is_dir) {
-                try fmtPathDir(fmt, full_path, check_mode, dir, entry.name);
+                try fmtPathDir(fmt, full_path, dir, entry.name);
             } else {
-                fmtPathFile(fmt, full_path, check_mode, dir, entry.name) catch |err| {
+                const file_stat = dir.statFile(entry.name) catch |err| {
                     std.log.err("unable to format '{s}': {s}", .{ full_path, @errorName(err) });
                     fmt.any_error = true;
-                    return;
+                    continue;
                 };
+                try queueFile(fmt, full_path, file_stat);
             }
         }
     }
 }
 
-fn fmtPathFile(
-    fmt: *Fmt,
-    file_path: []const u8,
-    check_mode: bool,
-    dir: fs.Dir,
-    sub_path: []const u8,
-) !void {
+fn queueFile(fmt: *Fmt, file_path: []const u8, stat: fs.File.Stat) !void {
+    if (try fmt.seen.fetchPut(stat.inode, {})) |_| return;
+    try fmt.jobs.append(fmt.gpa, .{ .path = file_path });
+}
+
+fn workerFmtFile(fmt: *const Fmt, job: *Job) void {
+    fmtFile(fmt, job) catch |err| {
+        job.failure = err;
+    };
+}
+
+/// Runs on a worker thread, so it must only report results through `job`.
+fn fmtFile(fmt: *const Fmt, job: *Job) !void {
     const io = fmt.io;
+    const gpa = fmt.gpa;
+    const file_path = job.path;
 
-    const source_file = try dir.openFile(sub_path, .{});
+    const source_file = try fs.cwd().openFile(file_path, .{});
     var file_closed = false;
     errdefer if (!file_closed) source_file.close();
 
     const stat = try source_file.stat();
 
-    if (stat.kind == .directory)
-        return error.IsDir;
-
     var read_buffer: [1024]u8 = undefined;
     var file_reader: fs.File.Reader = source_file.reader(io, &read_buffer);
     file_reader.size = stat.size;
 
-    const gpa = fmt.gpa;
     const source_code = std.zig.readSourceFileToEndAlloc(gpa, &file_reader) catch |err| switch (err) {
         error.ReadFailed => return file_reader.err.?,
         else => |e| return e,
@@ -283,21 +366,28 @@ fn fmtPathFile(
     source_file.close();
     file_closed = true;
 
-    // Add to set after no longer possible to get error.IsDir.
-    if (try fmt.seen.fetchPut(stat.inode, {})) |_| return;
-
     const mode: std.zig.Ast.Mode = mode: {
         if (fmt.force_zon) break :mode .zon;
-        if (mem.endsWith(u8, sub_path, ".zon")) break :mode .zon;
+        if (mem.endsWith(u8, file_path, ".zon")) break :mode .zon;
         break :mode .zig;
     };
 
+    // Hashing is much cheaper than parsing and rendering, so a file already
+    // known to be formatted is skipped here.
+    if (fmt.cache_dir) |cache_dir| {
+        const key = cacheKey(fmt, mode, source_code);
+        if (cache_dir.access(&key, .{})) |_| return else |_| {}
+    }
+
     var tree = try std.zig.Ast.parse(gpa, source_code, mode);
     defer tree.deinit(gpa);
 
     if (tree.errors.len != 0) {
-        try std.zig.printAstErrorsToStderr(gpa, tree, file_path, fmt.color);
-        fmt.any_error = true;
+        var wip_errors: std.zig.ErrorBundle.Wip = undefined;
+        try wip_errors.init(gpa);
+        defer wip_errors.deinit();
+        try std.zig.putAstErrorsIntoBundle(gpa, tree, file_path, &wip_errors);
+        job.errors = try wip_errors.toOwnedBundle("");
         return;
     }
 
@@ -305,20 +395,17 @@ fn fmtPathFile(
         if (stat.size > std.zig.max_src_size)
             return error.FileTooBig;
 
+        var wip_errors: std.zig.ErrorBundle.Wip = undefined;
+        try wip_errors.init(gpa);
+        defer wip_errors.deinit();
+
         switch (mode) {
             .zig => {
                 var zir = try std.zig.AstGen.generate(gpa, tree);
                 defer zir.deinit(gpa);
 
                 if (zir.hasCompileErrors()) {
-                    var wip_errors: std.zig.ErrorBundle.Wip = undefined;
-                    try wip_errors.init(gpa);
-                    defer wip_errors.deinit();
                     try wip_errors.addZirErrorMessages(zir, tree, source_code, file_path);
-                    var error_bundle = try wip_errors.toOwnedBundle("");
-                    defer error_bundle.deinit(gpa);
-                    error_bundle.renderToStdErr(.{}, fmt.color);
-                    fmt.any_error = true;
                 }
             },
             .zon => {
@@ -326,40 +413,58 @@ fn fmtPathFile(
                 defer zoir.deinit(gpa);
 
                 if (zoir.hasCompileErrors()) {
-                    var wip_errors: std.zig.ErrorBundle.Wip = undefined;
-                    try wip_errors.init(gpa);
-                    defer wip_errors.deinit();
                     try wip_errors.addZoirErrorMessages(zoir, tree, source_code, file_path);
-                    var error_bundle = try wip_errors.toOwnedBundle("");
-                    defer error_bundle.deinit(gpa);
-                    error_bundle.renderToStdErr(.{}, fmt.color);
-                    fmt.any_error = true;
                 }
             },
         }
+        job.errors = try wip_errors.toOwnedBundle("");
     }
 
     // As a heuristic, we make enough capacity for the same as the input source.
-    fmt.out_buffer.clearRetainingCapacity();
-    try fmt.out_buffer.ensureTotalCapacity(source_code.len);
+    var out_buffer: std.Io.Writer.Allocating = try .initCapacity(gpa, source_code.len);
+    defer out_buffer.deinit();
 
-    tree.render(gpa, &fmt.out_buffer.writer, .{}) catch |err| switch (err) {
+    tree.render(gpa, &out_buffer.writer, .{}) catch |err| switch (err) {
         error.WriteFailed, error.OutOfMemory => return error.OutOfMemory,
     };
-    if (mem.eql(u8, fmt.out_buffer.written(), source_code))
+    const formatted = out_buffer.written();
+
+    if (mem.eql(u8, formatted, source_code)) {
+        recordFormatted(fmt, job, mode, formatted);
         return;
+    }
 
-    if (check_mode) {
-        try fmt.stdout_writer.interface.print("{s}\n", .{file_path});
-        fmt.any_error = true;
-    } else {
-        var af = try dir.atomicFile(sub_path, .{ .mode = stat.mode, .write_buffer = &.{} });
-        defer af.deinit();
+    job.changed = true;
+    if (fmt.check_mode) return;
 
-        try af.file_writer.interface.writeAll(fmt.out_buffer.written());
-        try af.finish();
-        try fmt.stdout_writer.interface.print("{s}\n", .{file_path});
-    }
+    var af = try fs.cwd().atomicFile(file_path, .{ .mode = stat.mode, .write_buffer = &.{} });
+    defer af.deinit();
+
+    try af.file_writer.interface.writeAll(formatted);
+    try af.finish();
+    recordFormatted(fmt, job, mode, formatted);
+}
+
+/// Covers everything that decides whether `source` passes: the formatter
+/// itself, the AST mode, and whether `--ast-check` is in effect.
+fn cacheKey(fmt: *const Fmt, mode: std.zig.Ast.Mode, source: []const u8) Cache.HexDigest {
+    var hh: Cache.HashHelper = .{};
+    hh.addBytes(build_options.version);
+    hh.add(mode);
+    hh.add(fmt.check_ast);
+    hh.addBytes(source);
+    return hh.final();
+}
+
+fn recordFormatted(fmt: *const Fmt, job: *const Job, mode: std.zig.Ast.Mode, formatted: []const u8) void {
+    const cache_dir = fmt.cache_dir orelse return;
+    // Files with `--ast-check` errors are not recorded, so that the errors are
+    // reported again on the next run.
+    if (job.errors.errorMessageCount() != 0) return;
+    const key = cacheKey(fmt, mode, formatted);
+    // The cache only saves work; failing to populate it is not an error.
+    const file = cache_dir.createFile(&key, .{}) catch return;
+    file.close();
 }
 
 /// Provided for debugging/testing purposes; unused by the compiler.
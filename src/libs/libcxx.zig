@@ -258,6 +258,7 @@ pub fn buildLibCxx(comp: *Compilation, prog_node: std.Progress.Node) BuildError!
     const sub_compilation = Compilation.create(comp.gpa, arena, io, &sub_create_diag, .{
         .dirs = comp.dirs.withoutLocalCache(),
         .self_exe_path = comp.self_exe_path,
+        .remote_cache = comp.remote_cache,
         .cache_mode = .whole,
         .config = config,
         .root_mod = root_mod,
@@ -451,6 +452,7 @@ pub fn buildLibCxxAbi(comp: *Compilation, prog_node: std.Progress.Node) BuildErr
     const sub_compilation = Compilation.create(comp.gpa, arena, io, &sub_create_diag, .{
         .dirs = comp.dirs.withoutLocalCache(),
         .self_exe_path = comp.self_exe_path,
+        .remote_cache = comp.remote_cache,
         .cache_mode = .whole,
         .config = config,
         .root_mod = root_mod,
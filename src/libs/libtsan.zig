@@ -282,6 +282,7 @@ pub fn buildTsan(comp: *Compilation, prog_node: std.Progress.Node) BuildError!vo
         .dirs = comp.dirs.withoutLocalCache(),
         .thread_pool = comp.thread_pool,
         .self_exe_path = comp.self_exe_path,
+        .remote_cache = comp.remote_cache,
         .cache_mode = .whole,
         .config = config,
         .root_mod = root_mod,
@@ -147,6 +147,7 @@ pub fn buildStaticLib(comp: *Compilation, prog_node: std.Progress.Node) BuildErr
     const sub_compilation = Compilation.create(comp.gpa, arena, io, &sub_create_diag, .{
         .dirs = comp.dirs.withoutLocalCache(),
         .self_exe_path = comp.self_exe_path,
+        .remote_cache = comp.remote_cache,
         .config = config,
         .root_mod = root_mod,
         .cache_mode = .whole,
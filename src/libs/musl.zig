@@ -250,6 +250,7 @@ pub fn buildCrtFile(comp: *Compilation, in_crt_file: CrtFile, prog_node: std.Pro
             const sub_compilation = Compilation.create(comp.gpa, arena, io, &sub_create_diag, .{
                 .dirs = comp.dirs.withoutLocalCache(),
                 .self_exe_path = comp.self_exe_path,
+                .remote_cache = comp.remote_cache,
                 .cache_mode = .whole,
                 .config = config,
                 .root_mod = root_mod,
@@ -395,6 +395,9 @@ pub const File = struct {
     zcu_object_basename: ?[]const u8 = null,
     gc_sections: bool,
     print_gc_sections: bool,
+    /// Path, relative to the current working directory, of the linker map file
+    /// to write after a successful link. Written as JSON if it ends in `.json`.
+    map_file: ?[]const u8 = null,
     build_id: std.zig.BuildId,
     allow_shlib_undefined: bool,
     stack_size: u64,
@@ -455,6 +458,7 @@ pub const File = struct {
         print_gc_sections: bool,
         print_icf_sections: bool,
         print_map: bool,
+        map_file: ?[]const u8,
 
         /// Use a wrapper function for symbol. Any undefined reference to symbol
         /// will be resolved to __wrap_symbol. Any undefined reference to
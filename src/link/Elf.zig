@@ -15,6 +15,9 @@ z_relro: bool,
 z_common_page_size: ?u64,
 /// TODO make this non optional and resolve the default in open()
 z_max_page_size: ?u64,
+/// Fold strings of SHF_MERGE|SHF_STRINGS sections that are suffixes of other strings
+/// into the longer string.
+tail_merge_strings: bool,
 soname: ?[]const u8,
 entry_name: ?[]const u8,
 
@@ -266,6 +269,7 @@ pub fn createEmpty(
                 null,
             .gc_sections = options.gc_sections orelse (optimize_mode != .Debug and output_mode != .Obj),
             .print_gc_sections = options.print_gc_sections,
+            .map_file = options.map_file,
             .stack_size = options.stack_size orelse 16777216,
             .allow_shlib_undefined = options.allow_shlib_undefined orelse !is_native_os,
             .file = null,
@@ -302,6 +306,7 @@ pub fn createEmpty(
         .z_relro = options.z_relro,
         .z_common_page_size = options.z_common_page_size,
         .z_max_page_size = options.z_max_page_size,
+        .tail_merge_strings = optimize_mode != .Debug and output_mode != .Obj,
         .soname = options.soname,
         .dump_argv_list = .empty,
     };
@@ -937,6 +942,11 @@ fn flushInner(self: *Elf, arena: Allocator, tid: Zcu.PerThread.Id) !void {
     }
 
     if (diags.hasErrors()) return error.LinkFailure;
+
+    if (self.base.map_file) |map_file| self.writeMapFile(arena, map_file) catch |err| switch (err) {
+        error.OutOfMemory => return error.OutOfMemory,
+        else => |e| return diags.fail("failed to write map file '{s}': {s}", .{ map_file, @errorName(e) }),
+    };
 }
 
 fn dumpArgvInit(self: *Elf, arena: Allocator) !void {
@@ -1789,18 +1799,23 @@ pub fn resolveMergeSections(self: *Elf) !void {
     const tracy = trace(@src());
     defer tracy.end();
 
-    var has_errors = false;
-    for (self.objects.items) |index| {
-        const object = self.file(index).?.object;
-        if (!object.alive) continue;
-        if (!object.dirty) continue;
-        object.initInputMergeSections(self) catch |err| switch (err) {
-            error.LinkFailure => has_errors = true,
-            else => |e| return e,
-        };
+    const comp = self.base.comp;
+    const diags = &comp.link_diags;
+
+    // Splitting input merge sections into strings and hashing them only touches the
+    // owning object, so every object can be processed in parallel.
+    {
+        var wg: WaitGroup = .{};
+        defer comp.thread_pool.waitAndWork(&wg);
+        for (self.objects.items) |index| {
+            const object = self.file(index).?.object;
+            if (!object.alive) continue;
+            if (!object.dirty) continue;
+            comp.thread_pool.spawnWg(&wg, initInputMergeSectionsWorker, .{ self, object });
+        }
     }
 
-    if (has_errors) return error.LinkFailure;
+    if (diags.hasErrors()) return error.LinkFailure;
 
     for (self.objects.items) |index| {
         const object = self.file(index).?.object;
@@ -1809,23 +1824,80 @@ pub fn resolveMergeSections(self: *Elf) !void {
         try object.initOutputMergeSections(self);
     }
 
+    // Each output merge section owns its string table, so strings are interned in parallel
+    // across merge sections. Within a merge section, objects are visited in input order which
+    // keeps subsection indexes identical to a serial link.
+    {
+        var wg: WaitGroup = .{};
+        defer comp.thread_pool.waitAndWork(&wg);
+        for (0..self.merge_sections.items.len) |msec_index| {
+            comp.thread_pool.spawnWg(&wg, internMergeSectionWorker, .{ self, @as(Merge.Section.Index, @intCast(msec_index)) });
+        }
+    }
+
+    if (diags.hasErrors()) return error.LinkFailure;
+
+    {
+        var wg: WaitGroup = .{};
+        defer comp.thread_pool.waitAndWork(&wg);
+        for (self.objects.items) |index| {
+            const object = self.file(index).?.object;
+            if (!object.alive) continue;
+            if (!object.dirty) continue;
+            comp.thread_pool.spawnWg(&wg, resolveMergeSubsectionsWorker, .{ self, object });
+        }
+    }
+
+    if (diags.hasErrors()) return error.LinkFailure;
+}
+
+fn initInputMergeSectionsWorker(self: *Elf, object: *Object) void {
+    const diags = &self.base.comp.link_diags;
+    object.initInputMergeSections(self) catch |err| switch (err) {
+        error.LinkFailure => {}, // already reported
+        error.OutOfMemory => diags.setAllocFailure(),
+        else => |e| diags.addError("{f}: failed to split merge sections: {s}", .{ object.fmtPath(), @errorName(e) }),
+    };
+}
+
+fn internMergeSectionWorker(self: *Elf, msec_index: Merge.Section.Index) void {
+    const diags = &self.base.comp.link_diags;
     for (self.objects.items) |index| {
         const object = self.file(index).?.object;
         if (!object.alive) continue;
         if (!object.dirty) continue;
-        object.resolveMergeSubsections(self) catch |err| switch (err) {
-            error.LinkFailure => has_errors = true,
-            else => |e| return e,
+        object.internMergeStrings(self, msec_index) catch |err| switch (err) {
+            error.OutOfMemory => return diags.setAllocFailure(),
+            error.Overflow => return diags.addError("{f}: merge section entry size overflow", .{object.fmtPath()}),
         };
     }
+}
 
-    if (has_errors) return error.LinkFailure;
+fn resolveMergeSubsectionsWorker(self: *Elf, object: *Object) void {
+    const diags = &self.base.comp.link_diags;
+    object.resolveMergeSubsections(self) catch |err| switch (err) {
+        error.LinkFailure => {}, // already reported
+        error.OutOfMemory => diags.setAllocFailure(),
+    };
 }
 
 pub fn finalizeMergeSections(self: *Elf) !void {
-    for (self.merge_sections.items) |*msec| {
-        try msec.finalize(self.base.comp.gpa);
+    const comp = self.base.comp;
+    var wg: WaitGroup = .{};
+    {
+        defer comp.thread_pool.waitAndWork(&wg);
+        for (self.merge_sections.items) |*msec| {
+            comp.thread_pool.spawnWg(&wg, finalizeMergeSectionWorker, .{ self, msec });
+        }
     }
+    if (comp.link_diags.hasErrors()) return error.LinkFailure;
+}
+
+fn finalizeMergeSectionWorker(self: *Elf, msec: *Merge.Section) void {
+    const comp = self.base.comp;
+    msec.finalize(comp.gpa, self.tail_merge_strings) catch |err| switch (err) {
+        error.OutOfMemory => comp.link_diags.setAllocFailure(),
+    };
 }
 
 pub fn updateMergeSectionSizes(self: *Elf) !void {
@@ -4064,6 +4136,137 @@ fn fmtDumpState(self: *Elf, writer: *std.Io.Writer) std.Io.Writer.Error!void {
     }
 }
 
+/// Writes the linker map requested with `-Map`. All addresses must have been allocated.
+fn writeMapFile(self: *Elf, arena: Allocator, sub_path: []const u8) !void {
+    const zcu = self.base.comp.zcu;
+
+    // Attribute every live symbol to the atom defining it.
+    var atom_symbols: std.AutoHashMapUnmanaged(Ref, std.ArrayListUnmanaged(MapFile.Symbol)) = .empty;
+
+    if (self.zigObjectPtr()) |zo| {
+        var symbol_navs: std.AutoHashMapUnmanaged(Symbol.Index, InternPool.Nav.Index) = .empty;
+        for (zo.navs.keys(), zo.navs.values()) |nav_index, metadata| {
+            try symbol_navs.put(arena, metadata.symbol_index, nav_index);
+        }
+        for (zo.local_symbols.items, 0..) |index, i| {
+            const nav_index = symbol_navs.get(@intCast(i));
+            try self.addMapSymbol(arena, &atom_symbols, zo.symbols.items[index], zcu, nav_index);
+        }
+        for (zo.global_symbols.items, zo.symbols_resolver.items, 0..) |index, resolv, i| {
+            const ref_sym = self.symbol(self.resolver.values.items[resolv - 1]) orelse continue;
+            if (ref_sym.file(self).?.index() != zo.index) continue;
+            const nav_index = symbol_navs.get(@intCast(i | ZigObject.global_symbol_bit));
+            try self.addMapSymbol(arena, &atom_symbols, zo.symbols.items[index], zcu, nav_index);
+        }
+    }
+
+    for (self.objects.items) |index| {
+        const object = self.file(index).?.object;
+        for (object.locals()) |local| {
+            try self.addMapSymbol(arena, &atom_symbols, local, null, null);
+        }
+        for (object.globals(), object.symbols_resolver.items) |global, resolv| {
+            const ref_sym = self.symbol(self.resolver.values.items[resolv - 1]) orelse continue;
+            if (ref_sym.file(self).?.index() != object.index) continue;
+            try self.addMapSymbol(arena, &atom_symbols, global, null, null);
+        }
+    }
+
+    const slice = self.sections.slice();
+    const section_atoms = try arena.alloc(std.ArrayListUnmanaged(MapFile.Atom), slice.len);
+    @memset(section_atoms, .empty);
+
+    var files: std.ArrayListUnmanaged(File.Index) = .empty;
+    if (self.zig_object_index) |index| try files.append(arena, index);
+    try files.appendSlice(arena, self.objects.items);
+    for (files.items) |index| {
+        const file_ptr = self.file(index).?;
+        const input = try std.fmt.allocPrint(arena, "{f}", .{file_ptr.fmtPath()});
+        for (file_ptr.atoms()) |atom_index| {
+            const atom_ptr = file_ptr.atom(atom_index) orelse continue;
+            if (!atom_ptr.alive) continue;
+            try section_atoms[atom_ptr.output_section_index].append(arena, .{
+                .address = @intCast(atom_ptr.address(self)),
+                .size = atom_ptr.size,
+                .alignment = atom_ptr.alignment.toByteUnits() orelse 0,
+                .input = input,
+                .name = atom_ptr.name(self),
+                .symbols = if (atom_symbols.get(atom_ptr.ref())) |list| list.items else &.{},
+            });
+        }
+    }
+
+    for (self.merge_sections.items) |msec| {
+        if (msec.size == 0) continue;
+        try section_atoms[msec.output_section_index].append(arena, .{
+            .address = @intCast(msec.address(self)),
+            .size = msec.size,
+            .alignment = msec.alignment.toByteUnits() orelse 0,
+            .input = null,
+            .name = msec.name(self),
+        });
+    }
+
+    for (self.thunks.items) |th| {
+        try section_atoms[th.output_section_index].append(arena, .{
+            .address = @intCast(th.address(self)),
+            .size = th.size(self),
+            .alignment = 1,
+            .input = null,
+            .name = "thunk",
+        });
+    }
+
+    var map: MapFile = .{};
+    for (slice.items(.shdr), section_atoms) |shdr, atoms| {
+        if (shdr.sh_type == elf.SHT_NULL) continue;
+        try map.sections.append(arena, .{
+            .name = self.getShString(shdr.sh_name),
+            .address = shdr.sh_addr,
+            .size = shdr.sh_size,
+            .alignment = shdr.sh_addralign,
+            .alloc = shdr.sh_flags & elf.SHF_ALLOC != 0,
+            .atoms = atoms.items,
+        });
+    }
+
+    try map.writeToFile(sub_path);
+}
+
+fn addMapSymbol(
+    self: *Elf,
+    arena: Allocator,
+    atom_symbols: *std.AutoHashMapUnmanaged(Ref, std.ArrayListUnmanaged(MapFile.Symbol)),
+    sym: Symbol,
+    zcu: ?*Zcu,
+    nav_index: ?InternPool.Nav.Index,
+) !void {
+    const atom_ptr = sym.atom(self) orelse return;
+    if (!atom_ptr.alive) return;
+    const esym = sym.elfSym(self);
+    switch (esym.st_type()) {
+        elf.STT_SECTION, elf.STT_FILE => return,
+        else => {},
+    }
+    const name = sym.name(self);
+    if (name.len == 0) return;
+
+    var map_sym: MapFile.Symbol = .{
+        .name = name,
+        .address = @intCast(sym.address(.{ .plt = false, .trampoline = false }, self)),
+        .size = esym.st_size,
+    };
+    if (nav_index) |nav| {
+        const src = try MapFile.navSource(arena, zcu.?, nav);
+        map_sym.source = src.source;
+        map_sym.generic_owner = src.generic_owner;
+    }
+
+    const gop = try atom_symbols.getOrPut(arena, atom_ptr.ref());
+    if (!gop.found_existing) gop.value_ptr.* = .empty;
+    try gop.value_ptr.append(arena, map_sym);
+}
+
 /// Caller owns the memory.
 pub fn preadAllAlloc(allocator: Allocator, handle: fs.File, offset: u64, size: u64) ![]u8 {
     const buffer = try allocator.alloc(u8, math.cast(usize, size) orelse return error.Overflow);
@@ -4469,6 +4672,7 @@ const math = std.math;
 const mem = std.mem;
 const Allocator = std.mem.Allocator;
 const Hash = std.hash.Wyhash;
+const WaitGroup = std.Thread.WaitGroup;
 const Path = std.Build.Cache.Path;
 const Stat = std.Build.Cache.File.Stat;
 
@@ -4484,6 +4688,7 @@ const target_util = @import("../target.zig");
 const trace = @import("../tracy.zig").trace;
 const synthetic_sections = @import("Elf/synthetic_sections.zig");
 
+const MapFile = @import("MapFile.zig");
 const Merge = @import("Elf/Merge.zig");
 const Archive = @import("Elf/Archive.zig");
 const AtomList = @import("Elf/AtomList.zig");
@@ -16,12 +16,16 @@ pub const Section = struct {
     ) = .{},
     subsections: std.ArrayListUnmanaged(Subsection) = .empty,
     finalized_subsections: std.ArrayListUnmanaged(Subsection.Index) = .empty,
+    /// Subsections that do not occupy space of their own because they are a suffix
+    /// of another subsection. See `Subsection.tail_of`.
+    tail_merged_subsections: std.ArrayListUnmanaged(Subsection.Index) = .empty,
 
     pub fn deinit(msec: *Section, allocator: Allocator) void {
         msec.bytes.deinit(allocator);
         msec.table.deinit(allocator);
         msec.subsections.deinit(allocator);
         msec.finalized_subsections.deinit(allocator);
+        msec.tail_merged_subsections.deinit(allocator);
     }
 
     pub fn name(msec: Section, elf_file: *Elf) [:0]const u8 {
@@ -40,10 +44,16 @@ pub const Section = struct {
     };
 
     pub fn insert(msec: *Section, allocator: Allocator, string: []const u8) !InsertResult {
+        return msec.insertPrehashed(allocator, string, std.hash_map.hashString(string));
+    }
+
+    /// Like `insert` but with `hash` being `std.hash_map.hashString(string)` computed
+    /// ahead of time, such as when the input section was split into strings.
+    pub fn insertPrehashed(msec: *Section, allocator: Allocator, string: []const u8, hash: u64) !InsertResult {
         const gop = try msec.table.getOrPutContextAdapted(
             allocator,
             string,
-            IndexAdapter{ .bytes = msec.bytes.items },
+            PrehashedAdapter{ .bytes = msec.bytes.items, .precomputed_hash = hash },
             IndexContext{ .bytes = msec.bytes.items },
         );
         if (!gop.found_existing) {
@@ -63,8 +73,9 @@ pub const Section = struct {
     }
 
     /// Finalizes the merge section and clears hash table.
-    /// Sorts all owned subsections.
-    pub fn finalize(msec: *Section, allocator: Allocator) !void {
+    /// Sorts all owned subsections, and if `tail_merge` is set, folds strings that
+    /// are a suffix of another string into that string.
+    pub fn finalize(msec: *Section, allocator: Allocator, tail_merge: bool) !void {
         try msec.finalized_subsections.ensureTotalCapacityPrecise(allocator, msec.subsections.items.len);
 
         var it = msec.table.iterator();
@@ -92,6 +103,71 @@ pub const Section = struct {
         }.sortFn;
 
         std.mem.sort(Subsection.Index, msec.finalized_subsections.items, msec, sortFn);
+
+        if (tail_merge and msec.flags & elf.SHF_STRINGS != 0) try msec.tailMerge(allocator);
+    }
+
+    /// Marks every string that is a suffix of another string as living inside that
+    /// longer string, e.g. "bar\x00" inside "foobar\x00". Only single-byte character
+    /// strings without an alignment requirement are considered so that a suffix can
+    /// start at any offset. The order of the remaining subsections is preserved.
+    fn tailMerge(msec: *Section, allocator: Allocator) !void {
+        var candidates: std.ArrayListUnmanaged(Subsection.Index) = .empty;
+        defer candidates.deinit(allocator);
+
+        for (msec.finalized_subsections.items) |msub_index| {
+            const msub = msec.mergeSubsection(msub_index);
+            if (msub.entsize != 1 or msub.alignment != .@"1") continue;
+            try candidates.append(allocator, msub_index);
+        }
+        if (candidates.items.len < 2) return;
+
+        const sortFn = struct {
+            pub fn sortFn(ctx: *Section, lhs: Subsection.Index, rhs: Subsection.Index) bool {
+                const lhs_string = ctx.mergeSubsection(lhs).getStringInSection(ctx);
+                const rhs_string = ctx.mergeSubsection(rhs).getStringInSection(ctx);
+                return orderReversed(lhs_string, rhs_string) == .lt;
+            }
+        }.sortFn;
+
+        // Sorting by the reversed strings places every string right before the strings
+        // it is a suffix of, so walking backwards only needs to compare against the
+        // closest string that was kept.
+        std.mem.sort(Subsection.Index, candidates.items, msec, sortFn);
+
+        var parent_index = candidates.items[candidates.items.len - 1];
+        var i = candidates.items.len - 1;
+        while (i > 0) {
+            i -= 1;
+            const msub_index = candidates.items[i];
+            const msub = msec.mergeSubsection(msub_index);
+            const parent_string = msec.mergeSubsection(parent_index).getStringInSection(msec);
+            if (mem.endsWith(u8, parent_string, msub.getStringInSection(msec))) {
+                msub.tail_of = parent_index;
+            } else {
+                parent_index = msub_index;
+            }
+        }
+
+        var kept: usize = 0;
+        for (msec.finalized_subsections.items) |msub_index| {
+            if (msec.mergeSubsection(msub_index).tail_of != null) {
+                try msec.tail_merged_subsections.append(allocator, msub_index);
+                continue;
+            }
+            msec.finalized_subsections.items[kept] = msub_index;
+            kept += 1;
+        }
+        msec.finalized_subsections.shrinkRetainingCapacity(kept);
+    }
+
+    fn orderReversed(lhs: []const u8, rhs: []const u8) std.math.Order {
+        const n = @min(lhs.len, rhs.len);
+        for (1..n + 1) |i| {
+            const order = std.math.order(lhs[lhs.len - i], rhs[rhs.len - i]);
+            if (order != .eq) return order;
+        }
+        return std.math.order(lhs.len, rhs.len);
     }
 
     pub fn updateSize(msec: *Section) void {
@@ -109,6 +185,11 @@ pub const Section = struct {
             msec.alignment = msec.alignment.max(msub.alignment);
             msec.entsize = if (msec.entsize == 0) msub.entsize else @min(msec.entsize, msub.entsize);
         }
+        for (msec.tail_merged_subsections.items) |msub_index| {
+            const msub = msec.mergeSubsection(msub_index);
+            const parent = msec.mergeSubsection(msub.tail_of.?);
+            msub.value = parent.value + (parent.size - msub.size);
+        }
     }
 
     pub fn initOutputSection(msec: *Section, elf_file: *Elf) !void {
@@ -144,6 +225,20 @@ pub const Section = struct {
         }
     };
 
+    pub const PrehashedAdapter = struct {
+        bytes: []const u8,
+        precomputed_hash: u64,
+
+        pub fn eql(ctx: @This(), a: []const u8, b: String) bool {
+            const str = ctx.bytes[b.pos..][0..b.len];
+            return mem.eql(u8, a, str);
+        }
+
+        pub fn hash(ctx: @This(), _: []const u8) u64 {
+            return ctx.precomputed_hash;
+        }
+    };
+
     pub const IndexAdapter = struct {
         bytes: []const u8,
 
@@ -197,6 +292,9 @@ pub const Subsection = struct {
     alignment: Atom.Alignment = .@"1",
     entsize: u32 = 0,
     alive: bool = false,
+    /// When set, this string is a suffix of the referenced subsection and is
+    /// placed at the end of it instead of being emitted separately.
+    tail_of: ?Index = null,
 
     pub fn address(msub: Subsection, elf_file: *Elf) i64 {
         return msub.mergeSection(elf_file).address(elf_file) + msub.value;
@@ -207,7 +305,10 @@ pub const Subsection = struct {
     }
 
     pub fn getString(msub: Subsection, elf_file: *Elf) []const u8 {
-        const msec = msub.mergeSection(elf_file);
+        return msub.getStringInSection(msub.mergeSection(elf_file));
+    }
+
+    fn getStringInSection(msub: Subsection, msec: *const Section) []const u8 {
         return msec.bytes.items[msub.string_index..][0..msub.size];
     }
 
@@ -231,6 +332,7 @@ pub const Subsection = struct {
                 msub.size,
             });
             if (!msub.alive) try writer.writeAll(" : [*]");
+            if (msub.tail_of) |parent| try writer.print(" : tail of {d}", .{parent});
         }
     };
 
@@ -244,16 +346,21 @@ pub const InputSection = struct {
     subsections: std.ArrayListUnmanaged(Subsection.Index) = .empty,
     bytes: std.ArrayListUnmanaged(u8) = .empty,
     strings: std.ArrayListUnmanaged(String) = .empty,
+    /// `std.hash_map.hashString` of each entry in `strings`, computed while splitting
+    /// the section so that interning into the merge section does not rehash the bytes.
+    hashes: std.ArrayListUnmanaged(u64) = .empty,
 
     pub fn deinit(imsec: *InputSection, allocator: Allocator) void {
         imsec.offsets.deinit(allocator);
         imsec.subsections.deinit(allocator);
         imsec.bytes.deinit(allocator);
         imsec.strings.deinit(allocator);
+        imsec.hashes.deinit(allocator);
     }
 
     pub fn clearAndFree(imsec: *InputSection, allocator: Allocator) void {
         imsec.bytes.clearAndFree(allocator);
+        imsec.hashes.clearAndFree(allocator);
         // TODO: imsec.strings.clearAndFree(allocator);
     }
 
@@ -284,6 +391,7 @@ pub const InputSection = struct {
         const index: u32 = @intCast(imsec.bytes.items.len);
         try imsec.bytes.appendSlice(allocator, string);
         try imsec.strings.append(allocator, .{ .pos = index, .len = @intCast(string.len) });
+        try imsec.hashes.append(allocator, std.hash_map.hashString(string));
     }
 
     pub const Index = u32;
@@ -292,6 +400,7 @@ pub const InputSection = struct {
 const String = struct { pos: u32, len: u32 };
 
 const assert = std.debug.assert;
+const elf = std.elf;
 const mem = std.mem;
 const std = @import("std");
 
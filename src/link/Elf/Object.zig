@@ -840,17 +840,20 @@ pub fn initOutputMergeSections(self: *Object, elf_file: *Elf) !void {
     }
 }
 
-pub fn resolveMergeSubsections(self: *Object, elf_file: *Elf) error{
-    LinkFailure,
+/// Interns the strings of all input merge sections of this object that belong to
+/// the merge section `msec_index`. Input merge sections targeting other merge
+/// sections are left untouched so that different merge sections may be processed
+/// concurrently.
+pub fn internMergeStrings(self: *Object, elf_file: *Elf, msec_index: Merge.Section.Index) error{
     OutOfMemory,
     /// TODO report the error and remove this
     Overflow,
 }!void {
     const gpa = elf_file.base.comp.gpa;
-    const diags = &elf_file.base.comp.link_diags;
 
     for (self.input_merge_sections_indexes.items) |index| {
         const imsec = self.inputMergeSection(index) orelse continue;
+        if (imsec.merge_section_index != msec_index) continue;
         if (imsec.offsets.items.len == 0) continue;
         const msec = elf_file.mergeSection(imsec.merge_section_index);
         const atom_ptr = self.atom(imsec.atom_index).?;
@@ -858,9 +861,9 @@ pub fn resolveMergeSubsections(self: *Object, elf_file: *Elf) error{
 
         try imsec.subsections.resize(gpa, imsec.strings.items.len);
 
-        for (imsec.strings.items, imsec.subsections.items) |str, *imsec_msub| {
+        for (imsec.strings.items, imsec.hashes.items, imsec.subsections.items) |str, hash, *imsec_msub| {
             const string = imsec.bytes.items[str.pos..][0..str.len];
-            const res = try msec.insert(gpa, string);
+            const res = try msec.insertPrehashed(gpa, string, hash);
             if (res.found_existing) {
                 const msub = msec.mergeSubsection(res.sub.*);
                 msub.alignment = msub.alignment.maxStrict(atom_ptr.alignment);
@@ -880,6 +883,14 @@ pub fn resolveMergeSubsections(self: *Object, elf_file: *Elf) error{
 
         imsec.clearAndFree(gpa);
     }
+}
+
+pub fn resolveMergeSubsections(self: *Object, elf_file: *Elf) error{
+    LinkFailure,
+    OutOfMemory,
+}!void {
+    const gpa = elf_file.base.comp.gpa;
+    const diags = &elf_file.base.comp.link_diags;
 
     for (self.symtab.items, 0..) |*esym, idx| {
         const sym = &self.symbols.items[idx];
@@ -1217,7 +1228,7 @@ pub fn codeDecompressAlloc(self: *Object, elf_file: *Elf, atom_index: Atom.Index
     return data;
 }
 
-fn locals(self: *Object) []Symbol {
+pub fn locals(self: *Object) []Symbol {
     if (self.symbols.items.len == 0) return &[0]Symbol{};
     assert(self.symbols.items.len >= self.symtab.items.len);
     const end = self.first_global orelse self.symtab.items.len;
@@ -232,6 +232,7 @@ pub fn createEmpty(
             .zcu_object_basename = try allocPrint(arena, "{s}_zcu.{s}", .{ fs.path.stem(emit.sub_path), obj_file_ext }),
             .gc_sections = gc_sections,
             .print_gc_sections = options.print_gc_sections,
+            .map_file = options.map_file,
             .stack_size = stack_size,
             .allow_shlib_undefined = options.allow_shlib_undefined orelse false,
             .file = null,
@@ -961,6 +962,10 @@ fn elfLink(lld: *Lld, arena: Allocator) !void {
             try argv.append("--print-map");
         }
 
+        if (base.map_file) |map_file| {
+            try argv.append(try std.fmt.allocPrint(arena, "-Map={s}", .{map_file}));
+        }
+
         if (comp.link_eh_frame_hdr) {
             try argv.append("--eh-frame-hdr");
         }
@@ -1453,6 +1458,10 @@ fn wasmLink(lld: *Lld, arena: Allocator) !void {
             try argv.append("--no-gc-sections");
         }
 
+        if (base.map_file) |map_file| {
+            try argv.append(try std.fmt.allocPrint(arena, "-Map={s}", .{map_file}));
+        }
+
         if (comp.config.debug_format == .strip) {
             try argv.append("-s");
         }
@@ -187,6 +187,7 @@ pub fn createEmpty(
                 null,
             .gc_sections = options.gc_sections orelse (optimize_mode != .Debug),
             .print_gc_sections = options.print_gc_sections,
+            .map_file = options.map_file,
             .stack_size = options.stack_size orelse 16777216,
             .allow_shlib_undefined = allow_shlib_undefined,
             .file = null,
@@ -616,6 +617,115 @@ pub fn flush(
             else => |e| return diags.fail("failed to invalidate kernel cache: {s}", .{@errorName(e)}),
         };
     }
+
+    if (self.base.map_file) |map_file| self.writeMapFile(arena, map_file) catch |err| switch (err) {
+        error.OutOfMemory => return error.OutOfMemory,
+        else => |e| return diags.fail("failed to write map file '{s}': {s}", .{ map_file, @errorName(e) }),
+    };
+}
+
+/// Writes the linker map requested with `-Map`. All addresses must have been allocated.
+fn writeMapFile(self: *MachO, arena: Allocator, sub_path: []const u8) !void {
+    const zcu = self.base.comp.zcu;
+
+    var files: std.ArrayListUnmanaged(File.Index) = .empty;
+    if (self.zig_object) |index| try files.append(arena, index);
+    try files.appendSlice(arena, self.objects.items);
+    if (self.internal_object) |index| try files.append(arena, index);
+
+    var symbol_navs: std.AutoHashMapUnmanaged(Symbol.Index, InternPool.Nav.Index) = .empty;
+    if (self.getZigObject()) |zo| {
+        for (zo.navs.keys(), zo.navs.values()) |nav_index, metadata| {
+            try symbol_navs.put(arena, metadata.symbol_index, nav_index);
+        }
+    }
+
+    // Attribute every live symbol to the atom defining it.
+    var atom_symbols: std.AutoHashMapUnmanaged(Ref, std.ArrayListUnmanaged(MapFile.Symbol)) = .empty;
+    for (files.items) |index| {
+        const file = self.getFile(index).?;
+        for (file.getSymbols(), 0..) |sym, i| {
+            const owner = file.getSymbolRef(@intCast(i), self).getFile(self) orelse continue;
+            if (owner.getIndex() != index) continue;
+            if (sym.isSymbolStab(self)) continue;
+            const atom = sym.getAtom(self) orelse continue;
+            if (!atom.isAlive()) continue;
+            const name = sym.getName(self);
+            if (name.len == 0) continue;
+
+            var map_sym: MapFile.Symbol = .{
+                .name = name,
+                .address = sym.getAddress(.{ .stubs = false, .trampoline = false }, self),
+                // Mach-O symbols carry no size; it is inferred below.
+                .size = 0,
+            };
+            if (file == .zig_object) if (symbol_navs.get(@intCast(i))) |nav_index| {
+                const src = try MapFile.navSource(arena, zcu.?, nav_index);
+                map_sym.source = src.source;
+                map_sym.generic_owner = src.generic_owner;
+            };
+
+            const gop = try atom_symbols.getOrPut(arena, sym.atom_ref);
+            if (!gop.found_existing) gop.value_ptr.* = .empty;
+            try gop.value_ptr.append(arena, map_sym);
+        }
+    }
+
+    const slice = self.sections.slice();
+    const section_atoms = try arena.alloc(std.ArrayListUnmanaged(MapFile.Atom), slice.len);
+    @memset(section_atoms, .empty);
+
+    for (files.items) |index| {
+        const file = self.getFile(index).?;
+        const input: ?[]const u8 = if (file == .internal) null else try std.fmt.allocPrint(arena, "{f}", .{file.fmtPath()});
+        for (file.getAtoms()) |atom_index| {
+            const atom = file.getAtom(atom_index) orelse continue;
+            if (!atom.isAlive()) continue;
+            const address = atom.getAddress(self);
+            const symbols: []MapFile.Symbol = if (atom_symbols.get(.{ .index = atom_index, .file = index })) |list| list.items else &.{};
+            mem.sort(MapFile.Symbol, symbols, {}, MapFile.lessThanSymbol);
+            for (symbols, 0..) |*map_sym, i| {
+                const end = if (i + 1 < symbols.len) symbols[i + 1].address else address + atom.size;
+                map_sym.size = end -| map_sym.address;
+            }
+            try section_atoms[atom.out_n_sect].append(arena, .{
+                .address = address,
+                .size = atom.size,
+                .alignment = atom.alignment.toByteUnits() orelse 0,
+                .input = input,
+                .name = atom.getName(self),
+                .symbols = symbols,
+            });
+        }
+    }
+
+    for (slice.items(.thunks), section_atoms) |thunks, *atoms| {
+        for (thunks.items) |thunk_index| {
+            const thunk = self.getThunk(thunk_index);
+            try atoms.append(arena, .{
+                .address = thunk.getAddress(self),
+                .size = thunk.size(),
+                .alignment = 1,
+                .input = null,
+                .name = "thunk",
+            });
+        }
+    }
+
+    var map: MapFile = .{};
+    for (slice.items(.header), section_atoms) |*header, atoms| {
+        try map.sections.append(arena, .{
+            .segment = header.segName(),
+            .name = header.sectName(),
+            .address = header.addr,
+            .size = header.size,
+            .alignment = @as(u64, 1) << @intCast(header.@"align"),
+            .alloc = !header.isDebug(),
+            .atoms = atoms.items,
+        });
+    }
+
+    try map.writeToFile(sub_path);
 }
 
 /// --verbose-link output
@@ -1942,33 +2052,35 @@ fn calcSectionSizes(self: *MachO) !void {
     }
 
     {
+        const tp = self.base.comp.thread_pool;
+        var wg: WaitGroup = .{};
+        defer tp.waitAndWork(&wg);
+
         const slice = self.sections.slice();
         for (slice.items(.header), slice.items(.atoms), 0..) |header, atoms, i| {
             if (atoms.items.len == 0) continue;
             if (self.requiresThunks() and header.isCode()) continue;
-            calcSectionSizeWorker(self, @as(u8, @intCast(i)));
+            tp.spawnWg(&wg, calcSectionSizeWorker, .{ self, @as(u8, @intCast(i)) });
         }
 
         if (self.requiresThunks()) {
-            for (slice.items(.header), slice.items(.atoms), 0..) |header, atoms, i| {
-                if (!header.isCode()) continue;
-                if (atoms.items.len == 0) continue;
-                createThunksWorker(self, @as(u8, @intCast(i)));
-            }
+            // Thunks are appended to a list shared by all code sections, so a single task
+            // creates them section by section to keep thunk indexes deterministic.
+            tp.spawnWg(&wg, createAllThunksWorker, .{self});
         }
 
         // At this point, we can also calculate most of the symtab and data-in-code linkedit section sizes
         if (self.getZigObject()) |zo| {
-            File.calcSymtabSize(zo.asFile(), self);
+            tp.spawnWg(&wg, File.calcSymtabSize, .{ zo.asFile(), self });
         }
         for (self.objects.items) |index| {
-            File.calcSymtabSize(self.getFile(index).?, self);
+            tp.spawnWg(&wg, File.calcSymtabSize, .{ self.getFile(index).?, self });
         }
         for (self.dylibs.items) |index| {
-            File.calcSymtabSize(self.getFile(index).?, self);
+            tp.spawnWg(&wg, File.calcSymtabSize, .{ self.getFile(index).?, self });
         }
         if (self.getInternalObject()) |obj| {
-            File.calcSymtabSize(obj.asFile(), self);
+            tp.spawnWg(&wg, File.calcSymtabSize, .{ obj.asFile(), self });
         }
     }
 
@@ -2050,6 +2162,15 @@ fn calcSectionSizeWorker(self: *MachO, sect_id: u8) void {
     };
 }
 
+fn createAllThunksWorker(self: *MachO) void {
+    const slice = self.sections.slice();
+    for (slice.items(.header), slice.items(.atoms), 0..) |header, atoms, i| {
+        if (!header.isCode()) continue;
+        if (atoms.items.len == 0) continue;
+        createThunksWorker(self, @as(u8, @intCast(i)));
+    }
+}
+
 fn createThunksWorker(self: *MachO, sect_id: u8) void {
     const tracy = trace(@src());
     defer tracy.end();
@@ -2453,17 +2574,23 @@ fn writeSectionsAndUpdateLinkeditSizes(self: *MachO) !void {
     self.strtab.items[0] = 0;
 
     {
+        // Every task below writes to a disjoint part of the output buffers, so the result
+        // is identical regardless of the order in which they run.
+        const tp = self.base.comp.thread_pool;
+        var wg: WaitGroup = .{};
+        defer tp.waitAndWork(&wg);
+
         for (self.objects.items) |index| {
-            writeAtomsWorker(self, self.getFile(index).?);
+            tp.spawnWg(&wg, writeAtomsWorker, .{ self, self.getFile(index).? });
         }
         if (self.getZigObject()) |zo| {
-            writeAtomsWorker(self, zo.asFile());
+            tp.spawnWg(&wg, writeAtomsWorker, .{ self, zo.asFile() });
         }
         if (self.getInternalObject()) |obj| {
-            writeAtomsWorker(self, obj.asFile());
+            tp.spawnWg(&wg, writeAtomsWorker, .{ self, obj.asFile() });
         }
         for (self.thunks.items) |thunk| {
-            writeThunkWorker(self, thunk);
+            tp.spawnWg(&wg, writeThunkWorker, .{ self, thunk });
         }
 
         const slice = self.sections.slice();
@@ -2478,34 +2605,34 @@ fn writeSectionsAndUpdateLinkeditSizes(self: *MachO) !void {
         }) |maybe_sect_id| {
             if (maybe_sect_id) |sect_id| {
                 const out = slice.items(.out)[sect_id].items;
-                writeSyntheticSectionWorker(self, sect_id, out);
+                tp.spawnWg(&wg, writeSyntheticSectionWorker, .{ self, sect_id, out });
             }
         }
 
         if (self.la_symbol_ptr_sect_index) |_| {
-            updateLazyBindSizeWorker(self);
+            tp.spawnWg(&wg, updateLazyBindSizeWorker, .{self});
         }
 
-        updateLinkeditSizeWorker(self, .rebase);
-        updateLinkeditSizeWorker(self, .bind);
-        updateLinkeditSizeWorker(self, .weak_bind);
-        updateLinkeditSizeWorker(self, .export_trie);
-        updateLinkeditSizeWorker(self, .data_in_code);
+        tp.spawnWg(&wg, updateLinkeditSizeWorker, .{ self, .rebase });
+        tp.spawnWg(&wg, updateLinkeditSizeWorker, .{ self, .bind });
+        tp.spawnWg(&wg, updateLinkeditSizeWorker, .{ self, .weak_bind });
+        tp.spawnWg(&wg, updateLinkeditSizeWorker, .{ self, .export_trie });
+        tp.spawnWg(&wg, updateLinkeditSizeWorker, .{ self, .data_in_code });
 
         if (self.getZigObject()) |zo| {
-            File.writeSymtab(zo.asFile(), self, self);
+            tp.spawnWg(&wg, File.writeSymtab, .{ zo.asFile(), self, self });
         }
         for (self.objects.items) |index| {
-            File.writeSymtab(self.getFile(index).?, self, self);
+            tp.spawnWg(&wg, File.writeSymtab, .{ self.getFile(index).?, self, self });
         }
         for (self.dylibs.items) |index| {
-            File.writeSymtab(self.getFile(index).?, self, self);
+            tp.spawnWg(&wg, File.writeSymtab, .{ self.getFile(index).?, self, self });
         }
         if (self.getInternalObject()) |obj| {
-            File.writeSymtab(obj.asFile(), self, self);
+            tp.spawnWg(&wg, File.writeSymtab, .{ obj.asFile(), self, self });
         }
         if (self.requiresThunks()) for (self.thunks.items) |th| {
-            Thunk.writeSymtab(th, self, self);
+            tp.spawnWg(&wg, Thunk.writeSymtab, .{ th, self, self });
         };
     }
 
@@ -2640,10 +2767,26 @@ fn writeSectionsToFile(self: *MachO) !void {
     const tracy = trace(@src());
     defer tracy.end();
 
-    const slice = self.sections.slice();
-    for (slice.items(.header), slice.items(.out)) |header, out| {
-        try self.pwriteAll(out.items, header.offset);
+    const comp = self.base.comp;
+    {
+        const tp = comp.thread_pool;
+        var wg: WaitGroup = .{};
+        defer tp.waitAndWork(&wg);
+
+        const slice = self.sections.slice();
+        for (slice.items(.header), slice.items(.out)) |header, out| {
+            tp.spawnWg(&wg, writeSectionToFileWorker, .{ self, out.items, header.offset });
+        }
     }
+
+    if (comp.link_diags.hasErrors()) return error.LinkFailure;
+}
+
+fn writeSectionToFileWorker(self: *MachO, bytes: []const u8, offset: u64) void {
+    const tracy = trace(@src());
+    defer tracy.end();
+    // The error has already been reported.
+    self.pwriteAll(bytes, offset) catch {};
 }
 
 fn writeLinkeditSectionsToFile(self: *MachO) !void {
@@ -5415,12 +5558,14 @@ const Path = Cache.Path;
 const File = @import("MachO/file.zig").File;
 const GotSection = synthetic.GotSection;
 const Hash = std.hash.Wyhash;
+const WaitGroup = std.Thread.WaitGroup;
 const Indsymtab = synthetic.Indsymtab;
 const InternalObject = @import("MachO/InternalObject.zig");
 const ObjcStubsSection = synthetic.ObjcStubsSection;
 const Object = @import("MachO/Object.zig");
 const LazyBind = bind.LazyBind;
 const LaSymbolPtrSection = synthetic.LaSymbolPtrSection;
+const MapFile = @import("MapFile.zig");
 const Md5 = std.crypto.hash.Md5;
 const Zcu = @import("../Zcu.zig");
 const InternPool = @import("../InternPool.zig");
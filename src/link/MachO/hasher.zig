@@ -28,7 +28,7 @@ pub fn ParallelHasher(comptime Hasher: type) type {
 
             {
                 wg.reset();
-                defer wg.wait();
+                defer self.thread_pool.wait(&wg);
 
                 for (out, results, 0..) |*out_buf, *result, i| {
                     const fstart = i * chunk_size;
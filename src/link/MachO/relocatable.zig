@@ -610,23 +610,27 @@ fn writeSections(macho_file: *MachO) link.File.FlushError!void {
     macho_file.strtab.items[0] = 0;
 
     {
+        const tp = macho_file.base.comp.thread_pool;
+        var wg: WaitGroup = .{};
+        defer tp.waitAndWork(&wg);
+
         for (macho_file.objects.items) |index| {
-            writeAtomsWorker(macho_file, macho_file.getFile(index).?);
-            File.writeSymtab(macho_file.getFile(index).?, macho_file, macho_file);
+            tp.spawnWg(&wg, writeAtomsWorker, .{ macho_file, macho_file.getFile(index).? });
+            tp.spawnWg(&wg, File.writeSymtab, .{ macho_file.getFile(index).?, macho_file, macho_file });
         }
 
         if (macho_file.getZigObject()) |zo| {
-            writeAtomsWorker(macho_file, zo.asFile());
-            File.writeSymtab(zo.asFile(), macho_file, macho_file);
+            tp.spawnWg(&wg, writeAtomsWorker, .{ macho_file, zo.asFile() });
+            tp.spawnWg(&wg, File.writeSymtab, .{ zo.asFile(), macho_file, macho_file });
         }
 
         if (macho_file.eh_frame_sect_index) |_| {
-            writeEhFrameWorker(macho_file);
+            tp.spawnWg(&wg, writeEhFrameWorker, .{macho_file});
         }
 
         if (macho_file.unwind_info_sect_index) |_| {
             for (macho_file.objects.items) |index| {
-                writeCompactUnwindWorker(macho_file, macho_file.getFile(index).?.object);
+                tp.spawnWg(&wg, writeCompactUnwindWorker, .{ macho_file, macho_file.getFile(index).?.object });
             }
         }
     }
@@ -0,0 +1,180 @@
+//! In-memory model of a linker map file: every output section, the input
+//! pieces (atoms) placed in it, and the symbols those pieces define. A linker
+//! backend populates this once all addresses have been allocated; it is then
+//! rendered either as human-readable text or, when the requested path ends in
+//! `.json`, as JSON so that code size can be diffed mechanically.
+//!
+//! All memory is owned by the arena passed to the backend's flush.
+
+sections: std.ArrayListUnmanaged(Section) = .empty,
+
+pub const Section = struct {
+    /// Segment the section belongs to, for object formats that have them.
+    segment: ?[]const u8 = null,
+    name: []const u8,
+    address: u64,
+    size: u64,
+    alignment: u64,
+    /// Whether the section occupies memory at runtime.
+    alloc: bool,
+    atoms: []Atom = &.{},
+};
+
+pub const Atom = struct {
+    address: u64,
+    size: u64,
+    alignment: u64,
+    /// Input file the atom originates from, formatted as `archive(member)` for
+    /// archive members. Linker-synthesized atoms have no input file.
+    input: ?[]const u8,
+    /// Name of the input section, or of the owning symbol for atoms that do
+    /// not correspond to an input section.
+    name: []const u8,
+    symbols: []Symbol = &.{},
+};
+
+pub const Symbol = struct {
+    name: []const u8,
+    address: u64,
+    size: u64,
+    /// Zig source file the symbol was generated from.
+    source: ?[]const u8 = null,
+    /// Fully qualified name of the generic function this symbol is an
+    /// instantiation of.
+    generic_owner: ?[]const u8 = null,
+};
+
+/// Source attribution for a symbol generated from a Zig `Nav`.
+pub fn navSource(
+    arena: Allocator,
+    zcu: *Zcu,
+    nav_index: InternPool.Nav.Index,
+) Allocator.Error!struct { source: ?[]const u8, generic_owner: ?[]const u8 } {
+    const ip = &zcu.intern_pool;
+    const nav = ip.getNav(nav_index);
+
+    const source: ?[]const u8 = if (nav.srcInst(ip).resolveFull(ip)) |inst_info|
+        try std.fmt.allocPrint(arena, "{f}", .{zcu.fileByIndex(inst_info.file).path.fmt(zcu.comp)})
+    else
+        null;
+
+    const generic_owner: ?[]const u8 = switch (nav.status) {
+        .fully_resolved => |r| switch (ip.indexToKey(r.val)) {
+            .func => |func| if (func.generic_owner != .none) go: {
+                const go_nav = ip.getNav(ip.indexToKey(func.generic_owner).func.owner_nav);
+                break :go try arena.dupe(u8, go_nav.fqn.toSlice(ip));
+            } else null,
+            else => null,
+        },
+        else => null,
+    };
+
+    return .{ .source = source, .generic_owner = generic_owner };
+}
+
+fn lessThanAtom(_: void, lhs: Atom, rhs: Atom) bool {
+    return lhs.address < rhs.address;
+}
+
+pub fn lessThanSymbol(_: void, lhs: Symbol, rhs: Symbol) bool {
+    if (lhs.address == rhs.address) return mem.order(u8, lhs.name, rhs.name) == .lt;
+    return lhs.address < rhs.address;
+}
+
+/// Sorts atoms and symbols by address so that the output is stable regardless
+/// of the order in which input files were processed.
+pub fn sort(map: *MapFile) void {
+    for (map.sections.items) |sect| {
+        mem.sort(Atom, sect.atoms, {}, lessThanAtom);
+        for (sect.atoms) |atom| mem.sort(Symbol, atom.symbols, {}, lessThanSymbol);
+    }
+}
+
+/// Writes the map to `sub_path`, relative to the current working directory.
+/// The JSON variant is selected by a `.json` extension.
+pub fn writeToFile(map: *MapFile, sub_path: []const u8) !void {
+    map.sort();
+
+    const file = try fs.cwd().createFile(sub_path, .{});
+    defer file.close();
+
+    var buffer: [4096]u8 = undefined;
+    var file_writer = file.writer(&buffer);
+    const w = &file_writer.interface;
+
+    const json = mem.eql(u8, fs.path.extension(sub_path), ".json");
+    (if (json) map.writeJson(w) else map.writeText(w)) catch |err| switch (err) {
+        error.WriteFailed => return file_writer.err.?,
+    };
+    w.flush() catch |err| switch (err) {
+        error.WriteFailed => return file_writer.err.?,
+    };
+}
+
+pub fn writeJson(map: MapFile, w: *Writer) Writer.Error!void {
+    try std.json.Stringify.value(.{
+        .sections = map.sections.items,
+    }, .{
+        .whitespace = .indent_1,
+        .emit_null_optional_fields = false,
+    }, w);
+    try w.writeByte('\n');
+}
+
+pub fn writeText(map: MapFile, w: *Writer) Writer.Error!void {
+    var total_alloc_size: u64 = 0;
+    for (map.sections.items) |sect| {
+        if (sect.alloc) total_alloc_size += sect.size;
+    }
+
+    // A coarse heatmap first: where do the runtime bytes go?
+    try w.writeAll("Allocated sections by size\n");
+    try w.print("{s:>16} {s:>7}  Section\n", .{ "Size", "Share" });
+    for (map.sections.items) |sect| {
+        if (!sect.alloc or sect.size == 0) continue;
+        const permille = sect.size * 1000 / @max(total_alloc_size, 1);
+        try w.print("{x:>16} {d:>3}.{d}%  ", .{ sect.size, permille / 10, permille % 10 });
+        try writeSectionName(w, sect);
+        try w.writeByte(' ');
+        try w.splatByteAll('#', @intCast((permille + 24) / 25));
+        try w.writeByte('\n');
+    }
+    try w.print("{x:>16} {s:>7}  (total)\n\n", .{ total_alloc_size, "100.0%" });
+
+    try w.print("{s:>16} {s:>16} {s:>5} Out     In      Symbol\n", .{ "VMA", "Size", "Align" });
+    for (map.sections.items) |sect| {
+        try w.print("{x:>16} {x:>16} {d:>5} ", .{ sect.address, sect.size, sect.alignment });
+        try writeSectionName(w, sect);
+        try w.writeByte('\n');
+        for (sect.atoms) |atom| {
+            try w.print("{x:>16} {x:>16} {d:>5}         ", .{ atom.address, atom.size, atom.alignment });
+            if (atom.input) |input| {
+                try w.print("{s}:({s})\n", .{ input, atom.name });
+            } else {
+                try w.print("<internal>:({s})\n", .{atom.name});
+            }
+            for (atom.symbols) |sym| {
+                try w.print("{x:>16} {x:>16} {s:>5}                 {s}", .{ sym.address, sym.size, "", sym.name });
+                if (sym.generic_owner) |generic_owner| try w.print(" [instance of {s}]", .{generic_owner});
+                if (sym.source) |source| try w.print(" ({s})", .{source});
+                try w.writeByte('\n');
+            }
+        }
+    }
+}
+
+fn writeSectionName(w: *Writer, sect: Section) Writer.Error!void {
+    if (sect.segment) |segment| try w.print("{s},", .{segment});
+    try w.writeAll(sect.name);
+}
+
+const MapFile = @This();
+
+const std = @import("std");
+const fs = std.fs;
+const mem = std.mem;
+
+const Allocator = mem.Allocator;
+const InternPool = @import("../InternPool.zig");
+const Writer = std.Io.Writer;
+const Zcu = @import("../Zcu.zig");
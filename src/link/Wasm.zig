@@ -2958,6 +2958,7 @@ pub fn createEmpty(
             // symbols.
             .gc_sections = options.gc_sections orelse (output_mode != .Obj),
             .print_gc_sections = options.print_gc_sections,
+            .map_file = options.map_file,
             .stack_size = options.stack_size orelse switch (target.os.tag) {
                 .freestanding => 1 * 1024 * 1024, // 1 MiB
                 else => 16 * 1024 * 1024, // 16 MiB
@@ -833,6 +833,18 @@ pub fn finish(f: *Flush, wasm: *Wasm) !void {
     if (wasm.functions.count() != 0) {
         const header_offset = try reserveVecSectionHeader(gpa, binary_bytes);
 
+        // Function bodies from input objects make up most of the code section and
+        // their sizes are known up front, so grow the buffer for all of them at once.
+        var object_code_size: usize = 0;
+        for (wasm.functions.keys()) |resolution| switch (resolution.unpack(wasm)) {
+            .object_function => |i| object_code_size += max_size_encoding + i.ptr(wasm).code.len,
+            else => {},
+        };
+        try binary_bytes.ensureUnusedCapacity(gpa, object_code_size);
+
+        var object_bodies: ArrayList(ObjectFunctionBody) = .empty;
+        defer object_bodies.deinit(gpa);
+
         for (wasm.functions.keys()) |resolution| switch (resolution.unpack(wasm)) {
             .unresolved => unreachable,
             .__wasm_apply_global_tls_relocs => @panic("TODO lower __wasm_apply_global_tls_relocs"),
@@ -852,12 +864,11 @@ pub fn finish(f: *Flush, wasm: *Wasm) !void {
                 try emitInitTlsFunction(wasm, binary_bytes);
             },
             .object_function => |i| {
-                const ptr = i.ptr(wasm);
-                const code = ptr.code.slice(wasm);
+                const code = i.ptr(wasm).code.slice(wasm);
                 try appendLeb128(gpa, binary_bytes, code.len);
-                const code_start = binary_bytes.items.len;
-                try binary_bytes.appendSlice(gpa, code);
-                if (!is_obj) applyRelocs(binary_bytes.items[code_start..], ptr.offset, ptr.relocations(wasm), wasm);
+                // The body is copied and relocated by `writeObjectFunctionBodies` below.
+                try object_bodies.append(gpa, .{ .function = i, .offset = @intCast(binary_bytes.items.len) });
+                _ = try binary_bytes.addManyAsSlice(gpa, code.len);
             },
             .zcu_func => |i| {
                 const code_start = try reserveSize(gpa, binary_bytes);
@@ -891,6 +902,9 @@ pub fn finish(f: *Flush, wasm: *Wasm) !void {
             },
         };
 
+        // Must happen before the section header is written, which moves the section contents.
+        writeObjectFunctionBodies(wasm, binary_bytes.items, object_bodies.items, is_obj);
+
         replaceVecSectionHeader(binary_bytes, header_offset, .code, @intCast(wasm.functions.entries.len));
         code_section_index = section_index;
         section_index += 1;
@@ -1448,6 +1462,43 @@ fn emitTagNameTable(
     }
 }
 
+const ObjectFunctionBody = struct {
+    function: Wasm.ObjectFunctionIndex,
+    /// Where the body goes in the output, after its size prefix.
+    offset: u32,
+};
+
+/// Copies function bodies from input objects into the space reserved for them
+/// in `bytes` and applies their relocations. Bodies never overlap, so batches of
+/// them are processed on the thread pool.
+fn writeObjectFunctionBodies(wasm: *const Wasm, bytes: []u8, bodies: []const ObjectFunctionBody, is_obj: bool) void {
+    const batch_size_min = 64 * 1024;
+
+    const tp = wasm.base.comp.thread_pool;
+    var wg: std.Thread.WaitGroup = .{};
+    defer tp.waitAndWork(&wg);
+
+    var batch_start: usize = 0;
+    var batch_size: usize = 0;
+    for (bodies, 0..) |body, i| {
+        batch_size += body.function.ptr(wasm).code.len;
+        if (batch_size < batch_size_min and i + 1 < bodies.len) continue;
+        tp.spawnWg(&wg, writeObjectFunctionBodiesWorker, .{ wasm, bytes, bodies[batch_start .. i + 1], is_obj });
+        batch_start = i + 1;
+        batch_size = 0;
+    }
+}
+
+fn writeObjectFunctionBodiesWorker(wasm: *const Wasm, bytes: []u8, bodies: []const ObjectFunctionBody, is_obj: bool) void {
+    for (bodies) |body| {
+        const ptr = body.function.ptr(wasm);
+        const code = ptr.code.slice(wasm);
+        const dest = bytes[body.offset..][0..code.len];
+        @memcpy(dest, code);
+        if (!is_obj) applyRelocs(dest, ptr.offset, ptr.relocations(wasm), wasm);
+    }
+}
+
 fn applyRelocs(code: []u8, code_offset: u32, relocs: Wasm.ObjectRelocation.IterableSlice, wasm: *const Wasm) void {
     for (
         relocs.slice.tags(wasm),
@@ -196,14 +196,47 @@ pub fn main() anyerror!void {
 
     if (tracy.enable_allocation) {
         var gpa_tracy = tracy.tracyAllocator(gpa);
-        return mainArgs(gpa_tracy.allocator(), arena, args);
+        return mainArgsAndContinuations(gpa_tracy.allocator(), arena, args);
     }
 
     if (native_os == .wasi) {
         wasi_preopens = try fs.wasi.preopensAlloc(arena);
     }
 
-    return mainArgs(gpa, arena, args);
+    return mainArgsAndContinuations(gpa, arena, args);
+}
+
+/// Set by `serve` when the client sends a `compile` message. The current
+/// compilation is torn down by returning all the way to
+/// `mainArgsAndContinuations`, which then starts the requested one.
+/// Allocated with the general purpose allocator.
+var next_compilation_args: ?[]u8 = null;
+/// `std.Progress` can only be started once per process, so a compiler server
+/// keeps its root node across compilations.
+var serve_progress_node: ?std.Progress.Node = null;
+/// Whether the LLVM assembly syntax option has been parsed, which may only
+/// happen once per process.
+var llvm_asm_syntax_set = false;
+
+fn mainArgsAndContinuations(gpa: Allocator, arena: Allocator, args: []const []const u8) !void {
+    try mainArgs(gpa, arena, args);
+    while (next_compilation_args) |args_bytes| {
+        next_compilation_args = null;
+        defer gpa.free(args_bytes);
+
+        var next_arena_instance = std.heap.ArenaAllocator.init(gpa);
+        defer next_arena_instance.deinit();
+        const next_arena = next_arena_instance.allocator();
+
+        // The previous compilation's `--debug-log` scopes were allocated in its arena.
+        log_scopes = .empty;
+
+        var next_args: std.ArrayListUnmanaged([]const u8) = .empty;
+        try next_args.append(next_arena, args[0]);
+        var it = mem.splitScalar(u8, args_bytes, 0);
+        while (it.next()) |arg| try next_args.append(next_arena, arg);
+        try mainArgs(gpa, next_arena, next_args.items);
+    }
 }
 
 fn mainArgs(gpa: Allocator, arena: Allocator, args: []const []const u8) !void {
@@ -468,6 +501,8 @@ const usage_build_generic =
     \\  -fno-function-sections    All functions go into same section
     \\  -fdata-sections           Places each data in a separate section
     \\  -fno-data-sections        All data go into same section
+    \\  -gsplit-dwarf             (ELF) Emit DWARF for C objects into separate .dwo files
+    \\  -gno-split-dwarf          (ELF) Keep all DWARF for C objects in the object files
     \\  -fformatted-panics        Enable formatted safety panics
     \\  -fno-formatted-panics     Disable formatted safety panics
     \\  -fstructured-cfg          (SPIR-V) force SPIR-V kernels to use structured control flow
@@ -553,6 +588,7 @@ const usage_build_generic =
     \\Global Link Options:
     \\  -T[script], --script [script]  Use a custom linker script
     \\  --version-script [path]        Provide a version .map file
+    \\  -Map [path]                    Write a linker map file (JSON if [path] ends in .json)
     \\  --undefined-version            Allow version scripts to refer to undefined symbols
     \\  --no-undefined-version         (default) Disallow version scripts from referring to undefined symbols
     \\  --enable-new-dtags             Use the new behavior for dynamic tags (RUNPATH)
@@ -812,6 +848,7 @@ fn buildOutputType(
     var compatibility_version: ?std.SemanticVersion = null;
     var function_sections = false;
     var data_sections = false;
+    var split_dwarf = false;
     var listen: Listen = .none;
     var debug_compile_errors = false;
     var debug_incremental = false;
@@ -863,6 +900,7 @@ fn buildOutputType(
     var linker_print_gc_sections: bool = false;
     var linker_print_icf_sections: bool = false;
     var linker_print_map: bool = false;
+    var linker_map_file: ?[]const u8 = null;
     var llvm_opt_bisect_limit: c_int = -1;
     var linker_z_nocopyreloc = false;
     var linker_z_nodelete = false;
@@ -1212,6 +1250,8 @@ fn buildOutputType(
                         linker_script = args_iter.nextOrFatal();
                     } else if (mem.eql(u8, arg, "-version-script") or mem.eql(u8, arg, "--version-script")) {
                         version_script = args_iter.nextOrFatal();
+                    } else if (mem.eql(u8, arg, "-Map") or mem.eql(u8, arg, "--Map")) {
+                        linker_map_file = args_iter.nextOrFatal();
                     } else if (mem.eql(u8, arg, "--undefined-version")) {
                         linker_allow_undefined_version = true;
                     } else if (mem.eql(u8, arg, "--no-undefined-version")) {
@@ -1565,6 +1605,10 @@ fn buildOutputType(
                         create_module.opts.debug_format = .{ .dwarf = .@"32" };
                     } else if (mem.eql(u8, arg, "-gdwarf64")) {
                         create_module.opts.debug_format = .{ .dwarf = .@"64" };
+                    } else if (mem.eql(u8, arg, "-gsplit-dwarf")) {
+                        split_dwarf = true;
+                    } else if (mem.eql(u8, arg, "-gno-split-dwarf")) {
+                        split_dwarf = false;
                     } else if (mem.eql(u8, arg, "-fformatted-panics")) {
                         // Remove this after 0.15.0 is tagged.
                         warn("-fformatted-panics is deprecated and does nothing", .{});
@@ -2475,6 +2519,8 @@ fn buildOutputType(
                     linker_print_icf_sections = true;
                 } else if (mem.eql(u8, arg, "--print-map")) {
                     linker_print_map = true;
+                } else if (mem.eql(u8, arg, "-Map") or mem.eql(u8, arg, "--Map")) {
+                    linker_map_file = linker_args_it.nextOrFatal();
                 } else if (mem.eql(u8, arg, "--sort-section")) {
                     const arg1 = linker_args_it.nextOrFatal();
                     linker_sort_section = std.meta.stringToEnum(link.File.Lld.Elf.SortSection, arg1) orelse {
@@ -3291,12 +3337,16 @@ fn buildOutputType(
         },
     };
 
+    var jobserver = try initJobserver(arena);
+    defer if (jobserver) |*js| js.deinit();
+
     var thread_pool: ThreadPool = undefined;
     try thread_pool.init(.{
         .allocator = gpa,
         .n_jobs = @min(@max(n_jobs orelse std.Thread.getCpuCount() catch 1, 1), std.math.maxInt(Zcu.PerThread.IdBacking)),
         .track_ids = true,
         .stack_size = thread_stack_size,
+        .jobserver = if (jobserver) |*js| js else null,
     });
     defer thread_pool.deinit();
 
@@ -3347,10 +3397,12 @@ fn buildOutputType(
         src.src_path = try dirs.local_cache.join(arena, &.{sub_path});
     }
 
-    if (build_options.have_llvm and emit_asm_resolved != .no) {
-        // LLVM has no way to set this non-globally.
+    if (build_options.have_llvm and emit_asm_resolved != .no and !llvm_asm_syntax_set) {
+        // LLVM has no way to set this non-globally, and rejects options which are
+        // given more than once per process.
         const argv = [_][*:0]const u8{ "zig (LLVM option parsing)", "--x86-asm-syntax=intel" };
         @import("codegen/llvm/bindings.zig").ParseCommandLineOptions(argv.len, &argv);
+        llvm_asm_syntax_set = true;
     }
 
     const clang_passthrough_mode = switch (arg_mode) {
@@ -3384,10 +3436,20 @@ fn buildOutputType(
     create_module.rpath_list.clearRetainingCapacity();
     try create_module.rpath_list.appendSlice(arena, rpath_dedup.keys());
 
+    var remote_cache_client: std.http.Client = .{ .allocator = gpa, .io = io };
+    defer remote_cache_client.deinit();
+    var remote_cache: Cache.Remote = undefined;
+    const remote_cache_url = try EnvVar.ZIG_REMOTE_CACHE.get(arena);
+    if (remote_cache_url) |url| remote_cache = .{
+        .client = &remote_cache_client,
+        .url = mem.trimEnd(u8, url, "/"),
+    };
+
     var create_diag: Compilation.CreateDiagnostic = undefined;
     const comp = Compilation.create(gpa, arena, io, &create_diag, .{
         .dirs = dirs,
         .thread_pool = &thread_pool,
+        .remote_cache = if (remote_cache_url != null) &remote_cache else null,
         .self_exe_path = switch (native_os) {
             .wasi => null,
             else => self_exe_path,
@@ -3439,6 +3501,7 @@ fn buildOutputType(
         .linker_print_gc_sections = linker_print_gc_sections,
         .linker_print_icf_sections = linker_print_icf_sections,
         .linker_print_map = linker_print_map,
+        .linker_map_file = linker_map_file,
         .llvm_opt_bisect_limit = llvm_opt_bisect_limit,
         .linker_global_base = linker_global_base,
         .linker_export_symbol_names = linker_export_symbol_names.items,
@@ -3466,6 +3529,7 @@ fn buildOutputType(
         .image_base = image_base,
         .function_sections = function_sections,
         .data_sections = data_sections,
+        .split_dwarf = split_dwarf,
         .clang_passthrough_mode = clang_passthrough_mode,
         .clang_preprocessor_mode = clang_preprocessor_mode,
         .version = optional_version,
@@ -3572,6 +3636,8 @@ fn buildOutputType(
                 all_args,
                 runtime_args_start,
             );
+            // Tear down this compilation so that the next one can start.
+            if (next_compilation_args != null) return;
             return cleanExit();
         },
         .ip4 => |ip4_addr| {
@@ -3598,6 +3664,7 @@ fn buildOutputType(
                 all_args,
                 runtime_args_start,
             );
+            if (next_compilation_args != null) fatal("compile messages are only supported when listening on stdio", .{});
             return cleanExit();
         },
     }
@@ -4084,7 +4151,10 @@ fn serve(
 
     var child_pid: ?std.process.Child.Id = null;
 
-    const main_progress_node = std.Progress.start(.{});
+    // A compilation started by a `compile` message is updated right away.
+    var update_requested = serve_progress_node != null;
+    const main_progress_node = serve_progress_node orelse std.Progress.start(.{});
+    serve_progress_node = main_progress_node;
     const file_system_inputs = comp.file_system_inputs.?;
 
     const IncrementalDebugServer = if (build_options.enable_debug_extensions and !builtin.single_threaded)
@@ -4100,7 +4170,11 @@ fn serve(
     if (comp.debugIncremental()) ids.spawn();
 
     while (true) {
-        const hdr = try server.receiveMessage();
+        const hdr: std.zig.Client.Message.Header = if (update_requested)
+            .{ .tag = .update, .bytes_len = 0 }
+        else
+            try server.receiveMessage();
+        update_requested = false;
 
         // Lock the debug server while handling the message.
         if (comp.debugIncremental()) ids.mutex.lock();
@@ -4190,6 +4264,15 @@ fn serve(
                     );
                 }
             },
+            .compile => {
+                const args_bytes = try in.readAlloc(gpa, hdr.bytes_len);
+                const cmd = args_bytes[0 .. mem.indexOfScalar(u8, args_bytes, 0) orelse args_bytes.len];
+                for ([_][]const u8{ "build-exe", "build-lib", "build-obj", "test", "test-obj" }) |supported_cmd| {
+                    if (mem.eql(u8, cmd, supported_cmd)) break;
+                } else fatal("unsupported command in compile message: '{s}'", .{cmd});
+                next_compilation_args = args_bytes;
+                return;
+            },
             else => {
                 fatal("unrecognized message from client: 0x{x}", .{@intFromEnum(hdr.tag)});
             },
@@ -5065,12 +5148,16 @@ fn cmdBuild(gpa: Allocator, arena: Allocator, io: Io, args: []const []const u8)
     child_argv.items[argv_index_global_cache_dir] = dirs.global_cache.path orelse cwd_path;
     child_argv.items[argv_index_cache_dir] = dirs.local_cache.path orelse cwd_path;
 
+    var jobserver = try initJobserver(arena);
+    defer if (jobserver) |*js| js.deinit();
+
     var thread_pool: ThreadPool = undefined;
     try thread_pool.init(.{
         .allocator = gpa,
         .n_jobs = @min(@max(n_jobs orelse std.Thread.getCpuCount() catch 1, 1), std.math.maxInt(Zcu.PerThread.IdBacking)),
         .track_ids = true,
         .stack_size = thread_stack_size,
+        .jobserver = if (jobserver) |*js| js else null,
     });
     defer thread_pool.deinit();
 
@@ -5209,7 +5296,7 @@ fn cmdBuild(gpa: Allocator, arena: Allocator, io: Io, args: []const []const u8)
                 job_queue.thread_pool.spawnWg(&job_queue.wait_group, Package.Fetch.workerRun, .{
                     &fetch, "root",
                 });
-                job_queue.wait_group.wait();
+                job_queue.thread_pool.wait(&job_queue.wait_group);
 
                 try job_queue.consolidateErrors();
 
@@ -6546,6 +6633,13 @@ fn prefixedIntArg(arg: []const u8, prefix: []const u8) ?u64 {
     return std.fmt.parseUnsigned(u64, number, 0) catch |err| fatal("unable to parse '{s}': {t}", .{ arg, err });
 }
 
+/// Returns the jobserver advertised by the make or `zig build` process which
+/// spawned this one, if any, so that the thread pool stays within its limit.
+fn initJobserver(arena: Allocator) !?std.process.Jobserver {
+    const makeflags = try EnvVar.MAKEFLAGS.get(arena) orelse return null;
+    return std.process.Jobserver.initClient(makeflags);
+}
+
 fn warnAboutForeignBinaries(
     io: Io,
     arena: Allocator,
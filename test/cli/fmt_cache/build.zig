@@ -0,0 +1,91 @@
+const std = @import("std");
+const Step = std.Build.Step;
+
+pub fn build(b: *std.Build) void {
+    const test_step = b.step("test", "Test zig fmt --cache-dir");
+
+    // This test must use a temporary directory rather than a cache directory
+    // because zig fmt mutates the files.
+    const tmp_path = b.makeTempPath();
+    var dir = std.fs.cwd().openDir(tmp_path, .{}) catch @panic("unhandled");
+    defer dir.close();
+    for ([_][]const u8{ "fmt1.zig", "fmt2.zig", "fmt3.zig" }, 1..) |sub_path, i| {
+        dir.writeFile(.{ .sub_path = sub_path, .data = b.fmt("    const a = {d};", .{i}) }) catch @panic("unhandled");
+    }
+    const fmt_cache_path = b.pathJoin(&.{ tmp_path, "cache", "fmt" });
+
+    // Files are listed in the order they were given, not in the order in
+    // which the jobs happen to finish.
+    const run1 = addFmt(b, tmp_path, "format files");
+    run1.expectStdOutEqual("fmt3.zig\nfmt1.zig\nfmt2.zig\n");
+    const check1 = CheckEntryCount.create(b, fmt_cache_path, 3);
+    check1.step.dependOn(&run1.step);
+
+    // All files are recorded as formatted, so the second run skips them.
+    const run2 = addFmt(b, tmp_path, "format files again");
+    run2.expectStdOutEqual("");
+    run2.step.dependOn(&check1.step);
+    const check2 = CheckEntryCount.create(b, fmt_cache_path, 3);
+    check2.step.dependOn(&run2.step);
+
+    // A file which changed is formatted, and recorded in its new form.
+    const write = b.addUpdateSourceFiles();
+    write.addBytesToSource("    const a = 4;", b.pathJoin(&.{ tmp_path, "fmt1.zig" }));
+    write.step.dependOn(&check2.step);
+    const run3 = addFmt(b, tmp_path, "format changed file");
+    run3.expectStdOutEqual("fmt1.zig\n");
+    run3.step.dependOn(&write.step);
+    const check3 = CheckEntryCount.create(b, fmt_cache_path, 4);
+    check3.step.dependOn(&run3.step);
+
+    const cleanup = b.addRemoveDirTree(.{ .cwd_relative = tmp_path });
+    cleanup.step.dependOn(&check3.step);
+    test_step.dependOn(&cleanup.step);
+}
+
+fn addFmt(b: *std.Build, tmp_path: []const u8, name: []const u8) *Step.Run {
+    const run = b.addSystemCommand(&.{
+        b.graph.zig_exe, "fmt",      "-j3",      "--cache-dir", "cache",
+        "fmt3.zig",      "fmt1.zig", "fmt2.zig",
+    });
+    run.setName(name);
+    run.setCwd(.{ .cwd_relative = tmp_path });
+    run.has_side_effects = true;
+    return run;
+}
+
+/// Checks how many files zig fmt recorded as formatted.
+const CheckEntryCount = struct {
+    step: Step,
+    dir_path: []const u8,
+    expected: usize,
+
+    fn create(b: *std.Build, dir_path: []const u8, expected: usize) *CheckEntryCount {
+        const check = b.allocator.create(CheckEntryCount) catch @panic("OOM");
+        check.* = .{
+            .step = .init(.{
+                .id = .custom,
+                .name = b.fmt("check for {d} cache entries", .{expected}),
+                .owner = b,
+                .makeFn = make,
+            }),
+            .dir_path = dir_path,
+            .expected = expected,
+        };
+        return check;
+    }
+
+    fn make(step: *Step, options: Step.MakeOptions) !void {
+        _ = options;
+        const check: *CheckEntryCount = @fieldParentPtr("step", step);
+        var dir = std.fs.cwd().openDir(check.dir_path, .{ .iterate = true }) catch |err|
+            return step.fail("unable to open '{s}': {t}", .{ check.dir_path, err });
+        defer dir.close();
+        var count: usize = 0;
+        var it = dir.iterate();
+        while (try it.next()) |_| count += 1;
+        if (count != check.expected) {
+            return step.fail("expected {d} entries in '{s}', found {d}", .{ check.expected, check.dir_path, count });
+        }
+    }
+};
@@ -0,0 +1,49 @@
+const std = @import("std");
+const Step = std.Build.Step;
+
+pub fn build(b: *std.Build) void {
+    const main = b.addTest(.{ .root_module = b.createModule(.{
+        .root_source_file = b.path("src/main.zig"),
+        .target = b.graph.host,
+        .optimize = .Debug,
+    }) });
+    const run = b.addRunArtifact(main);
+
+    const check = b.allocator.create(CheckResults) catch @panic("OOM");
+    check.* = .{
+        .step = .init(.{
+            .id = .custom,
+            .name = "check test results",
+            .owner = b,
+            .makeFn = CheckResults.make,
+        }),
+        .run = run,
+        .test_count = b.option(u32, "test_count", "Expected number of tests run").?,
+        .skip_count = b.option(u32, "skip_count", "Expected number of tests skipped").?,
+    };
+    check.step.dependOn(&run.step);
+
+    const test_step = b.step("test", "Run unit tests");
+    test_step.dependOn(&check.step);
+}
+
+/// Checks the results which the test processes reported together.
+const CheckResults = struct {
+    step: Step,
+    run: *Step.Run,
+    test_count: u32,
+    skip_count: u32,
+
+    fn make(step: *Step, options: Step.MakeOptions) !void {
+        _ = options;
+        const check: *CheckResults = @fieldParentPtr("step", step);
+        const results = check.run.step.test_results;
+        if (results.test_count != check.test_count or results.skip_count != check.skip_count or
+            results.fail_count != 0)
+        {
+            return step.fail("expected {d} tests with {d} skipped, found {d} with {d} skipped and {d} failed", .{
+                check.test_count, check.skip_count, results.test_count, results.skip_count, results.fail_count,
+            });
+        }
+    }
+};
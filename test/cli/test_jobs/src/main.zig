@@ -0,0 +1,49 @@
+const std = @import("std");
+
+test "test 0" {
+    try std.testing.expect(std.math.isPowerOfTwo(@as(u32, 1) << 0));
+}
+
+test "test 1" {
+    return error.SkipZigTest;
+}
+
+test "test 2" {
+    try std.testing.expect(std.math.isPowerOfTwo(@as(u32, 1) << 2));
+}
+
+test "test 3" {
+    try std.testing.expect(std.math.isPowerOfTwo(@as(u32, 1) << 3));
+}
+
+test "test 4" {
+    return error.SkipZigTest;
+}
+
+test "test 5" {
+    try std.testing.expect(std.math.isPowerOfTwo(@as(u32, 1) << 5));
+}
+
+test "test 6" {
+    try std.testing.expect(std.math.isPowerOfTwo(@as(u32, 1) << 6));
+}
+
+test "test 7" {
+    try std.testing.expect(std.math.isPowerOfTwo(@as(u32, 1) << 7));
+}
+
+test "test 8" {
+    try std.testing.expect(std.math.isPowerOfTwo(@as(u32, 1) << 8));
+}
+
+test "test 9" {
+    try std.testing.expect(std.math.isPowerOfTwo(@as(u32, 1) << 9));
+}
+
+test "test 10" {
+    try std.testing.expect(std.math.isPowerOfTwo(@as(u32, 1) << 10));
+}
+
+test "test 11" {
+    try std.testing.expect(std.math.isPowerOfTwo(@as(u32, 1) << 11));
+}
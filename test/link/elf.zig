@@ -77,8 +77,10 @@ pub fn testAll(b: *Build, build_opts: BuildOptions) *Step {
         elf_step.dependOn(testLinkingCpp(b, .{ .target = musl_target }));
         elf_step.dependOn(testLinkingZig(b, .{ .target = musl_target }));
         elf_step.dependOn(testLinksection(b, .{ .target = musl_target }));
+        elf_step.dependOn(testMapFile(b, .{ .target = musl_target }));
         elf_step.dependOn(testMergeStrings(b, .{ .target = musl_target }));
         elf_step.dependOn(testMergeStrings2(b, .{ .target = musl_target }));
+        elf_step.dependOn(testMergeStringsTailMerge(b, .{ .target = musl_target, .optimize = .ReleaseFast }));
         // https://github.com/ziglang/zig/issues/17451
         // elf_step.dependOn(testNoEhFrameHdr(b, .{ .target = musl_target }));
         elf_step.dependOn(testTlsStatic(b, .{ .target = musl_target }));
@@ -2481,6 +2483,54 @@ fn testLinksection(b: *Build, opts: Options) *Step {
     return test_step;
 }
 
+fn testMapFile(b: *Build, opts: Options) *Step {
+    const test_step = addTestStep(b, "map-file", opts);
+
+    const wf = b.addWriteFiles();
+    const main_c = wf.add("main.c",
+        \\char big_array[1234];
+        \\const int table[100] = { 1 };
+        \\int main() {
+        \\  return big_array[0] + table[0] - 1;
+        \\}
+    );
+    const target = opts.target.query.zigTriple(b.allocator) catch @panic("OOM");
+
+    // The map file is requested directly on the command line since the build
+    // system has no option for it.
+    for ([_][]const u8{ "main.map", "main.map.json" }) |map_basename| {
+        const cmd = b.addSystemCommand(&.{
+            b.graph.zig_exe,
+            "build-exe",
+            "-target",
+            target,
+            "-O",
+            @tagName(opts.optimize),
+            "-lc",
+            if (opts.use_llvm) "-fllvm" else "-fno-llvm",
+            if (opts.use_lld) "-flld" else "-fno-lld",
+        });
+        cmd.addFileArg(main_c);
+        _ = cmd.addPrefixedOutputFileArg("-femit-bin=", "main");
+        cmd.addArg("-Map");
+        const map = cmd.addOutputFileArg(map_basename);
+
+        const expected: []const []const u8 = if (std.mem.endsWith(u8, map_basename, ".json")) &.{
+            "\"name\": \"big_array\"",
+            "\"size\": 1234",
+            "\"name\": \"table\"",
+            "\"size\": 400",
+        } else &.{
+            // Symbol lines list the address, the size in hex and the name.
+            std.fmt.comptimePrint(" {x:>16} {s:>5}                 big_array\n", .{ 1234, "" }),
+            std.fmt.comptimePrint(" {x:>16} {s:>5}                 table\n", .{ 400, "" }),
+        };
+        test_step.dependOn(&b.addCheckFile(map, .{ .expected_matches = expected }).step);
+    }
+
+    return test_step;
+}
+
 // Adapted from https://github.com/rui314/mold/blob/main/test/elf/mergeable-strings.sh
 fn testMergeStrings(b: *Build, opts: Options) *Step {
     const test_step = addTestStep(b, "merge-strings", opts);
@@ -2600,6 +2650,43 @@ fn testMergeStrings2(b: *Build, opts: Options) *Step {
     return test_step;
 }
 
+fn testMergeStringsTailMerge(b: *Build, opts: Options) *Step {
+    const test_step = addTestStep(b, "merge-strings-tail-merge", opts);
+
+    const obj1 = addObject(b, opts, .{ .name = "a.o" });
+    addCSourceBytes(obj1,
+        \\char *long1 = "foobar";
+        \\char *long2 = "xyzzy";
+    , &.{"-O2"});
+
+    const obj2 = addObject(b, opts, .{ .name = "b.o" });
+    addCSourceBytes(obj2,
+        \\extern char *long1;
+        \\extern char *long2;
+        \\char *short1 = "bar";
+        \\char *short2 = "zy";
+        \\char *short3 = "";
+        \\int main() {
+        \\  if (short1 != long1 + 3) return 1;
+        \\  if (short2 != long2 + 3) return 2;
+        \\  if (*short3 != 0) return 3;
+        \\  return 0;
+        \\}
+    , &.{"-O2"});
+    obj2.root_module.link_libc = true;
+
+    const exe = addExecutable(b, opts, .{ .name = "main" });
+    exe.root_module.addObject(obj1);
+    exe.root_module.addObject(obj2);
+    exe.root_module.link_libc = true;
+
+    const run = addRunArtifact(exe);
+    run.expectExitCode(0);
+    test_step.dependOn(&run.step);
+
+    return test_step;
+}
+
 fn testNoEhFrameHdr(b: *Build, opts: Options) *Step {
     const test_step = addTestStep(b, "no-eh-frame-hdr", opts);
 
@@ -25,4 +25,41 @@ pub fn build(b: *std.Build) void {
     const run_artifact = b.addRunArtifact(exe);
     run_artifact.addArg(b.cache_root.path orelse "");
     run_step.dependOn(&run_artifact.step);
+
+    const minimize_exe = b.addExecutable(.{
+        .name = "minimize",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("minimize.zig"),
+            .target = target,
+            .optimize = optimize,
+            .fuzz = true,
+        }),
+        .use_llvm = true, // #23423
+    });
+
+    b.installArtifact(minimize_exe);
+
+    const run_minimize = b.addRunArtifact(minimize_exe);
+    run_minimize.addArg(b.cache_root.path orelse "");
+    run_step.dependOn(&run_minimize.step);
+
+    // The test waits for a child of the fork server with `waitid`.
+    if (target.result.os.tag != .linux) return;
+
+    const fork_server_exe = b.addExecutable(.{
+        .name = "fork_server",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("fork_server.zig"),
+            .target = target,
+            .optimize = optimize,
+            .fuzz = true,
+        }),
+        .use_llvm = true, // #23423
+    });
+
+    b.installArtifact(fork_server_exe);
+
+    const run_fork_server = b.addRunArtifact(fork_server_exe);
+    run_fork_server.addArg(b.cache_root.path orelse "");
+    run_step.dependOn(&run_fork_server.step);
 }
@@ -0,0 +1,86 @@
+const std = @import("std");
+const abi = std.Build.abi.fuzz;
+const linux = std.os.linux;
+const posix = std.posix;
+
+/// Only ever changed in the fork server's children.
+var runs: usize = 0;
+
+/// The child which runs "exit after" sends its pid through this pipe.
+var pid_pipe: [2]posix.fd_t = undefined;
+/// A byte written to this pipe makes that child exit.
+var exit_pipe: [2]posix.fd_t = undefined;
+
+fn testOne(in: abi.Slice) callconv(.c) void {
+    runs += 1;
+    const input = in.toSlice();
+    if (std.mem.eql(u8, input, "crash")) std.process.exit(1);
+    if (std.mem.eql(u8, input, "exit after")) {
+        // The child finishes this input and then dies between inputs, so the
+        // fuzzer finds the request pipe closed when it sends the next one.
+        const pid: posix.pid_t = linux.getpid();
+        _ = posix.write(pid_pipe[1], std.mem.asBytes(&pid)) catch @panic("failed to send pid");
+        const thread = std.Thread.spawn(.{}, exitWhenTold, .{}) catch @panic("failed to spawn thread");
+        thread.detach();
+    }
+}
+
+fn exitWhenTold() void {
+    var byte: [1]u8 = undefined;
+    _ = posix.read(exit_pipe[0], &byte) catch {};
+    std.process.exit(2);
+}
+
+pub fn main() !void {
+    var args = std.process.args();
+    _ = args.skip(); // executable name
+    const cache_dir_path = args.next() orelse @panic("expected cache directory path argument");
+
+    const test_name = "fork server";
+    var cache_dir = try std.fs.cwd().openDir(cache_dir_path, .{});
+    defer cache_dir.close();
+    // Crashing inputs saved by previous runs would satisfy the checks below.
+    try cache_dir.deleteTree("f/" ++ test_name);
+
+    // The children of the fork server inherit both pipes.
+    pid_pipe = try posix.pipe();
+    exit_pipe = try posix.pipe();
+
+    abi.fuzzer_init(.fromSlice(cache_dir_path));
+    abi.fuzzer_init_test(testOne, .fromSlice(test_name), 0, true);
+    abi.fuzzer_new_input(.fromSlice("hello"));
+    abi.fuzzer_new_input(.fromSlice("exit after"));
+
+    // Wait for the child to exit without reaping it, so that the pipes of the
+    // fork server are closed before the next input is sent.
+    var pid: posix.pid_t = undefined;
+    if (try posix.read(pid_pipe[0], std.mem.asBytes(&pid)) != @sizeOf(posix.pid_t)) return error.MissingPid;
+    _ = try posix.write(exit_pipe[1], "x");
+    var info: linux.siginfo_t = undefined;
+    switch (linux.E.init(linux.waitid(.PID, pid, &info, linux.W.EXITED | linux.W.NOWAIT))) {
+        .SUCCESS => {},
+        else => |err| return posix.unexpectedErrno(err),
+    }
+
+    abi.fuzzer_new_input(.fromSlice("next"));
+    abi.fuzzer_new_input(.fromSlice("crash"));
+    abi.fuzzer_new_input(.fromSlice("after restart"));
+
+    if (runs != 0) return error.TestRanInFuzzer;
+
+    var corpus_dir = try cache_dir.openDir("f/" ++ test_name, .{});
+    defer corpus_dir.close();
+
+    // The inputs which were running when a child died are recorded, and the
+    // others did not crash, including the one sent to the dead child.
+    for ([_][]const u8{ "exit after", "crash" }) |input| {
+        var name_buf: [32]u8 = undefined;
+        const name = try std.fmt.bufPrint(&name_buf, "crash-{x}", .{std.hash.Wyhash.hash(0, input)});
+        try corpus_dir.access(name, .{});
+    }
+    for ([_][]const u8{ "hello", "next", "after restart" }) |input| {
+        var name_buf: [32]u8 = undefined;
+        const name = try std.fmt.bufPrint(&name_buf, "crash-{x}", .{std.hash.Wyhash.hash(0, input)});
+        if (corpus_dir.access(name, .{})) |_| return error.UnexpectedCrash else |_| {}
+    }
+}
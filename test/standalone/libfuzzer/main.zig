@@ -24,7 +24,7 @@ pub fn main() !void {
     defer cache_dir.close();
 
     abi.fuzzer_init(.fromSlice(cache_dir_path));
-    abi.fuzzer_init_test(testOne, .fromSlice("test"));
+    abi.fuzzer_init_test(testOne, .fromSlice("test"), 0, false);
     abi.fuzzer_new_input(.fromSlice(""));
     abi.fuzzer_new_input(.fromSlice("hello"));
 
@@ -0,0 +1,77 @@
+const std = @import("std");
+const abi = std.Build.abi.fuzz;
+
+var hits: [2]usize = .{ 0, 0 };
+
+fn testOne(in: abi.Slice) callconv(.c) void {
+    const input = in.toSlice();
+    if (input.len != 0 and input[0] == 'a') hitA() else hitB();
+}
+
+noinline fn hitA() void {
+    hits[0] += 1;
+}
+
+noinline fn hitB() void {
+    hits[1] += 1;
+}
+
+pub fn main() !void {
+    var args = std.process.args();
+    _ = args.skip(); // executable name
+    const cache_dir_path = args.next() orelse @panic("expected cache directory path argument");
+
+    const test_name = "minimize";
+    var cache_dir = try std.fs.cwd().openDir(cache_dir_path, .{});
+    defer cache_dir.close();
+    try cache_dir.deleteTree("f/" ++ test_name);
+    var corpus_dir = try cache_dir.makeOpenPath("f/" ++ test_name, .{});
+    defer corpus_dir.close();
+
+    // The longer inputs hit nothing the shorter ones do not.
+    const corpus = [_][]const u8{ "aaaa", "bbbb", "a", "b" };
+    for (corpus, 0..) |input, index| {
+        var name_buf: [8]u8 = undefined;
+        const name = try std.fmt.bufPrint(&name_buf, "{x}", .{index});
+        try corpus_dir.writeFile(.{ .sub_path = name, .data = input });
+    }
+    // Left behind by an interrupted minimization.
+    try corpus_dir.writeFile(.{ .sub_path = "cmin1", .data = "stale" });
+
+    // The build runner starts a process per instance.
+    const instance_count = 2;
+    abi.fuzzer_init(.fromSlice(cache_dir_path));
+    for (0..instance_count) |instance_id| {
+        abi.fuzzer_minimize_corpus(testOne, .fromSlice(test_name), @intCast(instance_id), instance_count);
+    }
+    if (hits[0] != 2 or hits[1] != 2) return error.CorpusNotReplayed;
+
+    var best: ?[]abi.MinimizeEntry = null;
+    for (0..instance_count) |instance_id| {
+        var name_buf: [16]u8 = undefined;
+        const name = try std.fmt.bufPrint(&name_buf, "cmin{d}", .{instance_id});
+        const bytes = try corpus_dir.readFileAllocOptions(name, std.heap.page_allocator, .unlimited, .of(abi.MinimizeEntry), null);
+        if (bytes.len % @sizeOf(abi.MinimizeEntry) != 0) return error.InvalidMinimizeTable;
+        const table = std.mem.bytesAsSlice(abi.MinimizeEntry, bytes);
+        const b = best orelse {
+            best = table;
+            continue;
+        };
+        if (table.len != b.len) return error.InvalidMinimizeTable;
+        for (b, table) |*entry, other| {
+            if (@as(u64, @bitCast(other)) < @as(u64, @bitCast(entry.*))) entry.* = other;
+        }
+    }
+
+    // Only the shortest input down each path is selected.
+    var kept: [corpus.len]bool = @splat(false);
+    for (best.?) |entry| {
+        if (entry == abi.MinimizeEntry.none) continue;
+        if (entry.len != corpus[entry.index].len) return error.WrongInputLength;
+        kept[entry.index] = true;
+    }
+    if (!std.mem.eql(bool, &kept, &.{ false, false, true, true })) {
+        std.debug.print("kept: {any}\n", .{kept});
+        return error.TestFailed;
+    }
+}
@@ -0,0 +1,39 @@
+const std = @import("std");
+
+/// Builds two executables one after the other, so that the build runner hands
+/// the idle compiler process of the first one to the second. Both emit
+/// assembly, which sets process-wide LLVM options when LLVM is used.
+pub fn build(b: *std.Build) void {
+    const test_step = b.step("test", "Test it");
+    b.default_step = test_step;
+
+    const optimize = b.standardOptimizeOption(.{});
+    const wf = b.addWriteFiles();
+
+    var previous: ?*std.Build.Step = null;
+    for ([_][]const u8{ "first", "second" }) |name| {
+        const exe = b.addExecutable(.{
+            .name = name,
+            .root_module = b.createModule(.{
+                .root_source_file = wf.add(b.fmt("{s}.zig", .{name}), b.fmt(
+                    \\const std = @import("std");
+                    \\
+                    \\pub fn main() !void {{
+                    \\    var stdout_writer = std.fs.File.stdout().writerStreaming(&.{{}});
+                    \\    try stdout_writer.interface.writeAll("{s}\n");
+                    \\}}
+                    \\
+                , .{name})),
+                .target = b.graph.host,
+                .optimize = optimize,
+            }),
+        });
+        _ = exe.getEmittedAsm();
+        if (previous) |step| exe.step.dependOn(step);
+        previous = &exe.step;
+
+        const run = b.addRunArtifact(exe);
+        run.expectStdOutEqual(b.fmt("{s}\n", .{name}));
+        test_step.dependOn(&run.step);
+    }
+}
@@ -0,0 +1,37 @@
+const std = @import("std");
+
+/// Checks that `-gsplit-dwarf` leaves a `.dwo` file next to the cached C object,
+/// and that the path the object refers to it by leads there.
+pub fn build(b: *std.Build) void {
+    const test_step = b.step("test", "Test it");
+    b.default_step = test_step;
+
+    const target = b.resolveTargetQuery(.{ .cpu_arch = .x86_64, .os_tag = .linux });
+
+    const obj = b.addObject(.{
+        .name = "probe",
+        .root_module = b.createModule(.{
+            .root_source_file = null,
+            .optimize = .Debug,
+            .target = target,
+        }),
+    });
+    obj.root_module.addCSourceFile(.{ .file = b.path("probe.c"), .flags = &.{} });
+    obj.split_dwarf = true;
+
+    const check = b.addExecutable(.{
+        .name = "check",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("check.zig"),
+            .optimize = .Debug,
+            .target = b.graph.host,
+        }),
+    });
+
+    const run = b.addRunArtifact(check);
+    run.addFileArg(obj.getEmittedBin());
+    run.addArg("probe.dwo");
+    run.expectExitCode(0);
+
+    test_step.dependOn(&run.step);
+}
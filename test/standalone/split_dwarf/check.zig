@@ -0,0 +1,211 @@
+const std = @import("std");
+const elf = std.elf;
+const AT = std.dwarf.AT;
+const FORM = std.dwarf.FORM;
+
+pub fn main() !void {
+    var arena_instance = std.heap.ArenaAllocator.init(std.heap.page_allocator);
+    defer arena_instance.deinit();
+    const arena = arena_instance.allocator();
+
+    const args = try std.process.argsAlloc(arena);
+    const obj_path = args[1];
+    const dwo_basename = args[2];
+
+    // The skeleton unit in the object names the `.dwo` file, which a debugger resolves
+    // against the compilation directory.
+    const obj_bytes = try std.fs.cwd().readFileAlloc(obj_path, arena, .unlimited);
+    const obj: Object = try .parse(obj_bytes);
+    const skeleton = try obj.readSkeleton(arena);
+    const dwo_path = try std.fs.path.resolve(arena, &.{ skeleton.comp_dir, skeleton.dwo_name });
+    if (!std.mem.eql(u8, std.fs.path.basename(dwo_path), dwo_basename)) {
+        std.debug.print("'{s}' refers to '{s}', expected '{s}'\n", .{ obj_path, dwo_path, dwo_basename });
+        return error.TestFailed;
+    }
+
+    // The `.dwo` file itself is kept next to the object in the cache.
+    const dwo_bytes = std.fs.cwd().readFileAlloc(dwo_path, arena, .unlimited) catch |err| {
+        std.debug.print("unable to read '{s}' referred to by '{s}': {t}\n", .{ dwo_path, obj_path, err });
+        return error.TestFailed;
+    };
+    if (!std.mem.startsWith(u8, dwo_bytes, elf.MAGIC)) return error.TestFailed;
+    if (std.mem.indexOf(u8, dwo_bytes, ".debug_info.dwo") == null) return error.TestFailed;
+}
+
+/// Just enough of a little-endian ELF64 relocatable object to read its first compile unit.
+const Object = struct {
+    bytes: []const u8,
+    shdrs: []align(1) const elf.Elf64_Shdr,
+    shstrtab: []const u8,
+
+    fn parse(bytes: []const u8) !Object {
+        if (!std.mem.startsWith(u8, bytes, elf.MAGIC)) return error.NotElf;
+        const ehdr = std.mem.bytesAsValue(elf.Elf64_Ehdr, bytes[0..@sizeOf(elf.Elf64_Ehdr)]);
+        const shdrs = std.mem.bytesAsSlice(
+            elf.Elf64_Shdr,
+            bytes[ehdr.e_shoff..][0 .. @as(usize, ehdr.e_shnum) * @sizeOf(elf.Elf64_Shdr)],
+        );
+        const shstrtab = shdrs[ehdr.e_shstrndx];
+        return .{
+            .bytes = bytes,
+            .shdrs = shdrs,
+            .shstrtab = bytes[shstrtab.sh_offset..][0..shstrtab.sh_size],
+        };
+    }
+
+    /// Returns the contents of the section `name` with the relocations against it applied, as
+    /// the linker would, since the offsets into other debug sections are only known then.
+    fn section(obj: Object, arena: std.mem.Allocator, name: []const u8) ![]u8 {
+        const index = for (obj.shdrs, 0..) |shdr, i| {
+            if (std.mem.eql(u8, std.mem.sliceTo(obj.shstrtab[shdr.sh_name..], 0), name)) break i;
+        } else {
+            std.debug.print("no section '{s}'\n", .{name});
+            return error.TestFailed;
+        };
+        const shdr = obj.shdrs[index];
+        const data = try arena.dupe(u8, obj.bytes[shdr.sh_offset..][0..shdr.sh_size]);
+        for (obj.shdrs) |rela_shdr| {
+            if (rela_shdr.sh_type != elf.SHT_RELA or rela_shdr.sh_info != index) continue;
+            const symtab = obj.shdrs[rela_shdr.sh_link];
+            const syms = std.mem.bytesAsSlice(elf.Elf64_Sym, obj.bytes[symtab.sh_offset..][0..symtab.sh_size]);
+            const relas = std.mem.bytesAsSlice(elf.Elf64_Rela, obj.bytes[rela_shdr.sh_offset..][0..rela_shdr.sh_size]);
+            for (relas) |rela| {
+                const value = syms[rela.r_sym()].st_value +% @as(u64, @bitCast(rela.r_addend));
+                switch (@as(elf.R_X86_64, @enumFromInt(rela.r_type()))) {
+                    .@"32" => std.mem.writeInt(u32, data[rela.r_offset..][0..4], @truncate(value), .little),
+                    .@"64" => std.mem.writeInt(u64, data[rela.r_offset..][0..8], value, .little),
+                    else => {},
+                }
+            }
+        }
+        return data;
+    }
+
+    /// A string attribute value, by the form it was encoded in.
+    const String = union(enum) {
+        bytes: []const u8,
+        strp: u64,
+        line_strp: u64,
+        strx: u64,
+    };
+
+    const Skeleton = struct {
+        comp_dir: []const u8,
+        dwo_name: []const u8,
+    };
+
+    /// Reads the compilation directory and `.dwo` file name of the first unit, which is the
+    /// skeleton unit of the only compile unit in the object.
+    fn readSkeleton(obj: Object, arena: std.mem.Allocator) !Skeleton {
+        var info: std.Io.Reader = .fixed(try obj.section(arena, ".debug_info"));
+        var is_64 = false;
+        if (try info.takeInt(u32, .little) == 0xffffffff) {
+            is_64 = true;
+            _ = try info.takeInt(u64, .little);
+        }
+        const abbrev_offset = switch (try info.takeInt(u16, .little)) {
+            4 => offset: {
+                const offset = try takeOffset(&info, is_64);
+                _ = try info.takeByte(); // address_size
+                break :offset offset;
+            },
+            5 => offset: {
+                const unit_type = try info.takeByte();
+                _ = try info.takeByte(); // address_size
+                const offset = try takeOffset(&info, is_64);
+                if (unit_type == std.dwarf.UT.skeleton) _ = try info.takeInt(u64, .little); // dwo_id
+                break :offset offset;
+            },
+            else => return error.UnsupportedDwarfVersion,
+        };
+        const code = try info.takeLeb128(u64);
+
+        var abbrev: std.Io.Reader = .fixed((try obj.section(arena, ".debug_abbrev"))[abbrev_offset..]);
+        while (true) {
+            const abbrev_code = try abbrev.takeLeb128(u64);
+            if (abbrev_code == 0) return error.MissingAbbrev;
+            _ = try abbrev.takeLeb128(u64); // tag
+            _ = try abbrev.takeByte(); // children
+            if (abbrev_code == code) break;
+            while (true) {
+                const at = try abbrev.takeLeb128(u64);
+                const form = try abbrev.takeLeb128(u64);
+                if (form == FORM.implicit_const) _ = try abbrev.takeLeb128(i64);
+                if (at == 0 and form == 0) break;
+            }
+        }
+
+        var comp_dir: ?String = null;
+        var dwo_name: ?String = null;
+        var str_offsets_base: ?u64 = null;
+        while (true) {
+            const at = try abbrev.takeLeb128(u64);
+            const form = try abbrev.takeLeb128(u64);
+            if (at == 0 and form == 0) break;
+            var string: ?String = null;
+            var offset: ?u64 = null;
+            switch (form) {
+                FORM.string => string = .{ .bytes = try info.takeSentinel(0) },
+                FORM.strp => string = .{ .strp = try takeOffset(&info, is_64) },
+                FORM.line_strp => string = .{ .line_strp = try takeOffset(&info, is_64) },
+                FORM.strx => string = .{ .strx = try info.takeLeb128(u64) },
+                FORM.strx1 => string = .{ .strx = try info.takeInt(u8, .little) },
+                FORM.strx2 => string = .{ .strx = try info.takeInt(u16, .little) },
+                FORM.strx3 => string = .{ .strx = try info.takeInt(u24, .little) },
+                FORM.strx4 => string = .{ .strx = try info.takeInt(u32, .little) },
+                FORM.sec_offset => offset = try takeOffset(&info, is_64),
+                FORM.flag_present => {},
+                FORM.implicit_const => _ = try abbrev.takeLeb128(i64),
+                FORM.data1, FORM.flag, FORM.ref1, FORM.addrx1 => try info.discardAll(1),
+                FORM.data2, FORM.ref2, FORM.addrx2 => try info.discardAll(2),
+                FORM.addrx3 => try info.discardAll(3),
+                FORM.data4, FORM.ref4, FORM.addrx4 => try info.discardAll(4),
+                FORM.addr, FORM.data8, FORM.ref8 => try info.discardAll(8),
+                FORM.data16 => try info.discardAll(16),
+                FORM.udata, FORM.ref_udata, FORM.addrx, FORM.GNU_addr_index => _ = try info.takeLeb128(u64),
+                FORM.sdata => _ = try info.takeLeb128(i64),
+                else => return error.UnsupportedForm,
+            }
+            switch (at) {
+                AT.comp_dir => comp_dir = string,
+                AT.dwo_name, AT.GNU_dwo_name => dwo_name = string,
+                AT.str_offsets_base => str_offsets_base = offset,
+                else => {},
+            }
+        }
+
+        var strings: Strings = .{ .obj = obj, .arena = arena, .is_64 = is_64, .str_offsets_base = str_offsets_base };
+        return .{
+            .comp_dir = try strings.get(comp_dir orelse return error.MissingCompDir),
+            .dwo_name = try strings.get(dwo_name orelse return error.MissingDwoName),
+        };
+    }
+
+    const Strings = struct {
+        obj: Object,
+        arena: std.mem.Allocator,
+        is_64: bool,
+        str_offsets_base: ?u64,
+
+        fn get(strings: *Strings, string: String) ![]const u8 {
+            const section_name, const offset = switch (string) {
+                .bytes => |bytes| return bytes,
+                .strp => |offset| .{ ".debug_str", offset },
+                .line_strp => |offset| .{ ".debug_line_str", offset },
+                .strx => |index| offset: {
+                    const base = strings.str_offsets_base orelse return error.MissingStrOffsetsBase;
+                    const offsets = try strings.obj.section(strings.arena, ".debug_str_offsets");
+                    var r: std.Io.Reader = .fixed(offsets[base..]);
+                    try r.discardAll(@intCast(index * @as(u64, if (strings.is_64) 8 else 4)));
+                    break :offset .{ ".debug_str", try takeOffset(&r, strings.is_64) };
+                },
+            };
+            const bytes = try strings.obj.section(strings.arena, section_name);
+            return std.mem.sliceTo(bytes[offset..], 0);
+        }
+    };
+
+    fn takeOffset(r: *std.Io.Reader, is_64: bool) !u64 {
+        return if (is_64) try r.takeInt(u64, .little) else try r.takeInt(u32, .little);
+    }
+};
@@ -2196,6 +2196,21 @@ pub fn addCliTests(b: *std.Build) *Step {
         step.dependOn(&cleanup.step);
     }
 
+    {
+        // Test `zig fmt --cache-dir` with several jobs.
+        const tmp_path = b.makeTempPath();
+        const run_test = b.addSystemCommand(&.{ b.graph.zig_exe, "build", "test" });
+        run_test.addArg("--build-file");
+        run_test.addFileArg(b.path("test/cli/fmt_cache/build.zig"));
+        run_test.addArgs(&.{ "--cache-dir", tmp_path });
+        run_test.setName("test zig fmt --cache-dir");
+
+        const cleanup = b.addRemoveDirTree(.{ .cwd_relative = tmp_path });
+        cleanup.step.dependOn(&run_test.step);
+
+        step.dependOn(&cleanup.step);
+    }
+
     {
         const run_test = b.addSystemCommand(&.{
             b.graph.zig_exe,
@@ -2216,6 +2231,30 @@ pub fn addCliTests(b: *std.Build) *Step {
         step.dependOn(&run_test.step);
     }
 
+    // Test running the tests of one binary in several processes, with and without sharding.
+    for ([_]struct { ?[]const u8, u32, u32 }{
+        .{ null, 12, 2 },
+        .{ "--test-shard=2/3", 4, 2 },
+    }) |case| {
+        const shard_arg, const test_count, const skip_count = case;
+        const tmp_path = b.makeTempPath();
+        const run_test = b.addSystemCommand(&.{ b.graph.zig_exe, "build", "test", "--test-jobs", "3" });
+        if (shard_arg) |arg| run_test.addArg(arg);
+        run_test.addArgs(&.{
+            b.fmt("-Dtest_count={d}", .{test_count}),
+            b.fmt("-Dskip_count={d}", .{skip_count}),
+        });
+        run_test.addArg("--build-file");
+        run_test.addFileArg(b.path("test/cli/test_jobs/build.zig"));
+        run_test.addArgs(&.{ "--cache-dir", tmp_path });
+        run_test.setName(b.fmt("test --test-jobs {s}", .{shard_arg orelse ""}));
+
+        const cleanup = b.addRemoveDirTree(.{ .cwd_relative = tmp_path });
+        cleanup.step.dependOn(&run_test.step);
+
+        step.dependOn(&cleanup.step);
+    }
+
     return step;
 }
 